@@ -91,17 +91,15 @@ void ReadConfig()
 	}
 }
 
-void timer_callback1(int sig, siginfo_t *si, void *uc)
+void timer_callback1(const struct TIMER_EVENT_S* const p_event)
 {
-	int number = *(int*) si->si_value.sival_ptr;
-	APPLOG_Log(__FUNCTION__, LOGLV_INFO, "Timer went off. Set new timer counting from: %d", number);
-	TIMER_SetTime(p_timer_id1, number);
+	int number = *(const int*) p_event->p_params;
+	APPLOG_Log(__FUNCTION__, LOGLV_INFO, "Timer went off, next in %d s, %u overruns", number, p_event->overruns);
 }
-void timer_callback2(int sig, siginfo_t *si, void *uc)
+void timer_callback2(const struct TIMER_EVENT_S* const p_event)
 {
-	int number = *(int*) si->si_value.sival_ptr;
-	APPLOG_Log(__FUNCTION__, LOGLV_INFO, "Timer went off. Set new timer counting from: %d", number);
-	TIMER_SetTime(p_timer_id2, number);
+	int number = *(const int*) p_event->p_params;
+	APPLOG_Log(__FUNCTION__, LOGLV_INFO, "Timer went off, next in %d s, %u overruns", number, p_event->overruns);
 }
 /**
  * @brief The main function
@@ -121,10 +119,14 @@ int main(int argc, const char **argv)
 
 	signal(SIGINT, IGAPP_Term);
 
+	APPLOG_SetMode(APPLOG_MODE_ASYNC);
+
 	if ( !APPLOG_Init()) {
 		printf("%s: Couldn't initialize log component => Quit.", fn);
 		rv = -2;
 	} else {
+		APPLOG_LoadConfig("config.cfg");
+		APPLOG_WatchConfig("config.cfg");
 		char* version = APPVER_GetSoftwareVersion();
 		APPLOG_Log( fn, LOGLV_INFO, "Start APP with pid %d and software version %s", getpid(), version);
 		free(version);
@@ -132,12 +134,12 @@ int main(int argc, const char **argv)
 
 	// Timer create
 	TIMER_Init();
-	p_timer_id1 = malloc(sizeof(timer_t));
-	p_timer_id2 = malloc(sizeof(timer_t));
 	int p_param1 = 4;
 	int p_param2 = 5;
-	TIMER_CreateTimer(&p_timer_id1, 2, &p_param1, &timer_callback1);
-	TIMER_CreateTimer(&p_timer_id2, 2, &p_param2, &timer_callback2);
+	TIMER_CreateTimer(&p_timer_id1, 0, &p_param1, &timer_callback1);
+	TIMER_CreateTimer(&p_timer_id2, 0, &p_param2, &timer_callback2);
+	TIMER_SetPeriodicTime(p_timer_id1, 2, p_param1);
+	TIMER_SetPeriodicTime(p_timer_id2, 2, p_param2);
 
 	//starting threads here ...
 	APPLOG_LogDebug( fn, LOGBIT_DEBUG, "debugmessage");
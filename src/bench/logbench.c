@@ -0,0 +1,438 @@
+/**
+ * @file logbench.c
+ * @brief multi-threaded throughput and latency benchmark of the logger
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * Drives APPLOG_Log and APPLOG_LogDebug from 1, 2, 4 .. N threads for
+ * filtered out and emitted records, for every destination (console,
+ * /dev/null, memory-mapped log file, memory output). Every call is timed on
+ * its own; the report holds the messages per second, the p50/p99/p99.9 call
+ * latency and the records lost to the backpressure policy (-p).
+ */
+
+/* -------------------------------------------------------------------------
+ * include section
+ * -------------------------------------------------------------------------*/
+
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* project specific includes - if possible alphabetically ordered */
+#include "../common/argparse.h"
+#include "../common/log.h"
+
+/* module specific includes - if possible alphabetically ordered */
+
+/**
+ * @brief Default maximum number of threads
+ */
+#define LOGBENCH_DEFAULT_THREADS (4)
+
+/**
+ * @brief Default number of messages per thread
+ */
+#define LOGBENCH_DEFAULT_MSGS (100000)
+
+/**
+ * @brief The log file of the file destination
+ */
+#define LOGBENCH_FILE "logbench.log"
+
+/**
+ * @brief Lines kept by the memory destination
+ */
+#define LOGBENCH_MEMORY_RECORDS (4096)
+
+/**
+ * @brief Size of a destination list copy
+ */
+#define LOGBENCH_LIST_SIZE (64)
+
+static const char* const usages[] = {
+	"logbench [options]",
+	NULL
+};
+
+/**
+ * @brief The measured workloads
+ */
+enum LOGBENCH_WORKLOAD_E {
+	LOGBENCH_LOG_FILTERED = 0,  /**< APPLOG_Log, level disabled */
+	LOGBENCH_DEBUG_FILTERED,    /**< APPLOG_LogDebug, bit disabled */
+	LOGBENCH_LOG_EMITTED,       /**< APPLOG_Log, level enabled */
+	LOGBENCH_DEBUG_EMITTED,     /**< APPLOG_LogDebug, bit enabled */
+	LOGBENCH_WORKLOAD_SENTINEL  /**< DO NOT USE */
+};
+
+/**
+ * @brief The output destinations
+ */
+enum LOGBENCH_DEST_E {
+	LOGBENCH_DEST_STDOUT = 0,   /**< the console */
+	LOGBENCH_DEST_NULL,         /**< the console, redirected to /dev/null */
+	LOGBENCH_DEST_FILE,         /**< the memory-mapped log file */
+	LOGBENCH_DEST_MEMORY,       /**< the memory output, console off */
+	LOGBENCH_DEST_SENTINEL      /**< DO NOT USE */
+};
+
+/**
+ * @brief The work of one thread
+ */
+struct LOGBENCH_THREAD_S {
+	pthread_t thread;                    /**< The thread */
+	enum LOGBENCH_WORKLOAD_E workload;   /**< What to call */
+	uint32_t msgs;                       /**< Number of calls */
+	uint32_t* p_lat;                     /**< Latency of every call (ns) */
+	pthread_barrier_t* p_barrier;        /**< Common start */
+	struct timespec start;               /**< Start of the first call */
+	struct timespec end;                 /**< End of the last call */
+};
+
+/**
+ * @brief The result of one scenario
+ */
+struct LOGBENCH_RESULT_S {
+	double msgs_per_s;   /**< Throughput over all threads */
+	uint32_t p50;        /**< Median call latency (ns) */
+	uint32_t p99;        /**< 99th percentile call latency (ns) */
+	uint32_t p999;       /**< 99.9th percentile call latency (ns) */
+	uint64_t lost;       /**< Records dropped or overwritten */
+};
+
+static const char* const LOGBENCH_workload_names[LOGBENCH_WORKLOAD_SENTINEL] = {
+	"log filtered", "debug filtered", "log emitted", "debug emitted"
+};
+
+static const char* const LOGBENCH_dest_names[LOGBENCH_DEST_SENTINEL] = {
+	"stdout", "null", "file", "memory"
+};
+
+static const char* const LOGBENCH_mode_names[APPLOG_MODE_SENTINEL] = {
+	"sync", "async", "deferred"
+};
+
+static const char* const LOGBENCH_policy_names[APPLOG_BACKPRESSURE_SENTINEL] = {
+	"block", "timed", "drop", "overwrite"
+};
+
+/**
+ * @brief The backpressure policy of every scenario
+ */
+static enum APPLOG_BACKPRESSURE_E LOGBENCH_policy = APPLOG_BACKPRESSURE_BLOCK;
+
+/**
+ * @brief Run one scenario
+ * @param[in] mode the log mode
+ * @param[in] dest the destination
+ * @param[in] workload the workload
+ * @param[in] threads the number of threads
+ * @param[in] msgs the number of messages per thread
+ * @param[out] p_result the measurement
+ * @return true on success, false otherwise
+ */
+static bool LOGBENCH_Run(const enum APPLOG_MODE_E mode, const enum LOGBENCH_DEST_E dest,
+		const enum LOGBENCH_WORKLOAD_E workload, const uint32_t threads, const uint32_t msgs,
+		struct LOGBENCH_RESULT_S* const p_result);
+
+/**
+ * @brief The body of a measuring thread
+ * @param[in] p_arg the LOGBENCH_THREAD_S
+ * @return NULL
+ */
+static void* LOGBENCH_Thread(void* p_arg);
+
+/**
+ * @brief Remove the log file of the file destination and its segments
+ */
+static void LOGBENCH_RemoveFiles(void);
+
+/**
+ * @brief qsort comparison of two latencies
+ * @param[in] p_a the first latency
+ * @param[in] p_b the second latency
+ * @return <0, 0 or >0
+ */
+static int LOGBENCH_Compare(const void* p_a, const void* p_b);
+
+/**
+ * @brief Nanoseconds between two timestamps
+ * @param[in] p_start the start
+ * @param[in] p_end the end
+ * @return the difference in ns
+ */
+static int64_t LOGBENCH_Diff(const struct timespec* const p_start, const struct timespec* const p_end);
+
+/**
+ * @brief The main function
+ * @param[in] argc the number of command-line arguments
+ * @param[in] argv the pointer to the arguments string collection
+ * @return 0 on success, other values if failure
+ */
+int main(int argc, const char **argv)
+{
+	const char* mode_name = "sync";
+	const char* policy_name = "block";
+	const char* dest_list = "null,file";
+	char list[LOGBENCH_LIST_SIZE];
+	bool dests[LOGBENCH_DEST_SENTINEL] = { false };
+	struct LOGBENCH_RESULT_S result;
+	int max_threads = LOGBENCH_DEFAULT_THREADS;
+	int msgs = LOGBENCH_DEFAULT_MSGS;
+	int mode = APPLOG_MODE_SENTINEL;
+	int policy = APPLOG_BACKPRESSURE_SENTINEL;
+	int saved_stdout;
+	int null_fd;
+	char* p_save;
+	char* p_tok;
+	uint32_t threads;
+	int dest;
+	int workload;
+	int i;
+	int rv = 0;
+
+	struct argparse_option options[] = {
+		OPT_HELP(),
+		OPT_GROUP("Optional arguments"),
+		OPT_INTEGER('t', "threads", &max_threads, "maximum number of threads (1, 2, 4 .. threads)", NULL, 0, 0),
+		OPT_INTEGER('n', "msgs", &msgs, "number of messages per thread", NULL, 0, 0),
+		OPT_STRING('m', "mode", &mode_name, "log mode: sync, async or deferred", NULL, 0, 0),
+		OPT_STRING('d', "dest", &dest_list, "comma separated destinations: stdout, null, file, memory", NULL, 0, 0),
+		OPT_STRING('p', "policy", &policy_name, "backpressure policy: block, timed, drop or overwrite", NULL, 0, 0),
+		OPT_END(),
+	};
+	struct argparse argparse;
+	argparse_init(&argparse, options, usages, 0);
+	argparse_describe(&argparse, "\nMeasure the throughput and the call latency of the logger.",
+		"\nThe report is written to stderr.");
+	argc = argparse_parse(&argparse, argc, argv);
+
+	for (i = 0; i < APPLOG_MODE_SENTINEL; i++) {
+		if (0 == strcmp(mode_name, LOGBENCH_mode_names[i])) {
+			mode = i;
+		}
+	}
+	for (i = 0; i < APPLOG_BACKPRESSURE_SENTINEL; i++) {
+		if (0 == strcmp(policy_name, LOGBENCH_policy_names[i])) {
+			policy = i;
+		}
+	}
+	snprintf(list, sizeof(list), "%s", dest_list);
+	for (p_tok = strtok_r(list, ",", &p_save); NULL != p_tok; p_tok = strtok_r(NULL, ",", &p_save)) {
+		for (dest = 0; dest < LOGBENCH_DEST_SENTINEL; dest++) {
+			if (0 == strcmp(p_tok, LOGBENCH_dest_names[dest])) {
+				dests[dest] = true;
+				break;
+			}
+		}
+		if (LOGBENCH_DEST_SENTINEL == dest) {
+			fprintf(stderr, "Unknown destination: %s\n", p_tok);
+			rv = -1;
+		}
+	}
+
+	if ((0 != rv) || (0 >= max_threads) || (0 >= msgs) || (APPLOG_MODE_SENTINEL == mode)
+			|| (APPLOG_BACKPRESSURE_SENTINEL == policy)) {
+		argparse_usage(&argparse);
+		rv = -1;
+	} else {
+		LOGBENCH_policy = policy;
+		fprintf(stderr, "mode %s, policy %s, %d messages per thread\n",
+				LOGBENCH_mode_names[mode], LOGBENCH_policy_names[policy], msgs);
+		fprintf(stderr, "%-7s %-15s %7s %12s %8s %8s %8s %8s\n",
+				"dest", "workload", "threads", "msgs/s", "p50 ns", "p99 ns", "p99.9 ns", "lost");
+
+		for (dest = 0; (dest < LOGBENCH_DEST_SENTINEL) && (0 == rv); dest++) {
+			if (!dests[dest]) {
+				continue;
+			}
+			saved_stdout = -1;
+			if (LOGBENCH_DEST_NULL == dest) {
+				fflush(stdout);
+				saved_stdout = dup(STDOUT_FILENO);
+				null_fd = open("/dev/null", O_WRONLY);
+				if ((0 > saved_stdout) || (0 > null_fd) || (0 > dup2(null_fd, STDOUT_FILENO))) {
+					fprintf(stderr, "Couldn't redirect stdout\n");
+					rv = -1;
+				}
+				if (0 <= null_fd) {
+					close(null_fd);
+				}
+			}
+
+			for (workload = 0; (workload < LOGBENCH_WORKLOAD_SENTINEL) && (0 == rv); workload++) {
+				for (threads = 1; (threads <= (uint32_t)max_threads) && (0 == rv); threads *= 2) {
+					if (!LOGBENCH_Run(mode, dest, workload, threads, msgs, &result)) {
+						rv = -1;
+					} else {
+						fprintf(stderr, "%-7s %-15s %7u %12.0f %8u %8u %8u %8llu\n",
+								LOGBENCH_dest_names[dest], LOGBENCH_workload_names[workload], threads,
+								result.msgs_per_s, result.p50, result.p99, result.p999,
+								(unsigned long long)result.lost);
+					}
+				}
+			}
+
+			if (0 <= saved_stdout) {
+				fflush(stdout);
+				dup2(saved_stdout, STDOUT_FILENO);
+				close(saved_stdout);
+			}
+		}
+	}
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static bool LOGBENCH_Run(const enum APPLOG_MODE_E mode, const enum LOGBENCH_DEST_E dest,
+		const enum LOGBENCH_WORKLOAD_E workload, const uint32_t threads, const uint32_t msgs,
+		struct LOGBENCH_RESULT_S* const p_result)
+{
+	struct LOGBENCH_THREAD_S* p_threads = NULL;
+	struct APPLOG_COUNTERS_S counters;
+	pthread_barrier_t barrier;
+	uint32_t* p_lat = NULL;
+	int64_t wall = 0;
+	size_t total = (size_t)threads * msgs;
+	uint32_t i;
+	bool rv = false;
+
+	if ((NULL == (p_lat = malloc(total * sizeof(*p_lat))))
+			|| (NULL == (p_threads = calloc(threads, sizeof(*p_threads))))) {
+		fprintf(stderr, "Out of memory\n");
+	} else if (!APPLOG_SetMode(mode) || !APPLOG_Init()) {
+		fprintf(stderr, "Couldn't initialize the log component\n");
+	} else {
+		APPLOG_SetRateLimit(0, 0);
+		APPLOG_SetBackpressure(LOGBENCH_policy, 5);
+		APPLOG_SetLogLevel(LOGLV_INFO | LOGLV_DEBUG | LOGLV_WARNING | LOGLV_ERROR | LOGLV_CRITICAL);
+		APPLOG_ResetLogBits(LOGBIT_SENTINEL - 1);
+		if (LOGBENCH_DEBUG_EMITTED == workload) {
+			APPLOG_SetLogBits(LOGBIT_DEBUG);
+		}
+
+		if ((LOGBENCH_DEST_FILE == dest) && !APPLOG_SetLogFile(LOGBENCH_FILE)) {
+			fprintf(stderr, "Couldn't open %s\n", LOGBENCH_FILE);
+		} else if ((LOGBENCH_DEST_MEMORY == dest)
+				&& (!APPLOG_SetMemorySink(LOGBENCH_MEMORY_RECORDS) || !APPLOG_SetSinkLevels(APPLOG_SINK_CONSOLE, 0))) {
+			fprintf(stderr, "Couldn't set up the memory output\n");
+		} else {
+			pthread_barrier_init(&barrier, NULL, threads + 1);
+			for (i = 0; i < threads; i++) {
+				p_threads[i].workload = workload;
+				p_threads[i].msgs = msgs;
+				p_threads[i].p_lat = p_lat + (size_t)i * msgs;
+				p_threads[i].p_barrier = &barrier;
+				pthread_create(&p_threads[i].thread, NULL, LOGBENCH_Thread, &p_threads[i]);
+			}
+
+			pthread_barrier_wait(&barrier);
+			for (i = 0; i < threads; i++) {
+				pthread_join(p_threads[i].thread, NULL);
+			}
+			pthread_barrier_destroy(&barrier);
+
+			/* the wall time spans from the first start to the last end */
+			for (i = 0; i < threads; i++) {
+				if (LOGBENCH_Diff(&p_threads[0].start, &p_threads[i].start) < 0) {
+					p_threads[0].start = p_threads[i].start;
+				}
+				if (LOGBENCH_Diff(&p_threads[0].end, &p_threads[i].end) > 0) {
+					p_threads[0].end = p_threads[i].end;
+				}
+			}
+			wall = LOGBENCH_Diff(&p_threads[0].start, &p_threads[0].end);
+
+			qsort(p_lat, total, sizeof(*p_lat), LOGBENCH_Compare);
+			p_result->msgs_per_s = total * 1e9 / (double)((0 < wall) ? wall : 1);
+			p_result->p50 = p_lat[total / 2];
+			p_result->p99 = p_lat[total * 99 / 100];
+			p_result->p999 = p_lat[total * 999 / 1000];
+			APPLOG_GetCounters(&counters);
+			p_result->lost = counters.dropped + counters.overwritten;
+			rv = true;
+		}
+		/* the async and deferred writers drain their ring here: not measured */
+		APPLOG_Breakdown();
+
+		if (LOGBENCH_DEST_FILE == dest) {
+			LOGBENCH_RemoveFiles();
+		}
+	}
+
+	free(p_threads);
+	free(p_lat);
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static void* LOGBENCH_Thread(void* p_arg)
+{
+	static const char* fn = "LOGBENCH_Thread";
+	struct LOGBENCH_THREAD_S* p_thread = p_arg;
+	struct timespec start;
+	struct timespec end;
+	uint32_t i;
+
+	pthread_barrier_wait(p_thread->p_barrier);
+	clock_gettime(CLOCK_MONOTONIC, &p_thread->start);
+
+	/* a different text per call: identical lines would be collapsed */
+	for (i = 0; i < p_thread->msgs; i++) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		switch (p_thread->workload) {
+		case LOGBENCH_LOG_FILTERED:
+			APPLOG_Log(fn, LOGLV_TEST, "filtered call %u", i);
+			break;
+		case LOGBENCH_DEBUG_FILTERED:
+			APPLOG_LogDebug(fn, LOGBIT_DEBUG, "filtered call %u", i);
+			break;
+		case LOGBENCH_LOG_EMITTED:
+			APPLOG_Log(fn, LOGLV_WARNING, "emitted call %u", i);
+			break;
+		default:
+			APPLOG_LogDebug(fn, LOGBIT_DEBUG, "emitted call %u", i);
+			break;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		p_thread->p_lat[i] = (uint32_t)LOGBENCH_Diff(&start, &end);
+	}
+	p_thread->end = end;
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+static void LOGBENCH_RemoveFiles(void)
+{
+	char path[sizeof(LOGBENCH_FILE) + 12];
+	uint32_t i;
+
+	unlink(LOGBENCH_FILE);
+	for (i = 1; i <= 16; i++) {
+		snprintf(path, sizeof(path), "%s.%u", LOGBENCH_FILE, i);
+		unlink(path);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+static int LOGBENCH_Compare(const void* p_a, const void* p_b)
+{
+	uint32_t a = *(const uint32_t*)p_a;
+	uint32_t b = *(const uint32_t*)p_b;
+
+	return (a > b) - (a < b);
+}
+
+/* ------------------------------------------------------------------------- */
+static int64_t LOGBENCH_Diff(const struct timespec* const p_start, const struct timespec* const p_end)
+{
+	return (int64_t)(p_end->tv_sec - p_start->tv_sec) * 1000000000 + (p_end->tv_nsec - p_start->tv_nsec);
+}
@@ -0,0 +1,243 @@
+/**
+ * @file logprefix.c
+ * @brief micro-benchmark of the level prefix of APPLOG_Log
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * Compares the former prefix construction (zeroed buffer and strcat chain,
+ * done before the level filter) with the prefix table, and times
+ * APPLOG_Log for a filtered out and an emitted (/dev/null) record.
+ */
+
+/* -------------------------------------------------------------------------
+ * include section
+ * -------------------------------------------------------------------------*/
+
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* project specific includes - if possible alphabetically ordered */
+#include "../common/argparse.h"
+#include "../common/log.h"
+
+/* module specific includes - if possible alphabetically ordered */
+
+#define ANSI_COLOR_RED     "\x1b[91m"
+#define ANSI_COLOR_GREEN   "\x1b[92m"
+#define ANSI_COLOR_YELLOW  "\x1b[93m"
+#define ANSI_COLOR_BLUE    "\x1b[94m"
+#define ANSI_COLOR_MAGENTA "\x1b[95m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+/**
+ * @brief Prefix table entry initializer
+ */
+#define LOGPREFIX_ENTRY(text) { text, sizeof(text) - 1 }
+
+/**
+ * @brief Default number of calls per measurement
+ */
+#define LOGPREFIX_DEFAULT_CALLS (2000000)
+
+static const char* const usages[] = {
+	"logprefix [options]",
+	NULL
+};
+
+/**
+ * @brief Keeps the compiler from dropping the measured work
+ */
+static volatile size_t LOGPREFIX_sink;
+
+/**
+ * @brief The level filter of the measurements
+ */
+static volatile uint64_t LOGPREFIX_level_bits = LOGLV_INFO | LOGLV_WARNING | LOGLV_ERROR | LOGLV_CRITICAL;
+
+/**
+ * @brief The former level string construction of APPLOG_Log
+ * @param[in] level the log level
+ * @param[out] level_str the level string, 20 bytes
+ */
+static void LOGPREFIX_LevelStr(const uint64_t level, char* const level_str);
+
+/**
+ * @brief The former line prefix: strcat chain and snprintf
+ * @param[in] level the log level
+ */
+static void LOGPREFIX_Legacy(const uint64_t level);
+
+/**
+ * @brief The line prefix from the prefix table
+ * @param[in] level the log level
+ */
+static void LOGPREFIX_Table(const uint64_t level);
+
+/**
+ * @brief The former filtered out APPLOG_Log: level string first, filter next
+ * @param[in] level the log level
+ */
+static void LOGPREFIX_LegacyFiltered(const uint64_t level);
+
+/**
+ * @brief APPLOG_Log as measured function
+ * @param[in] level the log level
+ */
+static void LOGPREFIX_Log(const uint64_t level);
+
+/**
+ * @brief Time calls of a function
+ * @param[in] p_call the function
+ * @param[in] level the log level passed
+ * @param[in] calls the number of calls
+ * @return ns per call
+ */
+static double LOGPREFIX_Time(void (*p_call)(const uint64_t), const uint64_t level, const long calls);
+
+/**
+ * @brief The main function
+ * @param[in] argc the number of command-line arguments
+ * @param[in] argv the pointer to the arguments string collection
+ * @return 0 on success, other values if failure
+ */
+int main(int argc, const char **argv)
+{
+	int calls = LOGPREFIX_DEFAULT_CALLS;
+	int rv = 0;
+
+	struct argparse_option options[] = {
+		OPT_HELP(),
+		OPT_GROUP("Optional arguments"),
+		OPT_INTEGER('n', "calls", &calls, "number of calls per measurement", NULL, 0, 0),
+		OPT_END(),
+	};
+	struct argparse argparse;
+	argparse_init(&argparse, options, usages, 0);
+	argparse_describe(&argparse, "\nMeasure the cost of the level prefix of APPLOG_Log.", "");
+	argc = argparse_parse(&argparse, argc, argv);
+
+	if (0 >= calls) {
+		argparse_usage(&argparse);
+		rv = -1;
+	} else if (NULL == freopen("/dev/null", "w", stdout)) {
+		/* the emitted records go to the console: send them to /dev/null */
+		fprintf(stderr, "Couldn't redirect stdout\n");
+		rv = -1;
+	} else if (!APPLOG_Init()) {
+		fprintf(stderr, "Couldn't initialize the log component\n");
+		rv = -1;
+	} else {
+		APPLOG_SetRateLimit(0, 0);
+		APPLOG_SetLogLevel(LOGPREFIX_level_bits);
+
+		fprintf(stderr, "%-44s %8.1f ns/call\n", "line prefix, strcat + snprintf (before)",
+				LOGPREFIX_Time(LOGPREFIX_Legacy, LOGLV_WARNING, calls));
+		fprintf(stderr, "%-44s %8.1f ns/call\n", "line prefix, table + memcpy (after)",
+				LOGPREFIX_Time(LOGPREFIX_Table, LOGLV_WARNING, calls));
+		fprintf(stderr, "%-44s %8.1f ns/call\n", "filtered out, strcat before filter (before)",
+				LOGPREFIX_Time(LOGPREFIX_LegacyFiltered, LOGLV_TEST, calls));
+		fprintf(stderr, "%-44s %8.1f ns/call\n", "APPLOG_Log, filtered out (after)",
+				LOGPREFIX_Time(LOGPREFIX_Log, LOGLV_TEST, calls));
+		fprintf(stderr, "%-44s %8.1f ns/call\n", "APPLOG_Log, emitted to /dev/null (after)",
+				LOGPREFIX_Time(LOGPREFIX_Log, LOGLV_WARNING, calls));
+
+		APPLOG_Breakdown();
+	}
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static void LOGPREFIX_LevelStr(const uint64_t level, char* const level_str)
+{
+	if (LOGLV_UNDEFINED == level || LOGLV_SENTINEL < level){
+		strcat(level_str, "????");
+	} else {
+		if      (level & LOGLV_INFO)     strcat(level_str, ANSI_COLOR_GREEN   "INFO"     ANSI_COLOR_RESET);
+		else if (level & LOGLV_DEBUG)    strcat(level_str, ANSI_COLOR_BLUE    "DEBUG"    ANSI_COLOR_RESET);
+		else if (level & LOGLV_WARNING)  strcat(level_str, ANSI_COLOR_YELLOW  "WARNING"  ANSI_COLOR_RESET);
+		else if (level & LOGLV_ERROR)    strcat(level_str, ANSI_COLOR_RED     "ERROR"    ANSI_COLOR_RESET);
+		else if (level & LOGLV_CRITICAL) strcat(level_str, ANSI_COLOR_RED     "CRITICAL" ANSI_COLOR_RESET);
+		else if (level & LOGLV_TEST)     strcat(level_str, ANSI_COLOR_MAGENTA "TEST"     ANSI_COLOR_RESET);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+static void LOGPREFIX_Legacy(const uint64_t level)
+{
+	char level_str[20] = "";
+	char line[128];
+
+	LOGPREFIX_LevelStr(level, level_str);
+	LOGPREFIX_sink += snprintf(line, sizeof(line), ") [%s] %s: ", level_str, "LOGPREFIX_Legacy");
+}
+
+/* ------------------------------------------------------------------------- */
+static void LOGPREFIX_Table(const uint64_t level)
+{
+	static const struct {
+		const char* text;
+		size_t len;
+	} prefixes[] = {
+		LOGPREFIX_ENTRY(") [" ANSI_COLOR_GREEN   "INFO"     ANSI_COLOR_RESET "] "),
+		LOGPREFIX_ENTRY(") [" ANSI_COLOR_BLUE    "DEBUG"    ANSI_COLOR_RESET "] "),
+		LOGPREFIX_ENTRY(") [" ANSI_COLOR_YELLOW  "WARNING"  ANSI_COLOR_RESET "] "),
+		LOGPREFIX_ENTRY(") [" ANSI_COLOR_RED     "ERROR"    ANSI_COLOR_RESET "] "),
+		LOGPREFIX_ENTRY(") [" ANSI_COLOR_RED     "CRITICAL" ANSI_COLOR_RESET "] "),
+		LOGPREFIX_ENTRY(") [" ANSI_COLOR_MAGENTA "TEST"     ANSI_COLOR_RESET "] "),
+		LOGPREFIX_ENTRY(") [????] ")
+	};
+	static const char* fn = "LOGPREFIX_Table";
+	size_t index = ((LOGLV_UNDEFINED == level) || (LOGLV_SENTINEL <= level)) ? 6 : (size_t)__builtin_ctzll(level);
+	size_t fn_len = strlen(fn);
+	char line[128];
+	size_t len;
+
+	memcpy(line, prefixes[index].text, prefixes[index].len);
+	len = prefixes[index].len;
+	memcpy(line + len, fn, fn_len);
+	len += fn_len;
+	memcpy(line + len, ": ", 2);
+	len += 2;
+	line[len] = '\0';
+	LOGPREFIX_sink += len;
+}
+
+/* ------------------------------------------------------------------------- */
+static void LOGPREFIX_LegacyFiltered(const uint64_t level)
+{
+	char level_str[20] = "";
+
+	LOGPREFIX_LevelStr(level, level_str);
+	if (level & LOGPREFIX_level_bits){
+		LOGPREFIX_sink += level_str[1];
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+static void LOGPREFIX_Log(const uint64_t level)
+{
+	static unsigned long count;
+
+	/* a different text per call: identical lines would be collapsed */
+	APPLOG_Log("LOGPREFIX_Log", level, "measured call %lu", count++);
+}
+
+/* ------------------------------------------------------------------------- */
+static double LOGPREFIX_Time(void (*p_call)(const uint64_t), const uint64_t level, const long calls)
+{
+	struct timespec start;
+	struct timespec end;
+	long i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < calls; i++) {
+		p_call(level);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / calls;
+}
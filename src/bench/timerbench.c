@@ -0,0 +1,425 @@
+/**
+ * @file timerbench.c
+ * @brief accuracy benchmark of the timers
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * Arms one-shot timers with relative and absolute (TIMER_ABSTIME)
+ * deadlines spread over 1 .. 100 ms with nanosecond parts, and periodic
+ * timers of 1 .. 20 ms and of 100 .. 400 us, on every selected clock. Each
+ * call-back reads the clock of its timer; the report holds the firing error
+ * against the deadline: early calls (must be 0), min, p50, p99 and max,
+ * the voluntary context switches and the CPU time of the process against
+ * the run time. With a slack (-s) the timers share wakeups: the errors grow
+ * up to the slack and the context switches, mostly the dispatcher thread
+ * waking up, drop. The sub-millisecond timers fail the run when they take
+ * more than TIMERBENCH_MAX_CPU of a CPU: deadlines within one tick of the
+ * wheel must not make the dispatcher spin.
+ */
+
+/* -------------------------------------------------------------------------
+ * include section
+ * -------------------------------------------------------------------------*/
+
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+/* project specific includes - if possible alphabetically ordered */
+#include "../common/argparse.h"
+#include "../common/log.h"
+#include "../common/timers.h"
+
+/* module specific includes - if possible alphabetically ordered */
+
+/**
+ * @brief Default number of one-shot timers per scenario
+ */
+#define TIMERBENCH_DEFAULT_TIMERS (2000)
+
+/**
+ * @brief Default number of ticks per periodic timer
+ */
+#define TIMERBENCH_DEFAULT_TICKS (100)
+
+/**
+ * @brief Number of periodic timers, of 1 .. TIMERBENCH_PERIODIC ms
+ */
+#define TIMERBENCH_PERIODIC (20)
+
+/**
+ * @brief Number of sub-millisecond periodic timers, of 100 ..
+ * TIMERBENCH_FAST * 100 us
+ */
+#define TIMERBENCH_FAST (4)
+
+/**
+ * @brief Ticks of a sub-millisecond periodic timer per tick of a periodic
+ * timer
+ */
+#define TIMERBENCH_FAST_TICKS (10)
+
+/**
+ * @brief Highest CPU use (%) of the sub-millisecond periodic timers
+ */
+#define TIMERBENCH_MAX_CPU (50)
+
+/**
+ * @brief Longest one-shot delay (ns)
+ */
+#define TIMERBENCH_MAX_DELAY (100000000L)
+
+/**
+ * @brief Size of a clock list copy
+ */
+#define TIMERBENCH_LIST_SIZE (64)
+
+static const char* const usages[] = {
+	"timerbench [options]",
+	NULL
+};
+
+/**
+ * @brief The measured scenarios
+ */
+enum TIMERBENCH_SCENARIO_E {
+	TIMERBENCH_RELATIVE = 0,      /**< one-shot, relative deadline */
+	TIMERBENCH_ABSOLUTE,          /**< one-shot, TIMER_ABSTIME deadline */
+	TIMERBENCH_PERIODIC_TICKS,    /**< periodic, every tick */
+	TIMERBENCH_FAST_PERIODIC,     /**< periodic below the tick of the wheel */
+	TIMERBENCH_SCENARIO_SENTINEL  /**< DO NOT USE */
+};
+
+/**
+ * @brief One timer of a scenario
+ */
+struct TIMERBENCH_TIMER_S {
+	timer_t timer_id;           /**< The timer */
+	clockid_t clock_id;         /**< Its clock */
+	struct timespec deadline;   /**< The next deadline */
+	int64_t period;             /**< The period (ns), 0 for one-shot */
+	uint32_t ticks;             /**< Ticks left */
+};
+
+/**
+ * @brief The firing errors of a scenario
+ */
+struct TIMERBENCH_SAMPLES_S {
+	int64_t* p_errors;          /**< Firing error of every call (ns) */
+	uint32_t capacity;          /**< Room in p_errors */
+	atomic_uint count;          /**< Errors recorded */
+	atomic_uint done;           /**< Timers that are done */
+};
+
+static const char* const TIMERBENCH_scenario_names[TIMERBENCH_SCENARIO_SENTINEL] = {
+	"relative", "absolute", "periodic", "fast"
+};
+
+static const char* const TIMERBENCH_clock_names[] = {
+	"realtime", "monotonic", "boottime"
+};
+
+static const clockid_t TIMERBENCH_clocks[] = {
+	CLOCK_REALTIME, CLOCK_MONOTONIC, CLOCK_BOOTTIME
+};
+
+/**
+ * @brief The samples of the running scenario, filled by the call-backs
+ */
+static struct TIMERBENCH_SAMPLES_S TIMERBENCH_samples;
+
+/**
+ * @brief The slack of every timer
+ */
+static struct timespec TIMERBENCH_slack;
+
+/**
+ * @brief Run one scenario
+ * @param[in] clock_id the clock of the timers
+ * @param[in] scenario the scenario
+ * @param[in] timers the number of one-shot timers
+ * @param[in] ticks the number of ticks per periodic timer
+ * @return true on success, false otherwise
+ */
+static bool TIMERBENCH_Run(const clockid_t clock_id, const enum TIMERBENCH_SCENARIO_E scenario,
+		const uint32_t timers, const uint32_t ticks);
+
+/**
+ * @brief The timer call-back: records the firing error
+ * @param[in] p_event the elapsed TIMERBENCH_TIMER_S
+ */
+static void TIMERBENCH_Elapsed(const struct TIMER_EVENT_S* const p_event);
+
+/**
+ * @brief qsort comparison of two errors
+ * @param[in] p_a the first error
+ * @param[in] p_b the second error
+ * @return <0, 0 or >0
+ */
+static int TIMERBENCH_Compare(const void* p_a, const void* p_b);
+
+/**
+ * @brief Nanoseconds between two timestamps
+ * @param[in] p_start the start
+ * @param[in] p_end the end
+ * @return the difference in ns
+ */
+static int64_t TIMERBENCH_Diff(const struct timespec* const p_start, const struct timespec* const p_end);
+
+/**
+ * @brief Add nanoseconds to a timestamp
+ * @param[in, out] p_time the timestamp
+ * @param[in] ns the nanoseconds, >= 0
+ */
+static void TIMERBENCH_Add(struct timespec* const p_time, const int64_t ns);
+
+/**
+ * @brief The main function
+ * @param[in] argc the number of command-line arguments
+ * @param[in] argv the pointer to the arguments string collection
+ * @return 0 on success, other values if failure
+ */
+int main(int argc, const char **argv)
+{
+	const char* clock_list = "realtime,monotonic,boottime";
+	char list[TIMERBENCH_LIST_SIZE];
+	int timers = TIMERBENCH_DEFAULT_TIMERS;
+	int ticks = TIMERBENCH_DEFAULT_TICKS;
+	int slack = 0;
+	char* p_save;
+	char* p_tok;
+	unsigned clock;
+	int scenario;
+	int rv = 0;
+
+	struct argparse_option options[] = {
+		OPT_HELP(),
+		OPT_GROUP("Optional arguments"),
+		OPT_INTEGER('n', "timers", &timers, "number of one-shot timers per scenario", NULL, 0, 0),
+		OPT_INTEGER('p', "ticks", &ticks, "number of ticks per periodic timer", NULL, 0, 0),
+		OPT_STRING('c', "clocks", &clock_list, "comma separated clocks: realtime, monotonic, boottime", NULL, 0, 0),
+		OPT_INTEGER('s', "slack", &slack, "slack of every timer in us", NULL, 0, 0),
+		OPT_END(),
+	};
+	struct argparse argparse;
+	argparse_init(&argparse, options, usages, 0);
+	argparse_describe(&argparse, "\nMeasure the firing error of the timers.", "");
+	argc = argparse_parse(&argparse, argc, argv);
+
+	if ((0 >= timers) || (0 >= ticks) || (0 > slack)) {
+		argparse_usage(&argparse);
+		rv = -1;
+	} else if (!APPLOG_Init()) {
+		fprintf(stderr, "Couldn't initialize the log component\n");
+		rv = -1;
+	} else if (!TIMER_Init()) {
+		fprintf(stderr, "Couldn't initialize the timer component\n");
+		rv = -1;
+	} else {
+		APPLOG_SetLogLevel(LOGLV_WARNING | LOGLV_ERROR | LOGLV_CRITICAL);
+		TIMERBENCH_slack.tv_sec = slack / 1000000;
+		TIMERBENCH_slack.tv_nsec = (slack % 1000000) * 1000L;
+		fprintf(stderr, "%d one-shot timers, %d periodic timers of %d ticks, %d fast of %d ticks, %d us slack\n",
+				timers, TIMERBENCH_PERIODIC, ticks, TIMERBENCH_FAST, ticks * TIMERBENCH_FAST_TICKS, slack);
+		fprintf(stderr, "%-10s %-9s %8s %6s %10s %10s %10s %10s %8s %6s\n",
+				"clock", "scenario", "calls", "early", "min us", "p50 us", "p99 us", "max us", "csw", "cpu %");
+
+		snprintf(list, sizeof(list), "%s", clock_list);
+		for (p_tok = strtok_r(list, ",", &p_save); (NULL != p_tok) && (0 == rv); p_tok = strtok_r(NULL, ",", &p_save)) {
+			for (clock = 0; clock < sizeof(TIMERBENCH_clocks) / sizeof(TIMERBENCH_clocks[0]); clock++) {
+				if (0 == strcmp(p_tok, TIMERBENCH_clock_names[clock])) {
+					break;
+				}
+			}
+			if (sizeof(TIMERBENCH_clocks) / sizeof(TIMERBENCH_clocks[0]) == clock) {
+				fprintf(stderr, "Unknown clock: %s\n", p_tok);
+				rv = -1;
+			}
+			for (scenario = 0; (scenario < TIMERBENCH_SCENARIO_SENTINEL) && (0 == rv); scenario++) {
+				fprintf(stderr, "%-10s %-9s ", TIMERBENCH_clock_names[clock], TIMERBENCH_scenario_names[scenario]);
+				if (!TIMERBENCH_Run(TIMERBENCH_clocks[clock], scenario, timers, ticks)) {
+					rv = -1;
+				}
+			}
+		}
+		TIMER_Breakdown();
+	}
+	APPLOG_Breakdown();
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static bool TIMERBENCH_Run(const clockid_t clock_id, const enum TIMERBENCH_SCENARIO_E scenario,
+		const uint32_t timers, const uint32_t ticks)
+{
+	struct TIMERBENCH_TIMER_S* p_timers;
+	struct itimerspec value;
+	struct timespec now;
+	struct timespec run_start;
+	struct timespec run_end;
+	struct rusage start;
+	struct rusage end;
+	uint32_t early = 0;
+	uint32_t count = timers;
+	uint32_t calls;
+	uint32_t i;
+	int64_t delay;
+	int64_t cpu;
+	double cpu_percent;
+	bool rv = false;
+
+	if (TIMERBENCH_PERIODIC_TICKS == scenario) {
+		count = TIMERBENCH_PERIODIC;
+		TIMERBENCH_samples.capacity = count * ticks;
+	} else if (TIMERBENCH_FAST_PERIODIC == scenario) {
+		count = TIMERBENCH_FAST;
+		TIMERBENCH_samples.capacity = count * ticks * TIMERBENCH_FAST_TICKS;
+	} else {
+		TIMERBENCH_samples.capacity = count;
+	}
+	p_timers = calloc(count, sizeof(*p_timers));
+	TIMERBENCH_samples.p_errors = malloc(TIMERBENCH_samples.capacity * sizeof(int64_t));
+	atomic_store(&TIMERBENCH_samples.count, 0);
+	atomic_store(&TIMERBENCH_samples.done, 0);
+
+	if ((NULL == p_timers) || (NULL == TIMERBENCH_samples.p_errors)) {
+		fprintf(stderr, "Out of memory\n");
+	} else {
+		rv = true;
+		clock_gettime(CLOCK_MONOTONIC, &run_start);
+		getrusage(RUSAGE_SELF, &start);
+		for (i = 0; (i < count) && rv; i++) {
+			p_timers[i].clock_id = clock_id;
+			memset(&value, 0, sizeof(value));
+			if (TIMERBENCH_PERIODIC_TICKS == scenario) {
+				p_timers[i].period = (i + 1) * 1000000L;
+				p_timers[i].ticks = ticks;
+				value.it_value.tv_nsec = p_timers[i].period;
+				value.it_interval.tv_nsec = p_timers[i].period;
+			} else if (TIMERBENCH_FAST_PERIODIC == scenario) {
+				p_timers[i].period = (i + 1) * 100000L;
+				p_timers[i].ticks = ticks * TIMERBENCH_FAST_TICKS;
+				value.it_value.tv_nsec = p_timers[i].period;
+				value.it_interval.tv_nsec = p_timers[i].period;
+			} else {
+				delay = 1000000L + (int64_t) rand() * (TIMERBENCH_MAX_DELAY - 1000000L) / RAND_MAX;
+				p_timers[i].ticks = 1;
+				value.it_value.tv_sec = delay / 1000000000L;
+				value.it_value.tv_nsec = delay % 1000000000L;
+			}
+			if ((0 != TIMER_CreateClockTimer(&p_timers[i].timer_id, clock_id, &p_timers[i], TIMERBENCH_Elapsed))
+					|| (0 != TIMER_SetSlack(p_timers[i].timer_id, &TIMERBENCH_slack))) {
+				rv = false;
+				break;
+			}
+
+			clock_gettime(clock_id, &now);
+			p_timers[i].deadline = now;
+			TIMERBENCH_Add(&p_timers[i].deadline, value.it_value.tv_sec * 1000000000L + value.it_value.tv_nsec);
+			if (TIMERBENCH_ABSOLUTE == scenario) {
+				value.it_value = p_timers[i].deadline;
+				rv = (0 == TIMER_SetTimeSpec(p_timers[i].timer_id, TIMER_ABSTIME, &value));
+			} else {
+				/* armed after the clock read: the real deadline is a bit later */
+				rv = (0 == TIMER_SetTimeSpec(p_timers[i].timer_id, 0, &value));
+			}
+		}
+
+		while (rv && (atomic_load(&TIMERBENCH_samples.done) < count)) {
+			usleep(10000);
+		}
+		getrusage(RUSAGE_SELF, &end);
+		clock_gettime(CLOCK_MONOTONIC, &run_end);
+		cpu = (int64_t)(end.ru_utime.tv_sec - start.ru_utime.tv_sec + end.ru_stime.tv_sec - start.ru_stime.tv_sec) * 1000000
+				+ (end.ru_utime.tv_usec - start.ru_utime.tv_usec + end.ru_stime.tv_usec - start.ru_stime.tv_usec);
+		cpu_percent = 100.0 * cpu / (TIMERBENCH_Diff(&run_start, &run_end) / 1000 + 1);
+
+		calls = atomic_load(&TIMERBENCH_samples.count);
+		qsort(TIMERBENCH_samples.p_errors, calls, sizeof(int64_t), TIMERBENCH_Compare);
+		for (i = 0; i < calls; i++) {
+			early += (0 > TIMERBENCH_samples.p_errors[i]);
+		}
+		if (rv && (0 < calls)) {
+			fprintf(stderr, "%8u %6u %10.1f %10.1f %10.1f %10.1f %8ld %6.1f\n", calls, early,
+					TIMERBENCH_samples.p_errors[0] / 1000.0,
+					TIMERBENCH_samples.p_errors[calls / 2] / 1000.0,
+					TIMERBENCH_samples.p_errors[(uint64_t) calls * 99 / 100] / 1000.0,
+					TIMERBENCH_samples.p_errors[calls - 1] / 1000.0,
+					end.ru_nvcsw - start.ru_nvcsw, cpu_percent);
+		}
+		if (rv && (TIMERBENCH_FAST_PERIODIC == scenario) && (TIMERBENCH_MAX_CPU < cpu_percent)) {
+			fprintf(stderr, "The fast timers took %.1f %% of a CPU, more than %d %%\n",
+					cpu_percent, TIMERBENCH_MAX_CPU);
+			rv = false;
+		}
+		for (i = 0; i < count; i++) {
+			if (NULL != p_timers[i].timer_id) {
+				TIMER_DisposeTimer(p_timers[i].timer_id);
+			}
+		}
+	}
+	free(TIMERBENCH_samples.p_errors);
+	TIMERBENCH_samples.p_errors = NULL;
+	free(p_timers);
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static void TIMERBENCH_Elapsed(const struct TIMER_EVENT_S* const p_event)
+{
+	struct TIMERBENCH_TIMER_S* const p_timer = (struct TIMERBENCH_TIMER_S*) p_event->p_params;
+	struct itimerspec value;
+	struct timespec now;
+	int64_t error;
+	uint32_t n;
+
+	clock_gettime(p_timer->clock_id, &now);
+	error = TIMERBENCH_Diff(&p_timer->deadline, &now);
+	if (0 != p_timer->period) {
+		/* the next tick, after the ticks the dispatcher skipped already */
+		TIMERBENCH_Add(&p_timer->deadline, (1 + (int64_t) p_event->overruns) * p_timer->period);
+	}
+	n = atomic_fetch_add(&TIMERBENCH_samples.count, 1);
+	if (n < TIMERBENCH_samples.capacity) {
+		TIMERBENCH_samples.p_errors[n] = error;
+	} else {
+		atomic_fetch_sub(&TIMERBENCH_samples.count, 1);
+	}
+
+	if (0 == --p_timer->ticks) {
+		memset(&value, 0, sizeof(value));
+		TIMER_SetTimeSpec(p_event->timer_id, 0, &value);
+		atomic_fetch_add(&TIMERBENCH_samples.done, 1);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+static int TIMERBENCH_Compare(const void* p_a, const void* p_b)
+{
+	int64_t a = *(const int64_t*)p_a;
+	int64_t b = *(const int64_t*)p_b;
+
+	return (a > b) - (a < b);
+}
+
+/* ------------------------------------------------------------------------- */
+static int64_t TIMERBENCH_Diff(const struct timespec* const p_start, const struct timespec* const p_end)
+{
+	return (int64_t)(p_end->tv_sec - p_start->tv_sec) * 1000000000 + (p_end->tv_nsec - p_start->tv_nsec);
+}
+
+/* ------------------------------------------------------------------------- */
+static void TIMERBENCH_Add(struct timespec* const p_time, const int64_t ns)
+{
+	const int64_t total = p_time->tv_nsec + ns;
+
+	p_time->tv_sec += total / 1000000000L;
+	p_time->tv_nsec = total % 1000000000L;
+}
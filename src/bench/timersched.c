@@ -0,0 +1,362 @@
+/**
+ * @file timersched.c
+ * @brief scheduler benchmark of the timers: the wheel against the heap
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * For every backend, deadline distribution and population of 1k, 10k ..
+ * up to -n timers, times the scheduler through the public API:
+ * - arm: arming every timer, the deadlines 1 s out plus the distribution
+ *   so that none elapses while measured
+ * - rearm: arming every armed timer again with its delay, as a timeout
+ *   is refreshed
+ * - cancel: disarming every timer
+ * - fire: the CPU time of the process per elapsed timer, the distribution
+ *   scaled into TIMERSCHED_FIRE_SPAN, mostly the dispatcher thread
+ * The distributions are uniform over 1 .. 100 ms, short protocol timeouts,
+ * and log-uniform over 1 ms .. ~1 h, timeouts of milliseconds to hours: a
+ * random octave of TIMERSCHED_LOG_OCTAVES, uniform within it.
+ */
+
+/* -------------------------------------------------------------------------
+ * include section
+ * -------------------------------------------------------------------------*/
+
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+/* project specific includes - if possible alphabetically ordered */
+#include "../common/argparse.h"
+#include "../common/log.h"
+#include "../common/timers.h"
+
+/* module specific includes - if possible alphabetically ordered */
+
+/**
+ * @brief Default largest population
+ */
+#define TIMERSCHED_DEFAULT_TIMERS (1000000)
+
+/**
+ * @brief Smallest population
+ */
+#define TIMERSCHED_MIN_TIMERS (1000)
+
+/**
+ * @brief Lead of the measured deadlines (ns), none elapses while measured
+ */
+#define TIMERSCHED_LEAD (1000000000LL)
+
+/**
+ * @brief Latest deadline of the fire phase (ns)
+ */
+#define TIMERSCHED_FIRE_SPAN (200000000LL)
+
+/**
+ * @brief Octaves of the log distribution, from 1 ms: up to 2^22 ms, ~70 min
+ */
+#define TIMERSCHED_LOG_OCTAVES (22)
+
+/**
+ * @brief Size of a list copy
+ */
+#define TIMERSCHED_LIST_SIZE (64)
+
+static const char* const usages[] = {
+	"timersched [options]",
+	NULL
+};
+
+/**
+ * @brief The deadline distributions
+ */
+enum TIMERSCHED_DIST_E {
+	TIMERSCHED_UNIFORM = 0,      /**< uniform over 1 .. 100 ms */
+	TIMERSCHED_LOG,              /**< log-uniform over 1 ms .. ~1 h */
+	TIMERSCHED_DIST_SENTINEL     /**< DO NOT USE */
+};
+
+static const char* const TIMERSCHED_backend_names[TIMER_BACKEND_SENTINEL] = {
+	"wheel", "heap"
+};
+
+static const char* const TIMERSCHED_dist_names[TIMERSCHED_DIST_SENTINEL] = {
+	"uniform", "log"
+};
+
+/**
+ * @brief Shortest delay of each distribution (ns)
+ */
+static const double TIMERSCHED_dist_min[TIMERSCHED_DIST_SENTINEL] = {
+	1e6, 1e6
+};
+
+/**
+ * @brief Longest delay of each distribution (ns)
+ */
+static const double TIMERSCHED_dist_max[TIMERSCHED_DIST_SENTINEL] = {
+	1e8, 1e6 * (1 << TIMERSCHED_LOG_OCTAVES)
+};
+
+/**
+ * @brief Timers elapsed in the fire phase
+ */
+static atomic_uint TIMERSCHED_fired;
+
+/**
+ * @brief Run every population of a backend and a distribution
+ * @param[in] backend the backend, initialized
+ * @param[in] dist the distribution
+ * @param[in] max_timers the largest population
+ * @return true on success, false otherwise
+ */
+static bool TIMERSCHED_Run(const enum TIMER_BACKEND_E backend, const enum TIMERSCHED_DIST_E dist,
+		const uint32_t max_timers);
+
+/**
+ * @brief Arm timers with relative delays
+ * @param[in] p_timers the timers
+ * @param[in] p_delays the delays (ns)
+ * @param[in] count the number of timers
+ * @param[in] lead added to every delay (ns)
+ * @return the ns per timer, < 0 on failure
+ */
+static double TIMERSCHED_Arm(const timer_t* const p_timers, const int64_t* const p_delays,
+		const uint32_t count, const int64_t lead);
+
+/**
+ * @brief The timer call-back: counts the elapsed timers
+ * @param[in] p_event not used
+ */
+static void TIMERSCHED_Elapsed(const struct TIMER_EVENT_S* const p_event);
+
+/**
+ * @brief Nanoseconds between two timestamps
+ * @param[in] p_start the start
+ * @param[in] p_end the end
+ * @return the difference in ns
+ */
+static int64_t TIMERSCHED_Diff(const struct timespec* const p_start, const struct timespec* const p_end);
+
+/**
+ * @brief Nanoseconds of CPU time of the process
+ * @return the user and system time in ns
+ */
+static int64_t TIMERSCHED_Cpu(void);
+
+/**
+ * @brief The main function
+ * @param[in] argc the number of command-line arguments
+ * @param[in] argv the pointer to the arguments string collection
+ * @return 0 on success, other values if failure
+ */
+int main(int argc, const char **argv)
+{
+	const char* backend_list = "wheel,heap";
+	const char* dist_list = "uniform,log";
+	char backends[TIMERSCHED_LIST_SIZE];
+	char dists[TIMERSCHED_LIST_SIZE];
+	int timers = TIMERSCHED_DEFAULT_TIMERS;
+	char* p_save_backend;
+	char* p_save_dist;
+	char* p_backend;
+	char* p_dist;
+	int backend;
+	int dist;
+	int rv = 0;
+
+	struct argparse_option options[] = {
+		OPT_HELP(),
+		OPT_GROUP("Optional arguments"),
+		OPT_INTEGER('n', "timers", &timers, "largest population, from 1000 up ten-fold", NULL, 0, 0),
+		OPT_STRING('b', "backends", &backend_list, "comma separated backends: wheel, heap", NULL, 0, 0),
+		OPT_STRING('d', "dists", &dist_list, "comma separated distributions: uniform, log", NULL, 0, 0),
+		OPT_END(),
+	};
+	struct argparse argparse;
+	argparse_init(&argparse, options, usages, 0);
+	argparse_describe(&argparse, "\nCompare the timer schedulers.", "");
+	argc = argparse_parse(&argparse, argc, argv);
+
+	if ((TIMERSCHED_MIN_TIMERS > timers) || (TIMER_TABLE_MAX < (unsigned long) timers)) {
+		argparse_usage(&argparse);
+		rv = -1;
+	} else if (!APPLOG_Init()) {
+		fprintf(stderr, "Couldn't initialize the log component\n");
+		rv = -1;
+	} else {
+		APPLOG_SetLogLevel(LOGLV_WARNING | LOGLV_ERROR | LOGLV_CRITICAL);
+		fprintf(stderr, "%-6s %-8s %8s %10s %10s %10s %10s\n",
+				"sched", "dist", "timers", "arm ns", "rearm ns", "cancel ns", "fire ns");
+
+		snprintf(backends, sizeof(backends), "%s", backend_list);
+		for (p_backend = strtok_r(backends, ",", &p_save_backend); (NULL != p_backend) && (0 == rv);
+				p_backend = strtok_r(NULL, ",", &p_save_backend)) {
+			for (backend = 0; backend < TIMER_BACKEND_SENTINEL; backend++) {
+				if (0 == strcmp(p_backend, TIMERSCHED_backend_names[backend])) {
+					break;
+				}
+			}
+			if ((TIMER_BACKEND_SENTINEL == backend) || !TIMER_SetBackend(backend) || !TIMER_Init()) {
+				fprintf(stderr, "Unknown or failing backend: %s\n", p_backend);
+				rv = -1;
+				break;
+			}
+
+			snprintf(dists, sizeof(dists), "%s", dist_list);
+			for (p_dist = strtok_r(dists, ",", &p_save_dist); (NULL != p_dist) && (0 == rv);
+					p_dist = strtok_r(NULL, ",", &p_save_dist)) {
+				for (dist = 0; dist < TIMERSCHED_DIST_SENTINEL; dist++) {
+					if (0 == strcmp(p_dist, TIMERSCHED_dist_names[dist])) {
+						break;
+					}
+				}
+				if (TIMERSCHED_DIST_SENTINEL == dist) {
+					fprintf(stderr, "Unknown distribution: %s\n", p_dist);
+					rv = -1;
+				} else if (!TIMERSCHED_Run(backend, dist, timers)) {
+					rv = -1;
+				}
+			}
+			TIMER_Breakdown();
+		}
+	}
+	APPLOG_Breakdown();
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static bool TIMERSCHED_Run(const enum TIMER_BACKEND_E backend, const enum TIMERSCHED_DIST_E dist,
+		const uint32_t max_timers)
+{
+	timer_t* p_timers = calloc(max_timers, sizeof(timer_t));
+	int64_t* p_delays = malloc(max_timers * sizeof(int64_t));
+	int64_t* p_fire = malloc(max_timers * sizeof(int64_t));
+	struct itimerspec value;
+	struct timespec start;
+	struct timespec end;
+	double arm;
+	double rearm;
+	double cancel;
+	double fire;
+	double x;
+	int64_t cpu;
+	uint32_t count;
+	uint32_t i;
+	bool rv = true;
+
+	if ((NULL == p_timers) || (NULL == p_delays) || (NULL == p_fire)) {
+		fprintf(stderr, "Out of memory\n");
+		rv = false;
+	}
+	for (count = TIMERSCHED_MIN_TIMERS; rv && (count <= max_timers); count *= 10) {
+		for (i = 0; i < count; i++) {
+			x = (double) rand() / RAND_MAX;
+			if (TIMERSCHED_LOG == dist) {
+				p_delays[i] = (int64_t) (TIMERSCHED_dist_min[dist] * (1 << (rand() % TIMERSCHED_LOG_OCTAVES)) * (1.0 + x));
+			} else {
+				p_delays[i] = (int64_t) (TIMERSCHED_dist_min[dist] + x * (TIMERSCHED_dist_max[dist] - TIMERSCHED_dist_min[dist]));
+			}
+			p_fire[i] = (int64_t) (p_delays[i] * (TIMERSCHED_FIRE_SPAN / TIMERSCHED_dist_max[dist]));
+			if (0 != TIMER_CreateClockTimer(&p_timers[i], CLOCK_MONOTONIC, NULL, TIMERSCHED_Elapsed)) {
+				rv = false;
+				break;
+			}
+		}
+
+		if (rv) {
+			arm = TIMERSCHED_Arm(p_timers, p_delays, count, TIMERSCHED_LEAD);
+			rearm = TIMERSCHED_Arm(p_timers, p_delays, count, TIMERSCHED_LEAD);
+
+			memset(&value, 0, sizeof(value));
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			for (i = 0; i < count; i++) {
+				rv = rv && (0 == TIMER_SetTimeSpec(p_timers[i], 0, &value));
+			}
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			cancel = (double) TIMERSCHED_Diff(&start, &end) / count;
+
+			/* a lead of twice the arming time keeps the arming out of the fire time */
+			atomic_store(&TIMERSCHED_fired, 0);
+			fire = TIMERSCHED_Arm(p_timers, p_fire, count, (int64_t) (2 * arm * count) + 10000000);
+			cpu = TIMERSCHED_Cpu();
+			while (atomic_load(&TIMERSCHED_fired) < count) {
+				usleep(1000);
+			}
+			fire = (double) (TIMERSCHED_Cpu() - cpu) / count;
+
+			rv = rv && (0 <= arm) && (0 <= rearm);
+			if (rv) {
+				fprintf(stderr, "%-6s %-8s %8u %10.1f %10.1f %10.1f %10.1f\n", TIMERSCHED_backend_names[backend],
+						TIMERSCHED_dist_names[dist], count, arm, rearm, cancel, fire);
+			}
+		}
+		for (i = 0; i < count; i++) {
+			if (NULL != p_timers[i]) {
+				TIMER_DisposeTimer(p_timers[i]);
+				p_timers[i] = NULL;
+			}
+		}
+	}
+	free(p_fire);
+	free(p_delays);
+	free(p_timers);
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static double TIMERSCHED_Arm(const timer_t* const p_timers, const int64_t* const p_delays,
+		const uint32_t count, const int64_t lead)
+{
+	struct itimerspec value;
+	struct timespec start;
+	struct timespec end;
+	double rv = -1.0;
+	uint32_t i;
+
+	memset(&value, 0, sizeof(value));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; i++) {
+		value.it_value.tv_sec = (lead + p_delays[i]) / 1000000000L;
+		value.it_value.tv_nsec = (lead + p_delays[i]) % 1000000000L;
+		if (0 != TIMER_SetTimeSpec(p_timers[i], 0, &value)) {
+			break;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if ((i == count) && (0 != count)) {
+		rv = (double) TIMERSCHED_Diff(&start, &end) / count;
+	}
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static void TIMERSCHED_Elapsed(const struct TIMER_EVENT_S* const p_event)
+{
+	(void) p_event;
+	atomic_fetch_add(&TIMERSCHED_fired, 1);
+}
+
+/* ------------------------------------------------------------------------- */
+static int64_t TIMERSCHED_Diff(const struct timespec* const p_start, const struct timespec* const p_end)
+{
+	return (int64_t)(p_end->tv_sec - p_start->tv_sec) * 1000000000 + (p_end->tv_nsec - p_start->tv_nsec);
+}
+
+/* ------------------------------------------------------------------------- */
+static int64_t TIMERSCHED_Cpu(void)
+{
+	struct rusage usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+	return ((int64_t) usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000
+			+ ((int64_t) usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000;
+}
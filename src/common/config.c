@@ -60,6 +60,16 @@ static const char* APPCFG_StrnFirstAlnum(const char* const str, const size_t n);
   */
 static int APPCFG_SanitizeEndOfStrn(char* const str, const size_t n);
 
+ /**
+  * @brief Get the number string of a parameter
+  * @param[in] filename the filename where to find the param and its value
+  * @param[in] param the parameter to look for
+  * @param[out] num_str the number string, not empty on success
+  * @param[in] max_len the size of num_str
+  * @return 0 on success, APPCFG_NOT_FOUND if the parameter isn't set, -1 on failure
+  */
+static int APPCFG_GetNumberString(const char* const filename, const char* const param, char* const num_str, const size_t max_len);
+
 /* ----------------------------------------------------------------------
  * variable with internal linkage (static) definition section
  * ----------------------------------------------------------------------*/
@@ -180,10 +190,143 @@ int APPCFG_GetConfigNumericParamFromFile(
 	return rv;
 }
 
+int APPCFG_GetConfigStringParamFromFile(
+	const char* const filename,
+	const char* const param,
+	char* const out_value,
+	const size_t max_out_len)
+{
+	static const char* fn = __FUNCTION__;
+	int rv = APPCFG_NOT_FOUND;
+	FILE* fp = NULL;
+	char line[APPCFG_LINE_SIZE];
+	size_t param_len;
+	char* p_value;
+	char* p_end;
+
+	if ((NULL == filename) || (NULL == param) || (NULL == out_value) || (0 == max_out_len)) {
+		APPLOG_Log(fn, LOGLV_ERROR, "Null filename, param or value!!");
+		rv = -1;
+	}
+	else if (NULL == (fp = fopen(filename, "r"))) {
+		APPLOG_Log(fn, LOGLV_ERROR, "Failed opening %s: %s!!", filename, strerror(errno));
+		rv = -1;
+	}
+	else {
+		param_len = strlen(param);
+		while ((APPCFG_NOT_FOUND == rv) && fgets(line, sizeof(line), fp)) {
+			for (p_value = line; (' ' == *p_value) || ('\t' == *p_value); p_value++) {
+				;
+			}
+			if ((0 != strncmp(p_value, param, param_len)) || ('=' != p_value[param_len])) {
+				continue;
+			}
+			p_end = p_value + strlen(p_value);
+			if ((line + sizeof(line) - 1 == p_end) && ('\n' != p_end[-1]) && !feof(fp)) {
+				APPLOG_Log(fn, LOGLV_ERROR, "%s line too long in %s: %d allowed", param, filename, (int) sizeof(line) - 2);
+				rv = -1;
+				break;
+			}
+			for (p_value += param_len + 1; isblank((unsigned char) *p_value); p_value++) {
+				;
+			}
+			while ((p_end > p_value) && isspace((unsigned char) p_end[-1])) {
+				p_end--;
+			}
+			if ((size_t) (p_end - p_value) >= max_out_len) {
+				APPLOG_Log(fn, LOGLV_ERROR, "%s value too long in %s: length is %d - %d allowed",
+						param, filename, (int) (p_end - p_value), (int) max_out_len - 1);
+				rv = -1;
+			}
+			else {
+				memcpy(out_value, p_value, p_end - p_value);
+				out_value[p_end - p_value] = '\0';
+				APPLOG_LogDebug(fn, LOGBIT_OCCLI, "%s is %s", param, out_value);
+				rv = 0;
+			}
+		}
+		fclose(fp);
+	}
+
+	return rv;
+}
+
+int APPCFG_GetConfigInt64ParamFromFile(
+	const char* const filename,
+	const char* const param,
+	int64_t* const p_value)
+{
+	static const char* fn = __FUNCTION__;
+	char num_str[32];
+	long long num;
+	char* p_end;
+	int rv;
+
+	if (NULL == p_value) {
+		APPLOG_Log(fn, LOGLV_ERROR, "Null value!!");
+		rv = -1;
+	}
+	else if (0 == (rv = APPCFG_GetNumberString(filename, param, num_str, sizeof(num_str)))) {
+		errno = 0;
+		num = strtoll(num_str, &p_end, 0);
+		if ((0 != errno) || ('\0' != *p_end)) {
+			APPLOG_Log(fn, LOGLV_ERROR, "Illegal number for %s: %s", param, num_str);
+			rv = -1;
+		}
+		else {
+			*p_value = num;
+		}
+	}
+
+	return rv;
+}
+
+int APPCFG_GetConfigUint64ParamFromFile(
+	const char* const filename,
+	const char* const param,
+	uint64_t* const p_value)
+{
+	static const char* fn = __FUNCTION__;
+	char num_str[32];
+	unsigned long long num;
+	char* p_end;
+	int rv;
+
+	if (NULL == p_value) {
+		APPLOG_Log(fn, LOGLV_ERROR, "Null value!!");
+		rv = -1;
+	}
+	else if (0 == (rv = APPCFG_GetNumberString(filename, param, num_str, sizeof(num_str)))) {
+		/* strtoull would take "-1" for all bits set */
+		errno = 0;
+		num = strtoull(num_str, &p_end, 0);
+		if ((0 != errno) || ('\0' != *p_end) || ('-' == num_str[0])) {
+			APPLOG_Log(fn, LOGLV_ERROR, "Illegal number for %s: %s", param, num_str);
+			rv = -1;
+		}
+		else {
+			*p_value = num;
+		}
+	}
+
+	return rv;
+}
+
 /* ----------------------------------------------------------------------
  * functions with internal linkage (static) definition section
  * ----------------------------------------------------------------------*/
 
+static int APPCFG_GetNumberString(const char* const filename, const char* const param, char* const num_str, const size_t max_len)
+{
+	int rv = APPCFG_GetConfigStringParamFromFile(filename, param, num_str, max_len);
+
+	/* "PARAM=" leaves the default */
+	if ((0 == rv) && ('\0' == num_str[0])) {
+		rv = APPCFG_NOT_FOUND;
+	}
+	return rv;
+}
+
 static const char* APPCFG_StrnFirstAlnum(const char* const str, const size_t n)
 {
 	static const char* fn = __FUNCTION__;
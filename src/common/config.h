@@ -14,6 +14,8 @@
  * include section
  * ----------------------------------------------------------------------*/
 /* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stddef.h>
+#include <stdint.h>
 
 /* project specific includes (Diaser IG) - if possible alphabetically ordered */
 
@@ -70,6 +72,61 @@ int APPCFG_GetConfigNumericParamFromFile(
 	void* const out_value,
 	const size_t value_length);
 
+/**
+ * @brief Get a configuration parameter as it is written
+ * @details
+ * The value runs from after "param=" to the end of the line, without the
+ * blanks around it: paths keep their leading '/', their '_' and '-'. The
+ * parameter must start its line, after blanks. A parameter that is not in
+ * the file is not an error and isn't logged, so optional parameters can be
+ * probed quietly.
+ * @param[in] filename the filename where to find the param and its value
+ * @param[in] param the parameter to look for
+ * @param[out] out_value the address where to store the value string
+ * @param[in] max_out_len the size of out_value, with its terminating null
+ * @pre[tested] filename, param and out_value must not be null
+ * @pre[tested] filename must open(read) correctly
+ * @return 0 on success, APPCFG_NOT_FOUND if the parameter isn't in the file, -1 on failure
+ */
+int APPCFG_GetConfigStringParamFromFile(
+	const char* const filename,
+	const char* const param,
+	char* const out_value,
+	const size_t max_out_len);
+
+/**
+ * @brief Get a signed numeric configuration parameter
+ * @details
+ * Decimal, or hexadecimal with 0x; negative values are allowed. Like
+ * APPCFG_GetConfigStringParamFromFile, a missing or empty parameter is not
+ * logged.
+ * @param[in] filename the filename where to find the param and its value
+ * @param[in] param the parameter to look for
+ * @param[out] p_value the address where to store the value
+ * @pre[tested] p_value must not be null
+ * @return 0 on success, APPCFG_NOT_FOUND if the parameter isn't set, -1 on failure
+ */
+int APPCFG_GetConfigInt64ParamFromFile(
+	const char* const filename,
+	const char* const param,
+	int64_t* const p_value);
+
+/**
+ * @brief Get an unsigned numeric configuration parameter, a bit mask e.g.
+ * @details
+ * Decimal, or hexadecimal with 0x; all 64 bits can be set, negative values
+ * are refused. A missing or empty parameter is not logged.
+ * @param[in] filename the filename where to find the param and its value
+ * @param[in] param the parameter to look for
+ * @param[out] p_value the address where to store the value
+ * @pre[tested] p_value must not be null
+ * @return 0 on success, APPCFG_NOT_FOUND if the parameter isn't set, -1 on failure
+ */
+int APPCFG_GetConfigUint64ParamFromFile(
+	const char* const filename,
+	const char* const param,
+	uint64_t* const p_value);
+
 /* ----------------------------------------------------------------------
  * exported variables declaration section
  * ----------------------------------------------------------------------*/
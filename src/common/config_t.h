@@ -23,6 +23,9 @@
  * macro declaration section
  * ----------------------------------------------------------------------*/
 
+#define APPCFG_NOT_FOUND (1)      /**< A getter's return: the parameter is not in the file, or empty */
+#define APPCFG_LINE_SIZE (512)    /**< Longest config file line, with its end */
+
 /* ----------------------------------------------------------------------
  * type declaration section
  * ----------------------------------------------------------------------*/
@@ -12,16 +12,31 @@
  * ----------------------------------------------------------------------*/
 /* general includes (unix a.o.) - if possible alphabetically ordered */
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
-#include <sys/time.h>
 #include <time.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 /* project specific includes - if possible alphabetically ordered */
+#include "config.h"
 
 /* module specific includes (log) - if possible alphabetically ordered */
+#include "logfile.h"
+#include "logflight.h"
+#include "logfmt.h"
+#include "logring.h"
+#include "logsink.h"
+#include "logtime.h"
 
 /* component include */
 #include "log.h"
@@ -34,7 +49,7 @@
 #define APPLOG_DEFAULT_LEVEL_BITS (LOGLV_INFO |  LOGLV_DEBUG | LOGLV_WARNING | LOGLV_ERROR | LOGLV_CRITICAL | LOGLV_TEST)
 
 /** The default debug bits combination */
-#define APPLOG_DEFAULT_DEBUG_BITS (	LOGBIT_UNDEFINED);
+#define APPLOG_DEFAULT_DEBUG_BITS (	LOGBIT_UNDEFINED)
 
 #define ANSI_COLOR_RED     "\x1b[91m"
 #define ANSI_COLOR_GREEN   "\x1b[92m"
@@ -50,275 +65,3247 @@
 #define APPLOG_RESOURCE_IDLE (1)
 
 /**
- * @brief Semaphore value
+ * @brief Number of record slots of the asynchronous ring (power of two)
+ */
+#define APPLOG_RING_CAPACITY (512)
+
+/**
+ * @brief Ring slots the writer frees before it wakes the waiting producers
+ * up: one by one, every slot would cost them a context switch
+ */
+#define APPLOG_SPACE_BATCH (32)
+
+/**
+ * @brief Max time the writer thread sleeps before re-checking the ring (ms)
+ */
+#define APPLOG_WRITER_IDLE_MS (100)
+
+/**
+ * @brief Ring slot tags: what the payload of a slot holds
+ */
+#define APPLOG_SLOT_TEXT     (0) /**< a rendered line */
+#define APPLOG_SLOT_DEFERRED (1) /**< a struct LOGFMT_RECORD_S */
+
+/**
+ * @brief Ring slot tag: the payload kind (low half) and the line level
+ * for the sinks (high half)
+ */
+#define APPLOG_SLOT_TAG(kind, level) ((uint32_t)(kind) | ((uint32_t)(level) << 16))
+#define APPLOG_SLOT_KIND(tag)        ((tag) & 0xFFFF)
+#define APPLOG_SLOT_LEVEL(tag)       ((uint16_t)((tag) >> 16))
+
+/**
+ * @brief Entries of a level prefix table: one per LOGLV_xxx bit (index of
+ * the bit), the unknown level and the APPLOG_LogDebug records
+ */
+#define APPLOG_PREFIX_UNKNOWN    (6)
+#define APPLOG_PREFIX_DEBUG_BITS (7)
+#define APPLOG_PREFIX_COUNT      (8)
+
+/**
+ * @brief Level prefix table entry initializer
+ */
+#define APPLOG_PREFIX(text) { text, sizeof(text) - 1 }
+
+/**
+ * @brief Size of the line buffer used to render a deferred record
+ */
+#define APPLOG_RENDER_SIZE (1024)
+
+/* log file configuration parameters (config.cfg) */
+#define APPLOG_CFG_FILE           "LOG_FILE"                /**< path, empty for the console */
+#define APPLOG_CFG_SEGMENT_SIZE   "LOG_FILE_SEGMENT_SIZE"   /**< bytes per segment */
+#define APPLOG_CFG_ROTATE_SECONDS "LOG_FILE_ROTATE_SECONDS" /**< max segment age, 0 for none */
+#define APPLOG_CFG_MAX_SEGMENTS   "LOG_FILE_MAX_SEGMENTS"   /**< rotated segments kept */
+#define APPLOG_CFG_SYNC_BYTES     "LOG_FILE_SYNC_BYTES"     /**< bytes between two msync */
+#define APPLOG_CFG_COMPRESS       "LOG_FILE_COMPRESS"       /**< 1 to compress the rotated segments */
+#define APPLOG_CFG_INDEX_LINES    "LOG_FILE_INDEX_LINES"    /**< lines per mark of the segment index, 0 for none */
+#define APPLOG_CFG_RATE_LIMIT     "LOG_RATE_LIMIT"          /**< messages per second per statement, 0 for none */
+#define APPLOG_CFG_RATE_BURST     "LOG_RATE_BURST"          /**< messages at once per statement */
+#define APPLOG_CFG_COLLAPSE       "LOG_COLLAPSE_REPEATS"    /**< 1 to count repeated messages per statement */
+#define APPLOG_CFG_CRASH_FILE     "LOG_CRASH_FILE"          /**< flight recorder dump, empty for none */
+#define APPLOG_CFG_CRASH_RECORDS  "LOG_CRASH_RECORDS"       /**< records kept by the flight recorder */
+#define APPLOG_CFG_LEVEL          "LOG_LEVEL"               /**< LOGLV_xxx bits (decimal) */
+#define APPLOG_CFG_DEBUG_BITS     "LOG_DEBUG_BITS"          /**< LOGBIT_xxx bits (decimal) */
+#define APPLOG_CFG_BACKPRESSURE   "LOG_BACKPRESSURE"        /**< block, timed, drop or overwrite */
+#define APPLOG_CFG_BP_TIMEOUT_MS  "LOG_BACKPRESSURE_TIMEOUT_MS" /**< max wait of the timed policy (ms) */
+#define APPLOG_CFG_CONSOLE_LEVELS "LOG_CONSOLE_LEVELS"      /**< LOGLV_xxx bits of the console (decimal) */
+#define APPLOG_CFG_FILE_LEVELS    "LOG_FILE_LEVELS"         /**< LOGLV_xxx bits of the log file (decimal) */
+#define APPLOG_CFG_SOCKET         "LOG_SOCKET"              /**< UNIX datagram socket, empty for none */
+#define APPLOG_CFG_SOCKET_LEVELS  "LOG_SOCKET_LEVELS"       /**< LOGLV_xxx bits of the socket (decimal) */
+#define APPLOG_CFG_MEMORY_RECORDS "LOG_MEMORY_RECORDS"      /**< lines kept in memory, 0 for none */
+#define APPLOG_CFG_MEMORY_LEVELS  "LOG_MEMORY_LEVELS"       /**< LOGLV_xxx bits of the memory output (decimal) */
+#define APPLOG_CFG_WRITER_CPUS    "LOG_WRITER_CPUS"         /**< CPU bits of the writer thread (0x hex), 0 for any */
+#define APPLOG_CFG_WRITER_POLICY  "LOG_WRITER_POLICY"       /**< other or idle */
+#define APPLOG_CFG_WRITER_NICE    "LOG_WRITER_NICE"         /**< nice value of the writer thread */
+
+/* log file defaults, used for the parameters missing in config.cfg */
+#define APPLOG_DEFAULT_SEGMENT_SIZE   (4 * 1024 * 1024)
+#define APPLOG_DEFAULT_ROTATE_SECONDS (0)
+#define APPLOG_DEFAULT_MAX_SEGMENTS   (4)
+#define APPLOG_DEFAULT_SYNC_BYTES     (64 * 1024)
+
+/* rate limiter defaults, used for the parameters missing in config.cfg (none until then) */
+#define APPLOG_DEFAULT_RATE_LIMIT (0)
+#define APPLOG_DEFAULT_RATE_BURST (20)
+
+/**
+ * @brief Levels never dropped by the rate limiter: faults are what a burst
+ * is about
+ */
+#define APPLOG_RATE_EXEMPT_LEVELS (LOGLV_ERROR | LOGLV_CRITICAL)
+
+/* flight recorder defaults */
+#define APPLOG_DEFAULT_CRASH_RECORDS (256)
+
+/**
+ * @brief Size of the file names kept by the component
+ */
+#define APPLOG_FILENAME_SIZE (200)
+
+/**
+ * @brief Clock of the rate limiters, a few ms resolution is plenty
+ */
+#define APPLOG_SITE_CLOCKID CLOCK_MONOTONIC_COARSE
+
+/**
+ * @brief Max number of ms a "last message repeated" line is held back, and
+ * after which a repeated message is printed again
+ */
+#define APPLOG_REPEAT_HOLD_MS (1000)
+
+/**
+ * @brief Size of the captured arguments compared to find repeated messages;
+ * messages with more aren't collapsed
+ */
+#define APPLOG_REPEAT_ARGS_SIZE (256)
+
+/**
+ * @brief Size of the per-thread staging buffer
+ */
+#define APPLOG_STAGE_SIZE (16 * 1024)
+
+/**
+ * @brief Max number of lines in a staging buffer
+ */
+#define APPLOG_STAGE_LINES (512)
+
+/**
+ * @brief Max age of a staged line before it is written (ms)
+ */
+#define APPLOG_STAGE_AGE_MS (100)
+
+/**
+ * @brief Max number of staging buffers written by one writev
+ */
+#define APPLOG_STAGE_IOV_MAX (64)
+
+/**
+ * @brief Levels whose lines are written without staging delay
+ */
+#define APPLOG_STAGE_URGENT_LEVELS (LOGLV_ERROR | LOGLV_CRITICAL)
+
+/**
+ * @brief Levels never dropped by the backpressure policy: instead of being
+ * dropped they wait for the output, as with APPLOG_BACKPRESSURE_BLOCK
+ */
+#define APPLOG_BP_EXEMPT_LEVELS (LOGLV_ERROR | LOGLV_CRITICAL)
+
+/**
+ * @brief Default max wait of the timed backpressure policy (ms)
+ */
+#define APPLOG_DEFAULT_BP_TIMEOUT_MS (5)
+
+/**
+ * @brief Size of a backpressure policy name
+ */
+#define APPLOG_BP_NAME_SIZE (16)
+
+/**
+ * @brief Number of CPUs APPLOG_THREAD_S can select
+ */
+#define APPLOG_CPU_MAX (64)
+
+/**
+ * @brief Nice value range of the writer thread
+ */
+#define APPLOG_NICE_MIN (-20)
+#define APPLOG_NICE_MAX (19)
+
+/**
+ * @brief Levels of a log output taking every line
  */
-#define APPLOG_RESOURCE_BUSY (0)
+#define APPLOG_SINK_ALL_LEVELS ((uint64_t)LOGSINK_LEVEL_ANY)
 
 /* ----------------------------------------------------------------------
  * internal type declaration section
  * ----------------------------------------------------------------------*/
 
-/* ----------------------------------------------------------------------
- * function with internal linkage (static) declaration section
- * ----------------------------------------------------------------------*/
+/**
+ * @brief The pre-rendered part of a line between the time reference and
+ * the function name
+ */
+struct APPLOG_PREFIX_S {
+	const char* text;  /**< ") [LEVEL] " */
+	size_t len;        /**< strlen(text) */
+};
+
+/**
+ * @brief A callsite and its calls at the time of a report
+ */
+struct APPLOG_HOT_SITE_S {
+	const struct APPLOG_SITE_S* p_site;  /**< The callsite */
+	uint64_t hits;                       /**< Its calls */
+};
+
+/**
+ * @brief The staging buffer of the rendered lines of one thread
+ * @details
+ * The owner appends under mutex without touching shared state; the buffer
+ * reaches the output when it is full, too old, holds an urgent line or the
+ * component breaks down. The flusher thread writes the aged buffers of idle
+ * threads, several at once with one writev.
+ */
+struct APPLOG_STAGE_S {
+	pthread_mutex_t mutex;                 /**< Owner vs flusher */
+	struct APPLOG_STAGE_S* p_next;         /**< Next in APPLOG_stages */
+	int64_t since;                         /**< When the first staged line arrived (ns, APPLOG_SITE_CLOCKID) */
+	size_t len;                            /**< Number of staged characters */
+	uint32_t n_lines;                      /**< Number of staged lines */
+	uint64_t levels;                       /**< Levels of the staged lines or'ed */
+	struct LOGSINK_LINE_S lines[APPLOG_STAGE_LINES]; /**< Ends and levels of the staged lines */
+	char buf[APPLOG_STAGE_SIZE];           /**< The staged lines */
+};
+
+/* ----------------------------------------------------------------------
+ * function with internal linkage (static) declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Format time reference, function name and log level
+ * @param[out] buf the text buffer
+ * @param[in] size the size of buf
+ * @param[in] p_ts the time reference (LOGTIME_CLOCKID)
+ * @param[in] fn the function name
+ * @param[in] p_prefix the level prefix
+ * @pre[untested] fn must point to a valid function string
+ * @return the number of characters written in buf
+ */
+static size_t APPLOG_TimeNCo(
+		char* const buf,
+		const size_t size,
+		const struct timespec* const p_ts,
+		const char* fn,
+		const struct APPLOG_PREFIX_S* const p_prefix);
+
+/**
+ * @brief Look up the level prefix of a record
+ * @param[in] level the log level
+ * @param[in] flags the LOGFMT_FLAG_xxx of the record
+ * @return the prefix in the table selected by APPLOG_SetColor
+ */
+static const struct APPLOG_PREFIX_S* APPLOG_Prefix(const uint64_t level, const uint16_t flags);
+
+/**
+ * @brief Append text to a nul-terminated buffer, cutting what doesn't fit
+ * @param[in, out] buf the buffer
+ * @param[in] size the size of buf
+ * @param[in] len the current length of the text in buf
+ * @param[in] text the text to append
+ * @param[in] text_len the length of text
+ * @return the new length of the text in buf
+ */
+static size_t APPLOG_Append(
+		char* const buf,
+		const size_t size,
+		const size_t len,
+		const char* const text,
+		const size_t text_len);
+
+/**
+ * @brief Deliver one record according to the active mode
+ * @param[in] fn the function name
+ * @param[in] level the log level
+ * @param[in] flags the LOGFMT_FLAG_xxx of the record
+ * @param[in] fmt the printf-like format
+ * @param[in] args the arguments of fmt
+ */
+static void APPLOG_Output(
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags,
+		const char* fmt,
+		va_list args);
+
+/**
+ * @brief Render a record into a line
+ * @param[out] buf the buffer
+ * @param[in] size the size of buf (> 1)
+ * @param[in] fn the function name
+ * @param[in] p_prefix the level prefix
+ * @param[in] fmt the printf-like format
+ * @param[in] args the arguments of fmt
+ * @return the length of the line, '\n' included
+ */
+static size_t APPLOG_Render(
+		char* const buf,
+		const size_t size,
+		const char* fn,
+		const struct APPLOG_PREFIX_S* const p_prefix,
+		const char* fmt,
+		va_list args);
+
+/**
+ * @brief Render a record for the flight recorder only
+ * @param[in] fn the function name
+ * @param[in] p_prefix the level prefix
+ * @param[in] fmt the printf-like format
+ * @param[in] args the arguments of fmt
+ */
+static void APPLOG_FlightRecord(
+		const char* fn,
+		const struct APPLOG_PREFIX_S* const p_prefix,
+		const char* fmt,
+		va_list args);
+
+/**
+ * @brief Stop the flight recorder and remove its (unused) dump file
+ */
+static void APPLOG_StopFlightRecorder(void);
+
+/**
+ * @brief Dump the flight recorder on a fatal signal, then let the signal
+ * take its former course
+ * @param[in] sig the signal number
+ * @details
+ * Async-signal-safe: only write(2) to the dump file opened in advance.
+ */
+static void APPLOG_CrashHandler(int sig);
+
+/**
+ * @brief Ask the reload thread to reload the configuration file
+ * @param[in] sig the signal number (SIGUSR1)
+ * @details
+ * Async-signal-safe: only sem_post(3).
+ */
+static void APPLOG_ReloadHandler(int sig);
+
+/**
+ * @brief The reload thread: APPLOG_LoadConfig on every SIGUSR1
+ * @param[in] p_arg unused
+ * @return NULL
+ */
+static void* APPLOG_Reloader(void* p_arg);
+
+/**
+ * @brief Stop the reload thread and restore the SIGUSR1 handler
+ */
+static void APPLOG_StopReloader(void);
+
+/**
+ * @brief Capture one record in a ring slot, leaving the formatting to the writer
+ * @param[in] fn the function name
+ * @param[in] level the log level
+ * @param[in] flags the LOGFMT_FLAG_xxx of the record
+ * @param[in] fmt the printf-like format
+ * @param[in] args the arguments of fmt
+ */
+static void APPLOG_PushDeferred(
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags,
+		const char* fmt,
+		va_list args);
+
+/**
+ * @brief Wake up the writer thread if it announced it is idle
+ */
+static void APPLOG_WakeWriter(void);
+
+/**
+ * @brief Wake up the producers waiting for a free ring slot, if any
+ * @pre called by the writer thread after releasing slots
+ */
+static void APPLOG_WakeProducer(void);
+
+/**
+ * @brief Format one record into a ring slot and publish it to the writer
+ * @param[in] fn the function name
+ * @param[in] p_prefix the level prefix
+ * @param[in] line_level the level for the log outputs, refer to APPLOG_LineLevel
+ * @param[in] fmt the printf-like format
+ * @param[in] args the arguments of fmt
+ */
+static void APPLOG_PushRecord(
+		const char* fn,
+		const struct APPLOG_PREFIX_S* const p_prefix,
+		const uint16_t line_level,
+		const char* fmt,
+		va_list args);
+
+/**
+ * @brief Start the asynchronous delivery (ring and writer thread)
+ * @return true on success, false otherwise
+ */
+static bool APPLOG_StartWriter(void);
+
+/**
+ * @brief Flush the ring, stop the writer thread and release the ring
+ */
+static void APPLOG_StopWriter(void);
+
+/**
+ * @brief Format and print through APPLOG_Output
+ * @param[in] fn the function name
+ * @param[in] level the log level
+ * @param[in] flags the LOGFMT_FLAG_xxx
+ * @param[in] fmt, ... the format and its arguments (printf-like)
+ */
+static void APPLOG_OutputF(
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags,
+		const char* fmt, ...);
+
+/**
+ * @brief Body of APPLOG_Log and APPLOG_SiteLog
+ * @param[in, out] p_site the callsite, NULL for no rate limit
+ * @param[in] fn the function name
+ * @param[in] level the log level
+ * @param[in] fmt the format
+ * @param[in] args the arguments
+ */
+static void APPLOG_VLog(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t level,
+		const char* fmt,
+		va_list args);
+
+/**
+ * @brief Body of APPLOG_LogDebug and APPLOG_SiteLogDebug
+ * @param[in, out] p_site the callsite, NULL for no rate limit
+ * @param[in] fn the function name
+ * @param[in] bits the debug bits
+ * @param[in] fmt the format
+ * @param[in] args the arguments
+ */
+static void APPLOG_VLogDebug(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t bits,
+		const char* fmt,
+		va_list args);
+
+/**
+ * @brief Take a token from the rate limiter of a callsite
+ * @param[in, out] p_site the callsite, NULL for no rate limit
+ * @param[in] fn the function name
+ * @param[in] level the log level
+ * @param[in] flags the LOGFMT_FLAG_xxx
+ * @return true if the message may be printed, false if it is dropped
+ * @details
+ * A message let through is preceded by the number of messages dropped
+ * before it. APPLOG_RATE_EXEMPT_LEVELS are always let through.
+ */
+static bool APPLOG_SiteAdmit(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags);
+
+/**
+ * @brief Hold back a copy of the last message of a callsite
+ * @param[in, out] p_site the callsite, NULL for no collapsing (as without
+ * APPLOG_collapse)
+ * @param[in] fn the function name
+ * @param[in] level the log level
+ * @param[in] flags the LOGFMT_FLAG_xxx
+ * @param[in] fmt the format
+ * @param[in] args the arguments
+ * @return true if the message differs from the last one, false if it is
+ * counted as a repeat
+ * @details
+ * A different message is preceded by the number of copies held back
+ * before it. So is a copy arriving APPLOG_REPEAT_HOLD_MS after the last
+ * printed one: a periodic message is still printed every time. Without
+ * collapsing nothing is captured nor hashed.
+ */
+static bool APPLOG_SiteFresh(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags,
+		const char* fmt,
+		va_list args);
+
+/**
+ * @brief Link a callsite in APPLOG_sites, once
+ * @param[in, out] p_site the callsite
+ * @param[in] fn the function name
+ * @param[in] level the log level
+ * @param[in] flags the LOGFMT_FLAG_xxx
+ */
+static void APPLOG_ListSite(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags);
+
+/**
+ * @brief Print the messages still counted as dropped by the listed callsites
+ */
+static void APPLOG_ReportSuppressed(void);
+
+/**
+ * @brief Print the "last message repeated" lines of the listed callsites
+ * @param[in] all true for all held back copies, false for those held back
+ * longer than APPLOG_REPEAT_HOLD_MS only
+ */
+static void APPLOG_ReportRepeats(const bool all);
+
+/**
+ * @brief Refresh the enabled flag of every callsite
+ * @pre the caller holds APPLOG_filter_mutex
+ */
+static void APPLOG_UpdateSites(void);
+
+/**
+ * @brief Order callsites by descending calls (qsort)
+ * @param[in] p_a the first struct APPLOG_HOT_SITE_S
+ * @param[in] p_b the second struct APPLOG_HOT_SITE_S
+ * @return < 0, 0 or > 0 as for qsort
+ */
+static int APPLOG_CompareHits(const void* p_a, const void* p_b);
+
+/**
+ * @brief The level of a line for the log outputs
+ * @param[in] level the LOGLV_xxx level of the record
+ * @return the level, LOGSINK_LEVEL_ANY if not a single known level
+ */
+static uint16_t APPLOG_LineLevel(const uint64_t level);
+
+/**
+ * @brief Stage a rendered line for the log outputs
+ * @param[in] text the line
+ * @param[in] len the number of characters
+ * @param[in] line_level the level for the log outputs, refer to APPLOG_LineLevel
+ * @param[in] urgent true to write the staged lines right away
+ * @pre the text starts with the LOGTIME_STR_LEN characters timestamp
+ */
+static void APPLOG_WriteOut(const char* const text, const size_t len, const uint16_t line_level, const bool urgent);
+
+/**
+ * @brief Write rendered lines to every log output of their levels
+ * @param[in] p_chunks the lines
+ * @param[in] count the number of chunks
+ * @pre APPLOG_output_mutex taken
+ */
+static void APPLOG_WriteChunks(const struct LOGSINK_CHUNK_S* const p_chunks, const int count);
+
+/**
+ * @brief Flush the staging buffer of the calling thread and the log output
+ */
+static void APPLOG_FlushOut(void);
+
+/**
+ * @brief The staging buffer of the calling thread, created on first use
+ * @return the staging buffer, NULL if it can't be created
+ */
+static struct APPLOG_STAGE_S* APPLOG_GetStage(void);
+
+/**
+ * @brief Create the key whose destructor releases the staging buffers
+ */
+static void APPLOG_CreateStageKey(void);
+
+/**
+ * @brief Write and release the staging buffer of an exiting thread
+ * @param[in] p_arg the staging buffer
+ */
+static void APPLOG_DropStage(void* p_arg);
+
+/**
+ * @brief Append a line to a staging buffer, writing it first when full
+ * @param[in, out] p_stage the staging buffer
+ * @param[in] text the line
+ * @param[in] len the number of characters, at most APPLOG_STAGE_SIZE
+ * @param[in] line_level the level for the log outputs
+ * @pre p_stage->mutex taken
+ */
+static void APPLOG_StageAppend(
+		struct APPLOG_STAGE_S* const p_stage,
+		const char* const text,
+		const size_t len,
+		const uint16_t line_level);
+
+/**
+ * @brief Write the staged lines of one staging buffer
+ * @param[in, out] p_stage the staging buffer
+ * @param[in] exempt true to wait for the busy output whatever the
+ * backpressure policy, refer to APPLOG_BP_EXEMPT_LEVELS
+ * @pre p_stage->mutex taken
+ * @return true if written (or empty), false if the backpressure policy
+ * gave up on the busy output
+ */
+static bool APPLOG_StageFlush(struct APPLOG_STAGE_S* const p_stage, const bool exempt);
+
+/**
+ * @brief Drop the oldest staged lines until a line of len characters fits
+ * @param[in, out] p_stage the staging buffer
+ * @param[in] len the number of characters to make room for
+ * @pre p_stage->mutex taken
+ */
+static void APPLOG_StageOverwrite(struct APPLOG_STAGE_S* const p_stage, const size_t len);
+
+/**
+ * @brief Take APPLOG_output_mutex as far as the backpressure policy allows
+ * @param[in] records the number of records waiting for it
+ * @param[in] exempt true to wait whatever the policy
+ * @return true if taken, false otherwise
+ */
+static bool APPLOG_TakeOutput(const uint32_t records, const bool exempt);
+
+/**
+ * @brief Reserve a ring slot as far as the backpressure policy allows
+ * @param[in] exempt true to wait for a slot unless the policy overwrites
+ * the oldest records
+ * @return the slot, NULL if the record is dropped
+ */
+static struct LOGRING_SLOT_S* APPLOG_ReserveSlot(const bool exempt);
+
+/**
+ * @brief Print the counters of the backpressure policy when not all zero
+ */
+static void APPLOG_ReportBackpressure(void);
+
+/**
+ * @brief A point in time some milliseconds from now
+ * @param[out] p_ts the point in time
+ * @param[in] clock_id the clock of p_ts
+ * @param[in] ms the milliseconds from now
+ */
+static void APPLOG_Deadline(struct timespec* const p_ts, const clockid_t clock_id, const uint32_t ms);
+
+/**
+ * @brief Apply the settings of APPLOG_SetWriterThread to the calling
+ * thread when they changed
+ * @param[in, out] p_gen the generation of the settings applied last
+ */
+static void APPLOG_ApplyThread(uint32_t* const p_gen);
+
+/**
+ * @brief Account one flush of the writer thread
+ * @param[in] depth the records queued at its start
+ * @param[in] ns its duration
+ */
+static void APPLOG_RecordFlush(const uint32_t depth, const uint64_t ns);
+
+/**
+ * @brief Print the queue and flush figures of the writer thread, if any
+ */
+static void APPLOG_ReportWriter(void);
+
+/**
+ * @brief Apply the writer thread settings of a configuration file
+ * @param[in] filename the configuration file
+ * @return true on success, false otherwise
+ */
+static bool APPLOG_LoadThreadConfig(const char* const filename);
+
+/**
+ * @brief Write the staged lines of every thread, batched in writev calls
+ * @param[in] all true for all lines (and the held back repeats), false
+ * for the buffers older than APPLOG_STAGE_AGE_MS only
+ */
+static void APPLOG_FlushStages(const bool all);
+
+/**
+ * @brief Write locked staging buffers at once and unlock them
+ * @param[in, out] p_stages the staging buffers
+ * @param[in] p_chunks their staged lines
+ * @param[in] count the number of staging buffers
+ */
+static void APPLOG_WriteStages(
+		struct APPLOG_STAGE_S** const p_stages,
+		const struct LOGSINK_CHUNK_S* const p_chunks,
+		const int count);
+
+/**
+ * @brief The clock of the staging age
+ * @return the time in ns (APPLOG_SITE_CLOCKID)
+ */
+static int64_t APPLOG_StageClock(void);
+
+/**
+ * @brief Start the thread flushing the aged staging buffers (sync mode)
+ * @return true on success, false otherwise
+ */
+static bool APPLOG_StartFlusher(void);
+
+/**
+ * @brief Stop the flusher thread
+ */
+static void APPLOG_StopFlusher(void);
+
+/**
+ * @brief Flusher thread: write the aged staging buffers and the held back
+ * repeat counts until stopped
+ * @param[in] p_arg unused
+ * @return NULL
+ */
+static void* APPLOG_Flusher(void* p_arg);
+
+/**
+ * @brief Apply the log file settings of a configuration file
+ * @param[in] filename the configuration file
+ * @return true on success, false otherwise
+ */
+static bool APPLOG_LoadFileConfig(const char* const filename);
+
+/**
+ * @brief Apply the socket and memory output settings of a configuration file
+ * @param[in] filename the configuration file
+ * @return true on success, false otherwise
+ */
+static bool APPLOG_LoadSinkConfig(const char* const filename);
+
+/**
+ * @brief Switch the log output to a (new) log file or back to the console
+ * @param[in] p_config the log file settings, an empty path for none
+ * @param[in] console_levels the levels of the console from then on
+ * @return true on success, false otherwise (the output is unchanged)
+ */
+static bool APPLOG_SetFileOutput(const struct LOGFILE_CONFIG_S* const p_config, const uint64_t console_levels);
+
+/**
+ * @brief Replace a log output, writing the staged lines to the former one
+ * @param[in] sink the log output
+ * @param[in] p_new the opened replacement, NULL to close the output
+ */
+static void APPLOG_SwapSink(const enum APPLOG_SINK_E sink, const struct LOGSINK_S* const p_new);
+
+/**
+ * @brief Write one ring slot to the output of the writer thread
+ * @param[in] p_slot the acquired slot
+ */
+static void APPLOG_WriteSlot(const struct LOGRING_SLOT_S* const p_slot);
+
+/**
+ * @brief Writer thread: drain the ring to the console until stopped
+ * @param[in] p_arg unused
+ * @return NULL
+ */
+static void* APPLOG_Writer(void* p_arg);
+
+/**
+ * @brief Publish the level and debug bits to the filters and to the
+ * callsites
+ * @pre the caller holds APPLOG_filter_mutex
+ */
+static void APPLOG_UpdateFilters(void);
+
+/* ----------------------------------------------------------------------
+ * variable with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+static _Atomic uint64_t APPLOG_level_bits = APPLOG_DEFAULT_LEVEL_BITS; /**< The current log level bits combination */
+static _Atomic uint64_t APPLOG_debug_bits = APPLOG_DEFAULT_DEBUG_BITS; /**< The current debug bits combination */
+
+/**
+ * @brief The log level bits currently enabled, all while the flight
+ * recorder runs (folded into the callsites)
+ */
+static _Atomic uint64_t APPLOG_log_filter = APPLOG_DEFAULT_LEVEL_BITS;
+
+/**
+ * @brief The debug bits currently enabled, 0 while LOGLV_DEBUG is disabled,
+ * all while the flight recorder runs (folded into the callsites)
+ */
+static _Atomic uint64_t APPLOG_debug_filter = (APPLOG_DEFAULT_LEVEL_BITS & LOGLV_DEBUG) ? APPLOG_DEFAULT_DEBUG_BITS : 0;
+
+/**
+ * @brief Serializes the changes of the bits and the filters derived from
+ * them (never taken on the log path)
+ */
+static pthread_mutex_t APPLOG_filter_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief The configuration file reloaded on SIGUSR1, refer to
+ * APPLOG_WatchConfig
+ */
+static char APPLOG_reload_filename[APPLOG_FILENAME_SIZE];
+
+/**
+ * @brief The thread reloading the configuration file
+ */
+static pthread_t APPLOG_reload_thread;
+
+/**
+ * @brief Posted by the SIGUSR1 handler to wake up the reload thread
+ */
+static sem_t APPLOG_reload_wakeup;
+
+/**
+ * @brief True while the reload thread runs
+ */
+static atomic_bool APPLOG_reload_running;
+
+/**
+ * @brief The SIGUSR1 handler replaced by APPLOG_ReloadHandler
+ */
+static struct sigaction APPLOG_reload_old_action;
+
+/**
+ * @brief State variable representing the initialized state of the component
+ */
+static bool APPLOG_is_init;
+
+/**
+ * @brief The level prefixes with ANSI colors
+ */
+static const struct APPLOG_PREFIX_S APPLOG_color_prefixes[APPLOG_PREFIX_COUNT] = {
+	APPLOG_PREFIX(") [" ANSI_COLOR_GREEN   "INFO"     ANSI_COLOR_RESET "] "),
+	APPLOG_PREFIX(") [" ANSI_COLOR_BLUE    "DEBUG"    ANSI_COLOR_RESET "] "),
+	APPLOG_PREFIX(") [" ANSI_COLOR_YELLOW  "WARNING"  ANSI_COLOR_RESET "] "),
+	APPLOG_PREFIX(") [" ANSI_COLOR_RED     "ERROR"    ANSI_COLOR_RESET "] "),
+	APPLOG_PREFIX(") [" ANSI_COLOR_RED     "CRITICAL" ANSI_COLOR_RESET "] "),
+	APPLOG_PREFIX(") [" ANSI_COLOR_MAGENTA "TEST"     ANSI_COLOR_RESET "] "),
+	APPLOG_PREFIX(") [????] "),
+	APPLOG_PREFIX(") [DEBUG] ")
+};
+
+/**
+ * @brief The level prefixes without colors
+ */
+static const struct APPLOG_PREFIX_S APPLOG_plain_prefixes[APPLOG_PREFIX_COUNT] = {
+	APPLOG_PREFIX(") [INFO] "),
+	APPLOG_PREFIX(") [DEBUG] "),
+	APPLOG_PREFIX(") [WARNING] "),
+	APPLOG_PREFIX(") [ERROR] "),
+	APPLOG_PREFIX(") [CRITICAL] "),
+	APPLOG_PREFIX(") [TEST] "),
+	APPLOG_PREFIX(") [????] "),
+	APPLOG_PREFIX(") [DEBUG] ")
+};
+
+/**
+ * @brief The level prefix table in use, refer to APPLOG_SetColor
+ */
+static const struct APPLOG_PREFIX_S* APPLOG_prefixes = APPLOG_color_prefixes;
+
+/**
+ * @brief The selected delivery mode
+ */
+static enum APPLOG_MODE_E APPLOG_mode = APPLOG_MODE_SYNC;
+
+/**
+ * @brief True while records are routed through the ring to the writer thread
+ */
+static atomic_bool APPLOG_async_active;
+
+/**
+ * @brief The ring between the producers and the writer thread
+ */
+static struct LOGRING_S APPLOG_ring;
+
+/**
+ * @brief The writer thread
+ */
+static pthread_t APPLOG_writer_thread;
+
+/**
+ * @brief Posted by producers to wake up an idle writer thread
+ */
+static sem_t APPLOG_writer_wakeup;
+
+/**
+ * @brief Cleared by APPLOG_Breakdown to stop the writer thread
+ */
+static atomic_bool APPLOG_writer_running;
+
+/**
+ * @brief Set by the writer thread before it waits on APPLOG_writer_wakeup
+ */
+static atomic_bool APPLOG_writer_sleeping;
+
+/**
+ * @brief Posted by the writer thread when it frees a ring slot while
+ * producers wait for one (block and timed backpressure)
+ */
+static sem_t APPLOG_space_wakeup;
+
+/**
+ * @brief Number of producers waiting on APPLOG_space_wakeup
+ */
+static atomic_uint APPLOG_space_waiters;
+
+/**
+ * @brief Number of records dropped because the ring was full
+ */
+static atomic_uint_fast64_t APPLOG_dropped_records;
+
+/**
+ * @brief Queued records dropped by APPLOG_BACKPRESSURE_OVERWRITE_OLDEST
+ */
+static atomic_uint_fast64_t APPLOG_overwritten_records;
+
+/**
+ * @brief Records that had to wait for the output
+ */
+static atomic_uint_fast64_t APPLOG_delayed_records;
+
+/**
+ * @brief The backpressure policy (APPLOG_BACKPRESSURE_E)
+ */
+static atomic_int APPLOG_backpressure = APPLOG_BACKPRESSURE_DROP_NEWEST;
+
+/**
+ * @brief The max wait of APPLOG_BACKPRESSURE_TIMED (ms)
+ */
+static atomic_uint APPLOG_bp_timeout_ms = APPLOG_DEFAULT_BP_TIMEOUT_MS;
+
+/**
+ * @brief The names of the backpressure policies, as in the configuration
+ */
+static const char* const APPLOG_bp_names[APPLOG_BACKPRESSURE_SENTINEL] = {
+	"block", "timed", "drop", "overwrite"
+};
+
+/**
+ * @brief The file receiving the binary stream in deferred mode, NULL for
+ * rendering to the console
+ */
+static char* APPLOG_binary_filename;
+
+/**
+ * @brief The binary stream (writer thread only)
+ */
+static FILE* APPLOG_binary_fp;
+
+/**
+ * @brief The string dictionary of the binary stream (writer thread only)
+ */
+static struct LOGFMT_DICT_S APPLOG_binary_dict;
+
+/**
+ * @brief Serializes the access to the log output and its replacement
+ */
+static sem_t APPLOG_output_mutex;
+
+/**
+ * @brief The log outputs, closed ones have no p_write (APPLOG_output_mutex)
+ */
+static struct LOGSINK_S APPLOG_sinks[APPLOG_SINK_SENTINEL];
+
+/**
+ * @brief The levels of the log outputs, kept while closed (APPLOG_output_mutex)
+ */
+static uint64_t APPLOG_sink_levels[APPLOG_SINK_SENTINEL] = {
+	APPLOG_SINK_ALL_LEVELS, APPLOG_SINK_ALL_LEVELS, APPLOG_SINK_ALL_LEVELS, APPLOG_SINK_ALL_LEVELS
+};
+
+/**
+ * @brief The path of the socket output, empty if none (APPLOG_output_mutex)
+ */
+static char APPLOG_socket_path[APPLOG_FILENAME_SIZE];
+
+/**
+ * @brief The number of lines of the memory output, 0 if none (APPLOG_output_mutex)
+ */
+static uint32_t APPLOG_memory_records;
+
+/**
+ * @brief The fatal signals dumping the flight recorder
+ */
+static const int APPLOG_crash_signals[] = { SIGSEGV, SIGBUS, SIGABRT };
+
+/**
+ * @brief The handlers replaced by APPLOG_CrashHandler
+ */
+static struct sigaction APPLOG_crash_old_actions[sizeof(APPLOG_crash_signals) / sizeof(APPLOG_crash_signals[0])];
+
+/**
+ * @brief The flight recorder, used while APPLOG_flight_active
+ */
+static struct LOGFLIGHT_S APPLOG_flight;
+
+/**
+ * @brief True while every record (also the filtered ones) is kept in
+ * APPLOG_flight
+ */
+static atomic_bool APPLOG_flight_active;
+
+/**
+ * @brief The dump file of the flight recorder, opened in advance
+ */
+static int APPLOG_flight_fd = -1;
+
+/**
+ * @brief The name of the dump file, removed when the process ends normally
+ */
+static char APPLOG_flight_filename[APPLOG_FILENAME_SIZE];
+
+/**
+ * @brief Rate limit: ns between two messages of a callsite, 0 for none
+ */
+static _Atomic int64_t APPLOG_rate_interval_ns = 0;
+
+/**
+ * @brief Rate limit: ns a callsite may run ahead of its rate (the burst)
+ */
+static _Atomic int64_t APPLOG_rate_window_ns = 0;
+
+/**
+ * @brief Identical messages of a callsite are counted instead of printed,
+ * off until APPLOG_SetRepeatCollapse
+ */
+static atomic_bool APPLOG_collapse = false;
+
+/**
+ * @brief The callsites which dropped messages (push-only list)
+ */
+static struct APPLOG_SITE_S* _Atomic APPLOG_sites;
+
+/**
+ * @brief Bounds of the APPLOG_SITE_SECTION, set by the linker (weak: no
+ * section without log statements)
+ */
+extern struct APPLOG_SITE_S __start_applog_sites[] __attribute__((weak));
+extern struct APPLOG_SITE_S __stop_applog_sites[] __attribute__((weak));
+
+/**
+ * @brief The staging buffer of the calling thread
+ */
+static __thread struct APPLOG_STAGE_S* APPLOG_stage;
+
+/**
+ * @brief All staging buffers (APPLOG_stages_mutex)
+ */
+static struct APPLOG_STAGE_S* APPLOG_stages;
+
+/**
+ * @brief Protects APPLOG_stages; taken before any stage mutex
+ */
+static pthread_mutex_t APPLOG_stages_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Releases the staging buffer of an exiting thread
+ */
+static pthread_key_t APPLOG_stage_key;
+
+/**
+ * @brief Creates APPLOG_stage_key once
+ */
+static pthread_once_t APPLOG_stage_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief State variable representing a usable APPLOG_stage_key
+ */
+static bool APPLOG_stage_key_ok;
+
+/**
+ * @brief The flusher thread
+ */
+static pthread_t APPLOG_flusher_thread;
+
+/**
+ * @brief Wakes the flusher thread up to stop
+ */
+static sem_t APPLOG_flusher_wakeup;
+
+/**
+ * @brief State variable representing a running flusher thread
+ */
+static atomic_bool APPLOG_flusher_running;
+
+/**
+ * @brief State variable representing a started flusher thread
+ */
+static bool APPLOG_flusher_active;
+
+/**
+ * @brief The settings of APPLOG_SetWriterThread (APPLOG_thread_mutex)
+ */
+static struct APPLOG_THREAD_S APPLOG_thread = { 0, APPLOG_SCHED_OTHER, 0 };
+
+/**
+ * @brief Serializes the access to APPLOG_thread
+ */
+static pthread_mutex_t APPLOG_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Generation of APPLOG_thread, 0 for the untouched defaults
+ */
+static atomic_uint APPLOG_thread_gen;
+
+/**
+ * @brief The names of the scheduling policies, as in the configuration
+ */
+static const char* const APPLOG_sched_names[APPLOG_SCHED_SENTINEL] = {
+	"other", "idle"
+};
+
+/**
+ * @brief The queue and flush figures of the writer thread, refer to
+ * APPLOG_WRITER_STATS_S (written by the writer thread only)
+ */
+static atomic_uint APPLOG_stat_depth;
+static atomic_uint APPLOG_stat_max_depth;
+static atomic_uint_fast64_t APPLOG_stat_flushes;
+static atomic_uint_fast64_t APPLOG_stat_last_ns;
+static atomic_uint_fast64_t APPLOG_stat_max_ns;
+static atomic_uint_fast64_t APPLOG_stat_total_ns;
+
+/* ----------------------------------------------------------------------
+ * exported variable definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported function definition section
+ * ----------------------------------------------------------------------*/
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_Init(void)
+{
+	static const char* fn="APPLOG_Init";
+	bool rv = false;
+	int init_res;
+
+	if (APPLOG_is_init){
+		printf("%s: [ERROR] Log component already initialized!", fn);
+	} else{
+		init_res = sem_init(&APPLOG_output_mutex, 0, APPLOG_RESOURCE_IDLE);
+
+		if(0 > init_res){
+			printf("%s: [ERROR] Couldn't initialize output semaphore:%s", fn, strerror(errno));
+		} else {
+			atomic_store(&APPLOG_dropped_records, 0);
+			atomic_store(&APPLOG_overwritten_records, 0);
+			atomic_store(&APPLOG_delayed_records, 0);
+			LOGSINK_OpenConsole(&APPLOG_sinks[APPLOG_SINK_CONSOLE], STDOUT_FILENO, APPLOG_sink_levels[APPLOG_SINK_CONSOLE]);
+			APPLOG_is_init = true;
+
+			/* the callsites start enabled: narrow them to the filters */
+			pthread_mutex_lock(&APPLOG_filter_mutex);
+			APPLOG_UpdateFilters();
+			pthread_mutex_unlock(&APPLOG_filter_mutex);
+			rv = true;
+
+			if ((APPLOG_MODE_SYNC != APPLOG_mode) && !APPLOG_StartWriter()){
+				APPLOG_Log(fn, LOGLV_WARNING, "Couldn't start the log writer thread, logging synchronously");
+			}
+			if (!APPLOG_StartFlusher()){
+				APPLOG_Log(fn, LOGLV_WARNING, "Couldn't start the log flusher thread, idle threads hold their lines until breakdown");
+			}
+		}
+	}
+
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_Breakdown(void)
+{
+	static const char* fn="APPLOG_Breakdown";
+	bool rv = false;
+	int get_value_result;
+	int destroy_result;
+	int mutex_val;
+	int sink;
+
+	if (!APPLOG_is_init){
+		printf("%s: [ERROR] Log component not initialized!", fn);
+	} else{
+		APPLOG_StopReloader();
+		APPLOG_StopFlusher();
+		APPLOG_ReportSuppressed();
+		APPLOG_ReportRepeats(true);
+		APPLOG_StopWriter();
+		APPLOG_ReportBackpressure();
+		APPLOG_ReportWriter();
+		APPLOG_StopFlightRecorder();
+
+		get_value_result = sem_getvalue(&APPLOG_output_mutex, &mutex_val);
+
+		if (0 > get_value_result){
+			printf("%s: [ERROR] Couldn't get semaphore value:%s", fn, strerror(errno));
+		} else if (APPLOG_RESOURCE_IDLE != mutex_val){
+			APPLOG_Log(fn, LOGLV_WARNING, "Semaphore value unexpected:%d", mutex_val);
+		}
+
+		APPLOG_FlushStages(true);
+
+		sem_wait(&APPLOG_output_mutex);
+		for (sink = 0; sink < APPLOG_SINK_SENTINEL; sink++){
+			LOGSINK_Close(&APPLOG_sinks[sink]);
+			APPLOG_sink_levels[sink] = APPLOG_SINK_ALL_LEVELS;
+		}
+		APPLOG_socket_path[0] = '\0';
+		APPLOG_memory_records = 0;
+		fflush(stdout);
+		sem_post(&APPLOG_output_mutex);
+
+		destroy_result = sem_destroy(&APPLOG_output_mutex);
+
+		if (0 > destroy_result){
+			printf("%s: [ERROR] Couldn't destroy semaphore:%s", fn, strerror(errno));
+		} else {
+			rv = true;
+		}
+
+		APPLOG_is_init = false;
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_SetMode(const enum APPLOG_MODE_E mode)
+{
+	static const char* fn="APPLOG_SetMode";
+	bool rv = false;
+
+	if (APPLOG_is_init){
+		APPLOG_Log(fn, LOGLV_ERROR, "Mode can't change while the log component is initialized");
+	} else if (APPLOG_MODE_SENTINEL <= mode){
+		printf("%s: [ERROR] Illegal log mode:%d", fn, mode);
+	} else {
+		APPLOG_mode = mode;
+		rv = true;
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_SetColor(const bool color)
+{
+	static const char* fn="APPLOG_SetColor";
+	bool rv = false;
+
+	if (APPLOG_is_init){
+		APPLOG_Log(fn, LOGLV_ERROR, "Colors can't change while the log component is initialized");
+	} else {
+		APPLOG_prefixes = color ? APPLOG_color_prefixes : APPLOG_plain_prefixes;
+		rv = true;
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_SetBinaryOutput(const char* const filename)
+{
+	static const char* fn="APPLOG_SetBinaryOutput";
+	bool rv = false;
+	char* p_copy = NULL;
+
+	if (APPLOG_is_init){
+		APPLOG_Log(fn, LOGLV_ERROR, "Output can't change while the log component is initialized");
+	} else if ((NULL != filename) && (NULL == (p_copy = strdup(filename)))){
+		printf("%s: [ERROR] Couldn't copy filename:%s", fn, strerror(errno));
+	} else {
+		free(APPLOG_binary_filename);
+		APPLOG_binary_filename = p_copy;
+		rv = true;
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_LoadConfig(const char* const filename)
+{
+	static const char* fn="APPLOG_LoadConfig";
+	uint32_t rate_limit = APPLOG_DEFAULT_RATE_LIMIT;
+	uint32_t rate_burst = APPLOG_DEFAULT_RATE_BURST;
+	uint32_t crash_records = APPLOG_DEFAULT_CRASH_RECORDS;
+	char crash_file[APPLOG_FILENAME_SIZE] = "";
+	uint32_t bp_timeout_ms = APPLOG_DEFAULT_BP_TIMEOUT_MS;
+	char bp_name[APPLOG_BP_NAME_SIZE] = "";
+	int policy;
+	int64_t value;
+	uint64_t bits;
+	bool rv = false;
+
+	if (!APPLOG_is_init){
+		printf("%s: [ERROR] Log component not initialized!", fn);
+	} else if (0 != access(filename, R_OK)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't read %s:%s", filename, strerror(errno));
+	} else {
+		/* every parameter is optional: a missing one keeps its default, silently */
+		if ((0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_RATE_LIMIT, &value)) && (0 <= value) && (UINT32_MAX >= value)){
+			rate_limit = value;
+		}
+		if ((0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_RATE_BURST, &value)) && (0 < value) && (UINT32_MAX >= value)){
+			rate_burst = value;
+		}
+		APPLOG_SetRateLimit(rate_limit, rate_burst);
+		if (0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_COLLAPSE, &value)){
+			APPLOG_SetRepeatCollapse(0 != value);
+		}
+
+		if ((0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_BP_TIMEOUT_MS, &value)) && (0 <= value) && (UINT32_MAX >= value)){
+			bp_timeout_ms = value;
+		}
+		if ((0 == APPCFG_GetConfigStringParamFromFile(filename, APPLOG_CFG_BACKPRESSURE, bp_name, sizeof(bp_name)))
+				&& ('\0' != bp_name[0])){
+			for (policy = 0; (policy < APPLOG_BACKPRESSURE_SENTINEL) && (0 != strcmp(bp_name, APPLOG_bp_names[policy])); policy++){
+				;
+			}
+			if (APPLOG_BACKPRESSURE_SENTINEL == policy){
+				APPLOG_Log(fn, LOGLV_ERROR, "Unknown backpressure policy:%s", bp_name);
+			} else {
+				APPLOG_SetBackpressure(policy, bp_timeout_ms);
+			}
+		}
+
+		if (0 == APPCFG_GetConfigUint64ParamFromFile(filename, APPLOG_CFG_LEVEL, &bits)){
+			APPLOG_SetLogLevel(bits);
+		}
+		if (0 == APPCFG_GetConfigUint64ParamFromFile(filename, APPLOG_CFG_DEBUG_BITS, &bits)){
+			pthread_mutex_lock(&APPLOG_filter_mutex);
+			atomic_store_explicit(&APPLOG_debug_bits, bits, memory_order_relaxed);
+			APPLOG_UpdateFilters();
+			pthread_mutex_unlock(&APPLOG_filter_mutex);
+		}
+
+		if ((0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_CRASH_RECORDS, &value)) && (0 < value) && (UINT32_MAX >= value)){
+			crash_records = value;
+		}
+		if ((0 == APPCFG_GetConfigStringParamFromFile(filename, APPLOG_CFG_CRASH_FILE, crash_file, sizeof(crash_file)))
+				&& ('\0' != crash_file[0]) && !atomic_load(&APPLOG_flight_active)){
+			APPLOG_StartFlightRecorder(crash_file, crash_records);
+		}
+
+		rv = APPLOG_LoadFileConfig(filename);
+		rv = APPLOG_LoadSinkConfig(filename) && rv;
+		rv = APPLOG_LoadThreadConfig(filename) && rv;
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_SetLogFile(const char* const path)
+{
+	static const char* fn="APPLOG_SetLogFile";
+	struct LOGFILE_CONFIG_S file_config;
+	bool rv = false;
+
+	memset(&file_config, 0, sizeof(file_config));
+	file_config.segment_size = APPLOG_DEFAULT_SEGMENT_SIZE;
+	file_config.rotate_seconds = APPLOG_DEFAULT_ROTATE_SECONDS;
+	file_config.max_segments = APPLOG_DEFAULT_MAX_SEGMENTS;
+	file_config.sync_bytes = APPLOG_DEFAULT_SYNC_BYTES;
+
+	if (!APPLOG_is_init){
+		printf("%s: [ERROR] Log component not initialized!", fn);
+	} else if ((NULL != path) && (sizeof(file_config.path) <= strlen(path))){
+		APPLOG_Log(fn, LOGLV_ERROR, "Log file path too long:%s", path);
+	} else {
+		if (NULL != path){
+			strcpy(file_config.path, path);
+		}
+		/* a log file replaces the console */
+		rv = APPLOG_SetFileOutput(&file_config, ('\0' == file_config.path[0]) ? APPLOG_SINK_ALL_LEVELS : 0);
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_SetSinkLevels(const enum APPLOG_SINK_E sink, const uint64_t level_bits)
+{
+	static const char* fn="APPLOG_SetSinkLevels";
+	bool rv = false;
+
+	if (!APPLOG_is_init){
+		printf("%s: [ERROR] Log component not initialized!", fn);
+	} else if (APPLOG_SINK_SENTINEL <= sink){
+		APPLOG_Log(fn, LOGLV_ERROR, "Illegal log output:%d", sink);
+	} else {
+		sem_wait(&APPLOG_output_mutex);
+		APPLOG_sink_levels[sink] = level_bits;
+		APPLOG_sinks[sink].levels = APPLOG_sink_levels[sink];
+		sem_post(&APPLOG_output_mutex);
+		rv = true;
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_SetLogSocket(const char* const path)
+{
+	static const char* fn="APPLOG_SetLogSocket";
+	struct LOGSINK_S new_sink;
+	bool unchanged;
+	bool rv = false;
+
+	if (!APPLOG_is_init){
+		printf("%s: [ERROR] Log component not initialized!", fn);
+	} else if ((NULL != path) && (sizeof(APPLOG_socket_path) <= strlen(path))){
+		APPLOG_Log(fn, LOGLV_ERROR, "Log socket path too long:%s", path);
+	} else {
+		sem_wait(&APPLOG_output_mutex);
+		unchanged = (0 == strcmp(APPLOG_socket_path, (NULL == path) ? "" : path));
+		sem_post(&APPLOG_output_mutex);
+
+		if (unchanged){
+			rv = true;
+		} else if ((NULL == path) || ('\0' == path[0])){
+			APPLOG_SwapSink(APPLOG_SINK_SOCKET, NULL);
+			APPLOG_Log(fn, LOGLV_INFO, "Log socket: none");
+			rv = true;
+		} else if (!LOGSINK_OpenSocket(&new_sink, path, APPLOG_sink_levels[APPLOG_SINK_SOCKET])){
+			APPLOG_Log(fn, LOGLV_ERROR, "Couldn't connect to log socket %s, output unchanged", path);
+		} else {
+			APPLOG_SwapSink(APPLOG_SINK_SOCKET, &new_sink);
+			APPLOG_Log(fn, LOGLV_INFO, "Log socket: %s", path);
+			rv = true;
+		}
+
+		if (rv && !unchanged){
+			sem_wait(&APPLOG_output_mutex);
+			strcpy(APPLOG_socket_path, (NULL == path) ? "" : path);
+			sem_post(&APPLOG_output_mutex);
+		}
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_SetMemorySink(const uint32_t records)
+{
+	static const char* fn="APPLOG_SetMemorySink";
+	struct LOGSINK_S new_sink;
+	bool unchanged;
+	bool rv = false;
+
+	if (!APPLOG_is_init){
+		printf("%s: [ERROR] Log component not initialized!", fn);
+	} else {
+		sem_wait(&APPLOG_output_mutex);
+		unchanged = (records == APPLOG_memory_records);
+		sem_post(&APPLOG_output_mutex);
+
+		if (unchanged){
+			rv = true;
+		} else if (0 == records){
+			APPLOG_SwapSink(APPLOG_SINK_MEMORY, NULL);
+			rv = true;
+		} else if (!LOGSINK_OpenMemory(&new_sink, records, APPLOG_sink_levels[APPLOG_SINK_MEMORY])){
+			APPLOG_Log(fn, LOGLV_ERROR, "Couldn't allocate %u log lines, output unchanged", (unsigned)records);
+		} else {
+			APPLOG_SwapSink(APPLOG_SINK_MEMORY, &new_sink);
+			rv = true;
+		}
+
+		if (rv && !unchanged){
+			sem_wait(&APPLOG_output_mutex);
+			APPLOG_memory_records = records;
+			sem_post(&APPLOG_output_mutex);
+		}
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+void APPLOG_DumpMemorySink(const int fd)
+{
+	if (APPLOG_is_init){
+		sem_wait(&APPLOG_output_mutex);
+		LOGSINK_DumpMemory(&APPLOG_sinks[APPLOG_SINK_MEMORY], fd);
+		sem_post(&APPLOG_output_mutex);
+	}
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_SetBackpressure(const enum APPLOG_BACKPRESSURE_E policy, const uint32_t timeout_ms)
+{
+	static const char* fn="APPLOG_SetBackpressure";
+	bool rv = false;
+
+	if (APPLOG_BACKPRESSURE_SENTINEL <= policy){
+		APPLOG_Log(fn, LOGLV_ERROR, "Illegal backpressure policy:%d", policy);
+	} else {
+		atomic_store_explicit(&APPLOG_bp_timeout_ms, timeout_ms, memory_order_relaxed);
+		atomic_store_explicit(&APPLOG_backpressure, policy, memory_order_relaxed);
+		rv = true;
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_SetWriterThread(const struct APPLOG_THREAD_S* const p_thread)
+{
+	static const char* fn="APPLOG_SetWriterThread";
+	bool rv = false;
+
+	if (NULL == p_thread){
+		APPLOG_Log(fn, LOGLV_ERROR, "Null thread settings");
+	} else if (APPLOG_SCHED_SENTINEL <= p_thread->policy){
+		APPLOG_Log(fn, LOGLV_ERROR, "Illegal scheduling policy:%d", p_thread->policy);
+	} else if ((APPLOG_NICE_MIN > p_thread->nice) || (APPLOG_NICE_MAX < p_thread->nice)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Illegal nice value:%d", p_thread->nice);
+	} else {
+		pthread_mutex_lock(&APPLOG_thread_mutex);
+		APPLOG_thread = *p_thread;
+		pthread_mutex_unlock(&APPLOG_thread_mutex);
+		atomic_fetch_add(&APPLOG_thread_gen, 1);
+		rv = true;
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+void APPLOG_GetWriterStats(struct APPLOG_WRITER_STATS_S* const p_stats)
+{
+	p_stats->capacity = APPLOG_RING_CAPACITY;
+	p_stats->depth = atomic_load_explicit(&APPLOG_stat_depth, memory_order_relaxed);
+	p_stats->max_depth = atomic_load_explicit(&APPLOG_stat_max_depth, memory_order_relaxed);
+	p_stats->flushes = atomic_load_explicit(&APPLOG_stat_flushes, memory_order_relaxed);
+	p_stats->last_flush_ns = atomic_load_explicit(&APPLOG_stat_last_ns, memory_order_relaxed);
+	p_stats->max_flush_ns = atomic_load_explicit(&APPLOG_stat_max_ns, memory_order_relaxed);
+	p_stats->total_flush_ns = atomic_load_explicit(&APPLOG_stat_total_ns, memory_order_relaxed);
+}
+
+/* --------------------------------------------------------------------- */
+void APPLOG_GetCounters(struct APPLOG_COUNTERS_S* const p_counters)
+{
+	p_counters->dropped = atomic_load_explicit(&APPLOG_dropped_records, memory_order_relaxed);
+	p_counters->overwritten = atomic_load_explicit(&APPLOG_overwritten_records, memory_order_relaxed);
+	p_counters->delayed = atomic_load_explicit(&APPLOG_delayed_records, memory_order_relaxed);
+}
+
+/* --------------------------------------------------------------------- */
+void APPLOG_SetRateLimit(const uint32_t per_second, const uint32_t burst)
+{
+	int64_t interval = (0 == per_second) ? 0 : 1000000000LL / per_second;
+
+	atomic_store_explicit(&APPLOG_rate_interval_ns, interval, memory_order_relaxed);
+	atomic_store_explicit(&APPLOG_rate_window_ns,
+			((0 == burst) ? 0 : (int64_t)(burst - 1)) * interval, memory_order_relaxed);
+}
+
+/* --------------------------------------------------------------------- */
+void APPLOG_SetRepeatCollapse(const bool collapse)
+{
+	struct APPLOG_SITE_S* p_site;
+
+	if (!collapse){
+		atomic_store_explicit(&APPLOG_collapse, false, memory_order_relaxed);
+		APPLOG_ReportRepeats(true);
+	} else if (!atomic_load_explicit(&APPLOG_collapse, memory_order_relaxed)){
+		/* a message seen before doesn't count as a repeat */
+		for (p_site = __start_applog_sites; p_site < __stop_applog_sites; p_site++){
+			atomic_store_explicit(&p_site->last_hash, 0, memory_order_relaxed);
+		}
+		atomic_store_explicit(&APPLOG_collapse, true, memory_order_relaxed);
+	}
+}
+
+/* --------------------------------------------------------------------- */
+bool APPLOG_StartFlightRecorder(const char* const filename, const uint32_t records)
+{
+	static const char* fn="APPLOG_StartFlightRecorder";
+	struct sigaction action;
+	size_t capacity = 2;
+	size_t i;
+	bool rv = false;
+
+	while (capacity < records){
+		capacity <<= 1;
+	}
+
+	if (!APPLOG_is_init){
+		printf("%s: [ERROR] Log component not initialized!", fn);
+	} else if (atomic_load(&APPLOG_flight_active)){
+		APPLOG_Log(fn, LOGLV_ERROR, "The flight recorder is already running");
+	} else if ((NULL == filename) || (sizeof(APPLOG_flight_filename) <= strlen(filename))){
+		APPLOG_Log(fn, LOGLV_ERROR, "Illegal dump file name");
+	} else if (0 > (APPLOG_flight_fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't open %s:%s", filename, strerror(errno));
+	} else if (!LOGFLIGHT_Create(&APPLOG_flight, capacity)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't allocate %zu flight records", capacity);
+		close(APPLOG_flight_fd);
+		APPLOG_flight_fd = -1;
+		unlink(filename);
+	} else {
+		strcpy(APPLOG_flight_filename, filename);
+		pthread_mutex_lock(&APPLOG_filter_mutex);
+		atomic_store_explicit(&APPLOG_flight_active, true, memory_order_release);
+		APPLOG_UpdateFilters();
+		pthread_mutex_unlock(&APPLOG_filter_mutex);
+
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = APPLOG_CrashHandler;
+		sigemptyset(&action.sa_mask);
+		for (i = 0; i < sizeof(APPLOG_crash_signals) / sizeof(APPLOG_crash_signals[0]); i++){
+			sigaction(APPLOG_crash_signals[i], &action, &APPLOG_crash_old_actions[i]);
+		}
+
+		APPLOG_Log(fn, LOGLV_INFO, "Flight recorder keeps the last %zu records, dumped to %s on a crash", capacity, filename);
+		rv = true;
+	}
+	return rv;
+}
+
+/* --------------------------------------------------------------------- */
+size_t APPLOG_RenderRecord(
+		char* const buf,
+		const size_t size,
+		const struct LOGFMT_RECORD_S* const p_rec)
+{
+	struct timespec ts;
+	size_t len;
+
+	ts.tv_sec = p_rec->sec;
+	ts.tv_nsec = p_rec->nsec;
+
+	/* keep room for the '\n' */
+	len = APPLOG_TimeNCo(buf, size - 1, &ts, p_rec->fn, APPLOG_Prefix(p_rec->level, p_rec->flags));
+	len += LOGFMT_RenderArgs(buf + len, size - 1 - len, p_rec->fmt, p_rec->args, p_rec->args_len);
+	buf[len++] = '\n';
+	buf[len] = '\0';
+	return len;
+}
+
+/* ----------------------------------------------------------------------*/
+void APPLOG_SetLogBits(const uint64_t bits)
+{
+	pthread_mutex_lock(&APPLOG_filter_mutex);
+	atomic_fetch_or_explicit(&APPLOG_debug_bits, bits, memory_order_relaxed);
+	APPLOG_UpdateFilters();
+	pthread_mutex_unlock(&APPLOG_filter_mutex);
+}
+
+/* ----------------------------------------------------------------------*/
+void APPLOG_ResetLogBits(const uint64_t bits)
+{
+	pthread_mutex_lock(&APPLOG_filter_mutex);
+	atomic_fetch_and_explicit(&APPLOG_debug_bits, ~bits, memory_order_relaxed);
+	APPLOG_UpdateFilters();
+	pthread_mutex_unlock(&APPLOG_filter_mutex);
+}
+
+/* ----------------------------------------------------------------------*/
+void APPLOG_SetLogLevel(const uint64_t level_bits)
+{
+	static const char* fn = "APPLOG_SetLogLevel";
+
+	if ((LOGLV_UNDEFINED == level_bits) || (LOGLV_SENTINEL <= level_bits)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Illegal log level bits:0x%llx", (unsigned long long)level_bits);
+	} else {
+		pthread_mutex_lock(&APPLOG_filter_mutex);
+		atomic_store_explicit(&APPLOG_level_bits, level_bits, memory_order_relaxed);
+		APPLOG_UpdateFilters();
+		pthread_mutex_unlock(&APPLOG_filter_mutex);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+bool APPLOG_WatchConfig(const char* const filename)
+{
+	static const char* fn = "APPLOG_WatchConfig";
+	struct sigaction action;
+	int create_res;
+	bool rv = false;
+
+	if (!APPLOG_is_init){
+		printf("%s: [ERROR] Log component not initialized!", fn);
+	} else if (atomic_load(&APPLOG_reload_running)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Already watching %s", APPLOG_reload_filename);
+	} else if ((NULL == filename) || (sizeof(APPLOG_reload_filename) <= strlen(filename))){
+		APPLOG_Log(fn, LOGLV_ERROR, "Illegal configuration file name");
+	} else if (0 > sem_init(&APPLOG_reload_wakeup, 0, 0)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't initialize reload semaphore:%s", strerror(errno));
+	} else {
+		strcpy(APPLOG_reload_filename, filename);
+		atomic_store(&APPLOG_reload_running, true);
+
+		create_res = pthread_create(&APPLOG_reload_thread, NULL, APPLOG_Reloader, NULL);
+
+		if (0 != create_res){
+			APPLOG_Log(fn, LOGLV_ERROR, "Couldn't create reload thread:%s", strerror(create_res));
+			atomic_store(&APPLOG_reload_running, false);
+			sem_destroy(&APPLOG_reload_wakeup);
+		} else {
+			pthread_setname_np(APPLOG_reload_thread, "applog-reload");
+
+			memset(&action, 0, sizeof(action));
+			action.sa_handler = APPLOG_ReloadHandler;
+			action.sa_flags = SA_RESTART;
+			sigemptyset(&action.sa_mask);
+			sigaction(SIGUSR1, &action, &APPLOG_reload_old_action);
+
+			APPLOG_Log(fn, LOGLV_INFO, "Send SIGUSR1 to reload the log settings of %s", filename);
+			rv = true;
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+void (APPLOG_LogDebug)(
+		const char* fn,
+		const uint64_t bits,
+		char* fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	APPLOG_VLogDebug(NULL, fn, bits, fmt, args);
+	va_end(args);
+}
+
+/* ----------------------------------------------------------------------*/
+unsigned APPLOG_SetSiteEnabled(const char* const file, const int line, const bool on)
+{
+	struct APPLOG_SITE_S* p_site;
+	size_t len = strlen(file);
+	size_t file_len;
+	unsigned rv = 0;
+
+	pthread_mutex_lock(&APPLOG_filter_mutex);
+
+	for (p_site = __start_applog_sites; p_site < __stop_applog_sites; p_site++){
+		file_len = strlen(p_site->file);
+
+		if (((0 == line) || (line == p_site->line)) && (len <= file_len)
+				&& (0 == strcmp(p_site->file + file_len - len, file))){
+			p_site->switched_off = !on;
+			rv++;
+		}
+	}
+	APPLOG_UpdateSites();
+
+	pthread_mutex_unlock(&APPLOG_filter_mutex);
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+void APPLOG_ReportHotSites(const unsigned count)
+{
+	static const char* fn = "APPLOG_ReportHotSites";
+	struct APPLOG_HOT_SITE_S* p_hot;
+	const struct APPLOG_SITE_S* p_site;
+	size_t total = __stop_applog_sites - __start_applog_sites;
+	size_t n = 0;
+	size_t i;
+
+	/* snapshot the counts: they keep moving while sorting */
+	if (NULL == (p_hot = malloc((total + 1) * sizeof(*p_hot)))){
+		APPLOG_Log(fn, LOGLV_ERROR, "Out of memory");
+	} else {
+		for (p_site = __start_applog_sites; p_site < __stop_applog_sites; p_site++){
+			p_hot[n].p_site = p_site;
+			p_hot[n].hits = atomic_load_explicit(&p_site->hits, memory_order_relaxed);
+			n += (0 != p_hot[n].hits) ? 1 : 0;
+		}
+		qsort(p_hot, n, sizeof(*p_hot), APPLOG_CompareHits);
+
+		APPLOG_Log(fn, LOGLV_INFO, "%zu of %zu log statements called", n, total);
+		for (i = 0; (i < n) && (i < count); i++){
+			p_site = p_hot[i].p_site;
+			APPLOG_Log(fn, LOGLV_INFO, "%llu calls: %s:%d %s() \"%s\"", (unsigned long long)p_hot[i].hits,
+					p_site->file, p_site->line, p_site->func, (NULL != p_site->fmt) ? p_site->fmt : "?");
+		}
+		free(p_hot);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+void APPLOG_SiteLogDebug(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t bits,
+		char* fmt, ...)
+{
+	va_list args;
+
+	atomic_fetch_add_explicit(&p_site->hits, 1, memory_order_relaxed);
+	va_start(args, fmt);
+	APPLOG_VLogDebug(p_site, fn, bits, fmt, args);
+	va_end(args);
+}
+
+/* ----------------------------------------------------------------------*/
+void (APPLOG_Log)(
+		const char* fn,
+		const uint64_t level,
+		char* fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	APPLOG_VLog(NULL, fn, level, fmt, args);
+	va_end(args);
+}
+
+/* ----------------------------------------------------------------------*/
+void APPLOG_SiteLog(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t level,
+		char* fmt, ...)
+{
+	va_list args;
+
+	atomic_fetch_add_explicit(&p_site->hits, 1, memory_order_relaxed);
+	va_start(args, fmt);
+	APPLOG_VLog(p_site, fn, level, fmt, args);
+	va_end(args);
+}
+
+/* ----------------------------------------------------------------------
+ * functions with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_VLogDebug(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t bits,
+		const char* fmt,
+		va_list args)
+{
+	bool log_out = (0 != (atomic_load_explicit(&APPLOG_level_bits, memory_order_relaxed) & LOGLV_DEBUG))
+			&& (0 != (bits & atomic_load_explicit(&APPLOG_debug_bits, memory_order_relaxed)));
+
+	if (log_out && APPLOG_SiteFresh(p_site, fn, LOGLV_DEBUG, LOGFMT_FLAG_DEBUG, fmt, args)
+			&& APPLOG_SiteAdmit(p_site, fn, LOGLV_DEBUG, LOGFMT_FLAG_DEBUG)){
+		APPLOG_Output(fn, LOGLV_DEBUG, LOGFMT_FLAG_DEBUG, fmt, args);
+	} else if (atomic_load_explicit(&APPLOG_flight_active, memory_order_acquire)){
+		APPLOG_FlightRecord(fn, APPLOG_Prefix(LOGLV_DEBUG, LOGFMT_FLAG_DEBUG), fmt, args);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_VLog(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t level,
+		const char* fmt,
+		va_list args)
+{
+	/* filter first: a filtered out record costs a load and a branch */
+	bool log_out = (0 != (level & atomic_load_explicit(&APPLOG_level_bits, memory_order_relaxed)))
+			|| (LOGLV_UNDEFINED == level) || (LOGLV_SENTINEL <= level);
+
+	if(log_out && APPLOG_SiteFresh(p_site, fn, level, 0, fmt, args) && APPLOG_SiteAdmit(p_site, fn, level, 0)){
+		APPLOG_Output(fn, level, 0, fmt, args);
+	} else if (atomic_load_explicit(&APPLOG_flight_active, memory_order_acquire)){
+		APPLOG_FlightRecord(fn, APPLOG_Prefix(level, 0), fmt, args);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static bool APPLOG_SiteAdmit(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags)
+{
+	int64_t interval = atomic_load_explicit(&APPLOG_rate_interval_ns, memory_order_relaxed);
+	int64_t window;
+	int64_t now;
+	int64_t tat;
+	int64_t new_tat;
+	struct timespec ts;
+	unsigned suppressed;
+	bool rv = true;
+
+	if ((NULL != p_site) && (0 < interval) && (0 == (level & APPLOG_RATE_EXEMPT_LEVELS))){
+		window = atomic_load_explicit(&APPLOG_rate_window_ns, memory_order_relaxed);
+		clock_gettime(APPLOG_SITE_CLOCKID, &ts);
+		now = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+		tat = atomic_load_explicit(&p_site->tat, memory_order_relaxed);
+
+		/* conforming while the next arrival time isn't more than window ahead */
+		do {
+			rv = (tat - now <= window);
+			new_tat = ((tat > now) ? tat : now) + interval;
+		} while (rv && !atomic_compare_exchange_weak_explicit(&p_site->tat, &tat, new_tat,
+				memory_order_relaxed, memory_order_relaxed));
+
+		if (!rv){
+			atomic_fetch_add_explicit(&p_site->suppressed, 1, memory_order_relaxed);
+			APPLOG_ListSite(p_site, fn, level, flags);
+		} else if ((0 != atomic_load_explicit(&p_site->suppressed, memory_order_relaxed))
+				&& (0 != (suppressed = atomic_exchange_explicit(&p_site->suppressed, 0, memory_order_relaxed)))){
+			APPLOG_OutputF(fn, level, flags, "%u similar messages suppressed by the rate limit", suppressed);
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static bool APPLOG_SiteFresh(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags,
+		const char* fmt,
+		va_list args)
+{
+	uint8_t captured[APPLOG_REPEAT_ARGS_SIZE];
+	bool truncated = false;
+	va_list hash_args;
+	uint64_t hash = 14695981039346656037ULL;
+	size_t len;
+	size_t i;
+	unsigned repeats;
+	int64_t now;
+	bool rv = true;
+
+	if ((NULL != p_site) && atomic_load_explicit(&APPLOG_collapse, memory_order_relaxed)){
+		va_copy(hash_args, args);
+		len = LOGFMT_CaptureArgs(captured, sizeof(captured), fmt, hash_args, &truncated);
+		va_end(hash_args);
+
+		/* FNV-1a of the argument bytes; a statement may pass different formats and functions */
+		hash = (hash ^ (uintptr_t)fmt) * 1099511628211ULL;
+		hash = (hash ^ (uintptr_t)fn) * 1099511628211ULL;
+		for (i = 0; i < len; i++){
+			hash = (hash ^ captured[i]) * 1099511628211ULL;
+		}
+		/* 0 stands for none, and a cut message can't be compared */
+		hash = (truncated || (0 == hash)) ? 0 : hash;
+		now = APPLOG_StageClock();
+
+		if ((0 != hash) && (hash == atomic_exchange_explicit(&p_site->last_hash, hash, memory_order_relaxed))
+				&& (now - atomic_load_explicit(&p_site->last_at, memory_order_relaxed) < APPLOG_REPEAT_HOLD_MS * 1000000LL)){
+			if (0 == atomic_fetch_add_explicit(&p_site->repeats, 1, memory_order_relaxed)){
+				atomic_store_explicit(&p_site->repeat_since, now, memory_order_relaxed);
+				APPLOG_ListSite(p_site, fn, level, flags);
+			}
+			rv = false;
+		} else if ((0 != atomic_load_explicit(&p_site->repeats, memory_order_relaxed))
+				&& (0 != (repeats = atomic_exchange_explicit(&p_site->repeats, 0, memory_order_relaxed)))){
+			APPLOG_OutputF(fn, level, flags, "last message repeated %u times", repeats);
+		}
+		if (rv){
+			atomic_store_explicit(&p_site->last_at, now, memory_order_relaxed);
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_ListSite(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags)
+{
+	if (!atomic_load_explicit(&p_site->listed, memory_order_relaxed)
+			&& !atomic_exchange(&p_site->listed, true)){
+		p_site->fn = fn;
+		p_site->level = level;
+		p_site->flags = flags;
+		p_site->p_next = atomic_load_explicit(&APPLOG_sites, memory_order_relaxed);
+
+		while (!atomic_compare_exchange_weak_explicit(&APPLOG_sites, &p_site->p_next, p_site,
+				memory_order_release, memory_order_relaxed)){
+			;
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_ReportSuppressed(void)
+{
+	struct APPLOG_SITE_S* p_site;
+	unsigned suppressed;
+
+	for (p_site = atomic_load_explicit(&APPLOG_sites, memory_order_acquire); NULL != p_site; p_site = p_site->p_next){
+		suppressed = atomic_exchange_explicit(&p_site->suppressed, 0, memory_order_relaxed);
+
+		if (0 < suppressed){
+			APPLOG_OutputF(p_site->fn, p_site->level, p_site->flags,
+					"%u similar messages suppressed by the rate limit (%s:%d)",
+					suppressed, p_site->file, p_site->line);
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_ReportRepeats(const bool all)
+{
+	int64_t oldest = APPLOG_StageClock() - APPLOG_REPEAT_HOLD_MS * 1000000LL;
+	struct APPLOG_SITE_S* p_site;
+	unsigned repeats;
+
+	for (p_site = atomic_load_explicit(&APPLOG_sites, memory_order_acquire); NULL != p_site; p_site = p_site->p_next){
+		if ((0 != atomic_load_explicit(&p_site->repeats, memory_order_relaxed))
+				&& (all || (atomic_load_explicit(&p_site->repeat_since, memory_order_relaxed) <= oldest))
+				&& (0 != (repeats = atomic_exchange_explicit(&p_site->repeats, 0, memory_order_relaxed)))){
+			/* the next copy is printed again */
+			atomic_store_explicit(&p_site->last_hash, 0, memory_order_relaxed);
+			APPLOG_OutputF(p_site->fn, p_site->level, p_site->flags, "last message repeated %u times", repeats);
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_UpdateSites(void)
+{
+	uint64_t log_filter = atomic_load_explicit(&APPLOG_log_filter, memory_order_relaxed);
+	uint64_t debug_filter = atomic_load_explicit(&APPLOG_debug_filter, memory_order_relaxed);
+	struct APPLOG_SITE_S* p_site;
+	bool enabled;
+
+	for (p_site = __start_applog_sites; p_site < __stop_applog_sites; p_site++){
+		if (p_site->switched_off){
+			enabled = false;
+		} else if (0 != p_site->site_bits){
+			enabled = (0 != (p_site->site_bits & debug_filter));
+		} else {
+			/* undefined and illegal levels always log, as do the non-constant ones (filtered by the call) */
+			enabled = (LOGLV_UNDEFINED == p_site->site_level) || (LOGLV_SENTINEL <= p_site->site_level)
+					|| (0 != (p_site->site_level & log_filter));
+		}
+		atomic_store_explicit(&p_site->enabled, enabled, memory_order_relaxed);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static int APPLOG_CompareHits(const void* p_a, const void* p_b)
+{
+	uint64_t a = ((const struct APPLOG_HOT_SITE_S*)p_a)->hits;
+	uint64_t b = ((const struct APPLOG_HOT_SITE_S*)p_b)->hits;
+
+	return (a < b) ? 1 : ((a > b) ? -1 : 0);
+}
+
+/* ----------------------------------------------------------------------*/
+static size_t APPLOG_TimeNCo(
+		char* const buf,
+		const size_t size,
+		const struct timespec* const p_ts,
+		const char* fn,
+		const struct APPLOG_PREFIX_S* const p_prefix)
+{
+	size_t len;
+
+	len = LOGTIME_Format(buf, size, p_ts);
+	len = APPLOG_Append(buf, size, len, p_prefix->text, p_prefix->len);
+	len = APPLOG_Append(buf, size, len, fn, strlen(fn));
+	len = APPLOG_Append(buf, size, len, ": ", 2);
+	return len;
+}
+
+/* ----------------------------------------------------------------------*/
+static const struct APPLOG_PREFIX_S* APPLOG_Prefix(const uint64_t level, const uint16_t flags)
+{
+	size_t index;
+
+	if (flags & LOGFMT_FLAG_DEBUG){
+		index = APPLOG_PREFIX_DEBUG_BITS;
+	} else if ((LOGLV_UNDEFINED == level) || (LOGLV_SENTINEL <= level)){
+		index = APPLOG_PREFIX_UNKNOWN;
+	} else {
+		/* the lowest level bit wins: LOGLV_INFO is bit 0 */
+		index = __builtin_ctzll(level);
+	}
+	return &APPLOG_prefixes[index];
+}
+
+/* ----------------------------------------------------------------------*/
+static size_t APPLOG_Append(
+		char* const buf,
+		const size_t size,
+		const size_t len,
+		const char* const text,
+		const size_t text_len)
+{
+	size_t copy_len = 0;
+
+	if (len + 1 < size){
+		copy_len = (text_len < size - 1 - len) ? text_len : size - 1 - len;
+		memcpy(buf + len, text, copy_len);
+		buf[len + copy_len] = '\0';
+	}
+	return len + copy_len;
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_Output(
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags,
+		const char* fmt,
+		va_list args)
+{
+	const struct APPLOG_PREFIX_S* p_prefix = APPLOG_Prefix(level, flags);
+	char line[APPLOG_RENDER_SIZE];
+	va_list flight_args;
+	size_t len;
+
+	if (!atomic_load_explicit(&APPLOG_async_active, memory_order_acquire)){
+		if (!APPLOG_is_init){
+			printf("APPLOG_Output: Log component not initialized!\n");
+		} else {
+			len = APPLOG_Render(line, sizeof(line), fn, p_prefix, fmt, args);
+			if (atomic_load_explicit(&APPLOG_flight_active, memory_order_acquire)){
+				LOGFLIGHT_Record(&APPLOG_flight, line, len);
+			}
+			APPLOG_WriteOut(line, len, APPLOG_LineLevel(level), 0 != (level & APPLOG_STAGE_URGENT_LEVELS));
+		}
+	} else if (APPLOG_MODE_DEFERRED == APPLOG_mode){
+		if (atomic_load_explicit(&APPLOG_flight_active, memory_order_acquire)){
+			va_copy(flight_args, args);
+			APPLOG_FlightRecord(fn, p_prefix, fmt, flight_args);
+			va_end(flight_args);
+		}
+		APPLOG_PushDeferred(fn, level, flags, fmt, args);
+	} else {
+		APPLOG_PushRecord(fn, p_prefix, APPLOG_LineLevel(level), fmt, args);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_OutputF(
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags,
+		const char* fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	APPLOG_Output(fn, level, flags, fmt, args);
+	va_end(args);
+}
+
+/* ----------------------------------------------------------------------*/
+static size_t APPLOG_Render(
+		char* const buf,
+		const size_t size,
+		const char* fn,
+		const struct APPLOG_PREFIX_S* const p_prefix,
+		const char* fmt,
+		va_list args)
+{
+	struct timespec ts;
+	size_t avail = size - 1; /* keep room for the '\n' */
+	size_t len;
+	int msg_len;
+
+	LOGTIME_Now(&ts);
+	len = APPLOG_TimeNCo(buf, avail, &ts, fn, p_prefix);
+	msg_len = vsnprintf(buf + len, avail - len, fmt, args);
+
+	if (0 < msg_len){
+		len += ((size_t)msg_len < avail - len) ? (size_t)msg_len : avail - len - 1;
+	}
+	buf[len++] = '\n';
+	return len;
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_FlightRecord(
+		const char* fn,
+		const struct APPLOG_PREFIX_S* const p_prefix,
+		const char* fmt,
+		va_list args)
+{
+	char line[LOGFLIGHT_TEXT_SIZE];
+	size_t len;
+
+	len = APPLOG_Render(line, sizeof(line), fn, p_prefix, fmt, args);
+	LOGFLIGHT_Record(&APPLOG_flight, line, len);
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_StopFlightRecorder(void)
+{
+	size_t i;
+
+	if (atomic_load(&APPLOG_flight_active)){
+		for (i = 0; i < sizeof(APPLOG_crash_signals) / sizeof(APPLOG_crash_signals[0]); i++){
+			sigaction(APPLOG_crash_signals[i], &APPLOG_crash_old_actions[i], NULL);
+		}
+		pthread_mutex_lock(&APPLOG_filter_mutex);
+		atomic_store(&APPLOG_flight_active, false);
+		APPLOG_UpdateFilters();
+		pthread_mutex_unlock(&APPLOG_filter_mutex);
+
+		/* no crash: the dump file is empty */
+		close(APPLOG_flight_fd);
+		APPLOG_flight_fd = -1;
+		unlink(APPLOG_flight_filename);
+		LOGFLIGHT_Destroy(&APPLOG_flight);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_CrashHandler(int sig)
+{
+	static const char header[] = "*** APPLOG flight recorder, fatal signal ";
+	char number[12];
+	size_t pos = sizeof(number);
+	size_t i;
+	int value = sig;
+
+	/* no snprintf in a signal handler */
+	number[--pos] = '\n';
+	do {
+		number[--pos] = '0' + (value % 10);
+		value /= 10;
+	} while ((0 < value) && (0 < pos));
+
+	if ((0 <= write(APPLOG_flight_fd, header, sizeof(header) - 1))
+			&& (0 <= write(APPLOG_flight_fd, number + pos, sizeof(number) - pos))){
+		LOGFLIGHT_Dump(&APPLOG_flight, APPLOG_flight_fd);
+	}
+
+	/* restore the former handler (default: core dump) and deliver again */
+	for (i = 0; i < sizeof(APPLOG_crash_signals) / sizeof(APPLOG_crash_signals[0]); i++){
+		if (sig == APPLOG_crash_signals[i]){
+			sigaction(sig, &APPLOG_crash_old_actions[i], NULL);
+		}
+	}
+	raise(sig);
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_ReloadHandler(int sig)
+{
+	(void)sig;
+	sem_post(&APPLOG_reload_wakeup);
+}
+
+/* ----------------------------------------------------------------------*/
+static void* APPLOG_Reloader(void* p_arg)
+{
+	static const char* fn = "APPLOG_Reloader";
+	bool running;
+
+	(void)p_arg;
+
+	do {
+		while ((0 > sem_wait(&APPLOG_reload_wakeup)) && (EINTR == errno)){
+			;
+		}
+		running = atomic_load(&APPLOG_reload_running);
+
+		if (running){
+			APPLOG_Log(fn, LOGLV_INFO, "Reloading the log settings of %s", APPLOG_reload_filename);
+			APPLOG_LoadConfig(APPLOG_reload_filename);
+		}
+	} while (running);
+
+	return NULL;
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_StopReloader(void)
+{
+	if (atomic_load(&APPLOG_reload_running)){
+		sigaction(SIGUSR1, &APPLOG_reload_old_action, NULL);
+		atomic_store(&APPLOG_reload_running, false);
+		sem_post(&APPLOG_reload_wakeup);
+		pthread_join(APPLOG_reload_thread, NULL);
+		sem_destroy(&APPLOG_reload_wakeup);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_PushRecord(
+		const char* fn,
+		const struct APPLOG_PREFIX_S* const p_prefix,
+		const uint16_t line_level,
+		const char* fmt,
+		va_list args)
+{
+	struct LOGRING_SLOT_S* p_slot;
+	size_t len;
+
+	p_slot = APPLOG_ReserveSlot((LOGSINK_LEVEL_ANY != line_level) && (0 != (line_level & APPLOG_BP_EXEMPT_LEVELS)));
+
+	if (NULL != p_slot){
+		len = APPLOG_Render((char*)p_slot->payload, LOGRING_PAYLOAD_SIZE, fn, p_prefix, fmt, args);
+		if (atomic_load_explicit(&APPLOG_flight_active, memory_order_acquire)){
+			LOGFLIGHT_Record(&APPLOG_flight, (const char*)p_slot->payload, len);
+		}
+		p_slot->len = len;
+		p_slot->tag = APPLOG_SLOT_TAG(APPLOG_SLOT_TEXT, line_level);
+		LOGRING_Commit(p_slot);
+		APPLOG_WakeWriter();
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_PushDeferred(
+		const char* fn,
+		const uint64_t level,
+		const uint16_t flags,
+		const char* fmt,
+		va_list args)
+{
+	struct LOGRING_SLOT_S* p_slot;
+	struct LOGFMT_RECORD_S* p_rec;
+	struct timespec ts;
+	bool truncated = false;
+
+	p_slot = APPLOG_ReserveSlot(0 != (level & APPLOG_BP_EXEMPT_LEVELS));
+
+	if (NULL != p_slot){
+		LOGTIME_Now(&ts);
+		p_rec = (struct LOGFMT_RECORD_S*)p_slot->payload;
+		p_rec->sec = ts.tv_sec;
+		p_rec->nsec = ts.tv_nsec;
+		p_rec->level = level;
+		p_rec->fn = fn;
+		p_rec->fmt = fmt;
+		p_rec->args_len = LOGFMT_CaptureArgs(p_rec->args, LOGRING_PAYLOAD_SIZE - sizeof(*p_rec), fmt, args, &truncated);
+		p_rec->flags = flags | (truncated ? LOGFMT_FLAG_TRUNCATED : 0);
+		p_slot->len = sizeof(*p_rec) + p_rec->args_len;
+		p_slot->tag = APPLOG_SLOT_TAG(APPLOG_SLOT_DEFERRED, 0);
+		LOGRING_Commit(p_slot);
+		APPLOG_WakeWriter();
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_WakeWriter(void)
+{
+	/* pairs with the fence of the writer thread before it goes idle */
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&APPLOG_writer_sleeping, memory_order_relaxed)
+			&& atomic_exchange(&APPLOG_writer_sleeping, false)){
+		sem_post(&APPLOG_writer_wakeup);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_WakeProducer(void)
+{
+	unsigned waiters;
+	int posted;
+
+	/* pairs with the fence of a producer before it waits */
+	atomic_thread_fence(memory_order_seq_cst);
+	waiters = atomic_load_explicit(&APPLOG_space_waiters, memory_order_relaxed);
+
+	/* one post per waiter at most: surplus posts would spin the waiters later */
+	if ((0 < waiters) && (0 == sem_getvalue(&APPLOG_space_wakeup, &posted))){
+		for (; (unsigned)posted < waiters; posted++){
+			sem_post(&APPLOG_space_wakeup);
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static bool APPLOG_StartWriter(void)
+{
+	static const char* fn = "APPLOG_StartWriter";
+	bool rv = false;
+	int create_res;
+
+	if ((APPLOG_MODE_DEFERRED == APPLOG_mode) && (NULL != APPLOG_binary_filename)
+			&& (NULL == (APPLOG_binary_fp = fopen(APPLOG_binary_filename, "wb")))){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't open %s:%s", APPLOG_binary_filename, strerror(errno));
+	} else if ((NULL != APPLOG_binary_fp) && !LOGFMT_WriteHeader(APPLOG_binary_fp, &APPLOG_binary_dict)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't write %s:%s", APPLOG_binary_filename, strerror(errno));
+		fclose(APPLOG_binary_fp);
+		APPLOG_binary_fp = NULL;
+	} else if (!LOGRING_Create(&APPLOG_ring, APPLOG_RING_CAPACITY)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't allocate the log ring");
+	} else if (0 > sem_init(&APPLOG_writer_wakeup, 0, 0)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't initialize writer semaphore:%s", strerror(errno));
+		LOGRING_Destroy(&APPLOG_ring);
+	} else if (0 > sem_init(&APPLOG_space_wakeup, 0, 0)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't initialize ring space semaphore:%s", strerror(errno));
+		sem_destroy(&APPLOG_writer_wakeup);
+		LOGRING_Destroy(&APPLOG_ring);
+	} else {
+		atomic_store(&APPLOG_writer_running, true);
+		atomic_store(&APPLOG_writer_sleeping, false);
+		atomic_store(&APPLOG_space_waiters, 0);
+		atomic_store(&APPLOG_stat_depth, 0);
+		atomic_store(&APPLOG_stat_max_depth, 0);
+		atomic_store(&APPLOG_stat_flushes, 0);
+		atomic_store(&APPLOG_stat_last_ns, 0);
+		atomic_store(&APPLOG_stat_max_ns, 0);
+		atomic_store(&APPLOG_stat_total_ns, 0);
+
+		create_res = pthread_create(&APPLOG_writer_thread, NULL, APPLOG_Writer, NULL);
+
+		if (0 != create_res){
+			APPLOG_Log(fn, LOGLV_ERROR, "Couldn't create writer thread:%s", strerror(create_res));
+			sem_destroy(&APPLOG_space_wakeup);
+			sem_destroy(&APPLOG_writer_wakeup);
+			LOGRING_Destroy(&APPLOG_ring);
+		} else {
+			pthread_setname_np(APPLOG_writer_thread, "applog");
+			atomic_store_explicit(&APPLOG_async_active, true, memory_order_release);
+			rv = true;
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_StopWriter(void)
+{
+	if (atomic_load(&APPLOG_async_active)){
+		atomic_store(&APPLOG_writer_running, false);
+		sem_post(&APPLOG_writer_wakeup);
+		pthread_join(APPLOG_writer_thread, NULL);
+
+		/* from here on, records are printed synchronously again */
+		atomic_store_explicit(&APPLOG_async_active, false, memory_order_release);
+		sem_destroy(&APPLOG_space_wakeup);
+		sem_destroy(&APPLOG_writer_wakeup);
+		LOGRING_Destroy(&APPLOG_ring);
+
+		if (NULL != APPLOG_binary_fp){
+			fclose(APPLOG_binary_fp);
+			APPLOG_binary_fp = NULL;
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_WriteSlot(const struct LOGRING_SLOT_S* const p_slot)
+{
+	const struct LOGFMT_RECORD_S* p_rec;
+	char line[APPLOG_RENDER_SIZE];
+	size_t len;
+
+	if (APPLOG_SLOT_TEXT == APPLOG_SLOT_KIND(p_slot->tag)){
+		APPLOG_WriteOut((const char*)p_slot->payload, p_slot->len, APPLOG_SLOT_LEVEL(p_slot->tag), false);
+	} else {
+		p_rec = (const struct LOGFMT_RECORD_S*)p_slot->payload;
+
+		if (NULL != APPLOG_binary_fp){
+			LOGFMT_WriteRecord(APPLOG_binary_fp, &APPLOG_binary_dict, p_rec);
+		} else {
+			len = APPLOG_RenderRecord(line, sizeof(line), p_rec);
+			APPLOG_WriteOut(line, len, APPLOG_LineLevel(p_rec->level), false);
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static uint16_t APPLOG_LineLevel(const uint64_t level)
+{
+	return ((0 != level) && (0 == (level & (level - 1))) && (LOGLV_SENTINEL > level)) ? (uint16_t)level : LOGSINK_LEVEL_ANY;
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_WriteOut(const char* const text, const size_t len, const uint16_t line_level, const bool urgent)
+{
+	struct APPLOG_STAGE_S* p_stage = APPLOG_GetStage();
+	struct LOGSINK_LINE_S line;
+	struct LOGSINK_CHUNK_S chunk;
+
+	if (NULL == p_stage){
+		/* no staging buffer: write through */
+		line.end = len;
+		line.level = line_level;
+		chunk.text = text;
+		chunk.p_lines = &line;
+		chunk.n_lines = 1;
+		chunk.levels = line_level;
+		sem_wait(&APPLOG_output_mutex);
+		APPLOG_WriteChunks(&chunk, 1);
+		sem_post(&APPLOG_output_mutex);
+	} else {
+		pthread_mutex_lock(&p_stage->mutex);
+		APPLOG_StageAppend(p_stage, text, len, line_level);
+
+		if (urgent || ((0 < p_stage->len)
+				&& (APPLOG_StageClock() - p_stage->since >= APPLOG_STAGE_AGE_MS * 1000000LL))){
+			APPLOG_StageFlush(p_stage, false);
+		}
+
+		pthread_mutex_unlock(&p_stage->mutex);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_WriteChunks(const struct LOGSINK_CHUNK_S* const p_chunks, const int count)
+{
+	uint32_t lost = 0;
+	int sink;
+
+	/* keep the order with the printf output of the process */
+	fflush(stdout);
+
+	for (sink = 0; sink < APPLOG_SINK_SENTINEL; sink++){
+		lost += LOGSINK_Write(&APPLOG_sinks[sink], p_chunks, count);
+	}
+	if (0 < lost){
+		atomic_fetch_add_explicit(&APPLOG_dropped_records, lost, memory_order_relaxed);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_FlushOut(void)
+{
+	struct APPLOG_STAGE_S* p_stage = APPLOG_stage;
+	int sink;
+
+	if (NULL != p_stage){
+		pthread_mutex_lock(&p_stage->mutex);
+		APPLOG_StageFlush(p_stage, false);
+		pthread_mutex_unlock(&p_stage->mutex);
+	}
+
+	sem_wait(&APPLOG_output_mutex);
+
+	for (sink = 0; sink < APPLOG_SINK_SENTINEL; sink++){
+		LOGSINK_Flush(&APPLOG_sinks[sink]);
+	}
+	fflush(stdout);
+
+	sem_post(&APPLOG_output_mutex);
+}
+
+/* ----------------------------------------------------------------------*/
+static struct APPLOG_STAGE_S* APPLOG_GetStage(void)
+{
+	struct APPLOG_STAGE_S* p_stage = APPLOG_stage;
+
+	if (NULL == p_stage){
+		pthread_once(&APPLOG_stage_once, APPLOG_CreateStageKey);
+
+		/* without the key, the buffer of an exiting thread would leak */
+		if (APPLOG_stage_key_ok && (NULL != (p_stage = malloc(sizeof(*p_stage))))){
+			pthread_mutex_init(&p_stage->mutex, NULL);
+			p_stage->len = 0;
+			p_stage->n_lines = 0;
+			p_stage->levels = 0;
+			p_stage->since = 0;
+
+			pthread_mutex_lock(&APPLOG_stages_mutex);
+			p_stage->p_next = APPLOG_stages;
+			APPLOG_stages = p_stage;
+			pthread_mutex_unlock(&APPLOG_stages_mutex);
 
-/**
- * @brief Print time reference, function name and log level to console
- * @param[in] fn the function name
- * @param[in] level_str the log level string
- * @pre[untested] fn must point to a valid function string
- * @pre[untested] level_str must point to a valid log level string
- */
-static void APPLOG_TimeNCo(const char* fn, const char* level_str);
+			pthread_setspecific(APPLOG_stage_key, p_stage);
+			APPLOG_stage = p_stage;
+		}
+	}
+	return p_stage;
+}
 
-/**
- * @brief Get access to log resource
- * @return true if access is granted, false otherwise
- */
-static bool APPLOG_GetLogAccess(void);
+/* ----------------------------------------------------------------------*/
+static void APPLOG_CreateStageKey(void)
+{
+	APPLOG_stage_key_ok = (0 == pthread_key_create(&APPLOG_stage_key, APPLOG_DropStage));
+}
 
-/**
- * @brief Release access to log resource
- * @return true if access is released, false otherwise
- */
-static bool APPLOG_ReleaseLogAccess(void);
+/* ----------------------------------------------------------------------*/
+static void APPLOG_DropStage(void* p_arg)
+{
+	struct APPLOG_STAGE_S* p_stage = p_arg;
+	struct APPLOG_STAGE_S** pp_link;
 
-/* ----------------------------------------------------------------------
- * variable with internal linkage (static) definition section
- * ----------------------------------------------------------------------*/
+	pthread_mutex_lock(&APPLOG_stages_mutex);
+	for (pp_link = &APPLOG_stages; NULL != *pp_link; pp_link = &(*pp_link)->p_next){
+		if (p_stage == *pp_link){
+			*pp_link = p_stage->p_next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&APPLOG_stages_mutex);
 
-static uint64_t APPLOG_level_bits = APPLOG_DEFAULT_LEVEL_BITS; /**< The current log level bits combination */
-static uint64_t APPLOG_debug_bits = APPLOG_DEFAULT_DEBUG_BITS; /**< The current debug bits combination */
+	/* after APPLOG_Breakdown the buffer is empty: nothing is written */
+	pthread_mutex_lock(&p_stage->mutex);
+	APPLOG_StageFlush(p_stage, false);
+	pthread_mutex_unlock(&p_stage->mutex);
 
-/**
- * @brief The address of the log resource access semaphore
- */
-static sem_t APPLOG_log_busy_mutex;
+	pthread_mutex_destroy(&p_stage->mutex);
+	free(p_stage);
+	APPLOG_stage = NULL;
+}
 
-/**
- * @brief State variable representing the initialized state of the component
- */
-static bool APPLOG_is_init;
+/* ----------------------------------------------------------------------*/
+static void APPLOG_StageAppend(
+		struct APPLOG_STAGE_S* const p_stage,
+		const char* const text,
+		const size_t len,
+		const uint16_t line_level)
+{
+	const bool exempt = (LOGSINK_LEVEL_ANY != line_level) && (0 != (line_level & APPLOG_BP_EXEMPT_LEVELS));
+	bool room = true;
 
-/* ----------------------------------------------------------------------
- * exported variable definition section
- * ----------------------------------------------------------------------*/
+	/* an ERROR or CRITICAL line waits for the output rather than be dropped */
+	if (((len > sizeof(p_stage->buf) - p_stage->len) || (APPLOG_STAGE_LINES == p_stage->n_lines))
+			&& !APPLOG_StageFlush(p_stage, exempt)){
+		/* full and the output busy */
+		if (APPLOG_BACKPRESSURE_OVERWRITE_OLDEST == atomic_load_explicit(&APPLOG_backpressure, memory_order_relaxed)){
+			APPLOG_StageOverwrite(p_stage, len);
+		} else {
+			atomic_fetch_add_explicit(&APPLOG_dropped_records, 1, memory_order_relaxed);
+			room = false;
+		}
+	}
 
-/* ----------------------------------------------------------------------
- * exported function definition section
- * ----------------------------------------------------------------------*/
+	if (room){
+		if (0 == p_stage->len){
+			p_stage->since = APPLOG_StageClock();
+		}
+		memcpy(p_stage->buf + p_stage->len, text, len);
+		p_stage->len += len;
+		p_stage->lines[p_stage->n_lines].end = p_stage->len;
+		p_stage->lines[p_stage->n_lines].level = line_level;
+		p_stage->n_lines++;
+		p_stage->levels |= line_level;
+	}
+}
 
-/* --------------------------------------------------------------------- */
-bool APPLOG_Init(void)
+/* ----------------------------------------------------------------------*/
+static void APPLOG_StageOverwrite(struct APPLOG_STAGE_S* const p_stage, const size_t len)
 {
-	static const char* fn="APPLOG_Init";
-	bool rv = false;
-	int init_res;
+	size_t cut = 0;
+	uint32_t lines = 0;
+	uint32_t i;
 
-	if (APPLOG_is_init){
-		printf("%s: [ERROR] Log component already initialized!", fn);
-	} else{
-		init_res = sem_init(&APPLOG_log_busy_mutex, 0, APPLOG_RESOURCE_IDLE);
+	while ((lines < p_stage->n_lines)
+			&& ((len > sizeof(p_stage->buf) - (p_stage->len - cut)) || (APPLOG_STAGE_LINES == p_stage->n_lines - lines))){
+		cut = p_stage->lines[lines].end;
+		lines++;
+	}
+	memmove(p_stage->buf, p_stage->buf + cut, p_stage->len - cut);
+	p_stage->len -= cut;
+	p_stage->n_lines -= lines;
+	p_stage->levels = 0;
 
-		if(0 > init_res){
-			printf("%s: [ERROR] Couldn't initialize semaphore:%s", fn, strerror(errno));
+	for (i = 0; i < p_stage->n_lines; i++){
+		p_stage->lines[i].end = p_stage->lines[i + lines].end - cut;
+		p_stage->lines[i].level = p_stage->lines[i + lines].level;
+		p_stage->levels |= p_stage->lines[i].level;
+	}
+	atomic_fetch_add_explicit(&APPLOG_overwritten_records, lines, memory_order_relaxed);
+}
+
+/* ----------------------------------------------------------------------*/
+static bool APPLOG_StageFlush(struct APPLOG_STAGE_S* const p_stage, const bool exempt)
+{
+	struct LOGSINK_CHUNK_S chunk;
+	bool rv = true;
+
+	if (0 < p_stage->len){
+		if (!APPLOG_TakeOutput(p_stage->n_lines, exempt)){
+			rv = false;
 		} else {
-			APPLOG_is_init = true;
-			rv = true;
+			chunk.text = p_stage->buf;
+			chunk.p_lines = p_stage->lines;
+			chunk.n_lines = p_stage->n_lines;
+			chunk.levels = p_stage->levels;
+			APPLOG_WriteChunks(&chunk, 1);
+			sem_post(&APPLOG_output_mutex);
+			p_stage->len = 0;
+			p_stage->n_lines = 0;
+			p_stage->levels = 0;
 		}
 	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static bool APPLOG_TakeOutput(const uint32_t records, const bool exempt)
+{
+	int policy = atomic_load_explicit(&APPLOG_backpressure, memory_order_relaxed);
+	struct timespec deadline;
+	int wait_res;
+	bool rv = true;
 
+	if (0 == sem_trywait(&APPLOG_output_mutex)){
+		rv = true;
+	} else if (exempt || (APPLOG_BACKPRESSURE_BLOCK == policy)){
+		while ((0 > sem_wait(&APPLOG_output_mutex)) && (EINTR == errno)){
+			;
+		}
+		atomic_fetch_add_explicit(&APPLOG_delayed_records, records, memory_order_relaxed);
+	} else if (APPLOG_BACKPRESSURE_TIMED == policy){
+		APPLOG_Deadline(&deadline, CLOCK_REALTIME, atomic_load_explicit(&APPLOG_bp_timeout_ms, memory_order_relaxed));
+		while ((0 > (wait_res = sem_timedwait(&APPLOG_output_mutex, &deadline))) && (EINTR == errno)){
+			;
+		}
+		rv = (0 == wait_res);
+		if (rv){
+			atomic_fetch_add_explicit(&APPLOG_delayed_records, records, memory_order_relaxed);
+		}
+	} else {
+		rv = false;
+	}
 	return rv;
 }
 
-/* --------------------------------------------------------------------- */
-bool APPLOG_Breakdown(void)
+/* ----------------------------------------------------------------------*/
+static struct LOGRING_SLOT_S* APPLOG_ReserveSlot(const bool exempt)
 {
-	static const char* fn="APPLOG_Breakdown";
-	bool rv = false;
-	int get_value_result;
-	int destroy_result;
-	int mutex_val;
+	int policy = atomic_load_explicit(&APPLOG_backpressure, memory_order_relaxed);
+	struct LOGRING_SLOT_S* p_slot;
+	struct LOGRING_SLOT_S* p_oldest;
+	struct timespec deadline;
+	int wait_res = 0;
+	size_t tries;
 
-	if (!APPLOG_is_init){
-		printf("%s: [ERROR] Log component not initialized!", fn);
-	} else{
+	if (exempt && (APPLOG_BACKPRESSURE_OVERWRITE_OLDEST != policy)){
+		/* an ERROR or CRITICAL record waits rather than be dropped */
+		policy = APPLOG_BACKPRESSURE_BLOCK;
+	}
 
-		get_value_result = sem_getvalue(&APPLOG_log_busy_mutex, &mutex_val);
+	p_slot = LOGRING_Reserve(&APPLOG_ring);
 
-		if (0 > get_value_result){
-			printf("%s: [ERROR] Couldn't get semaphore value:%s", fn, strerror(errno));
-		} else if (APPLOG_RESOURCE_IDLE != mutex_val){
-			APPLOG_Log(fn, LOGLV_WARNING, "Semaphore value unexpected:%d", mutex_val);
+	if (NULL != p_slot){
+		;
+	} else if (pthread_equal(pthread_self(), APPLOG_writer_thread)){
+		/* the writer can't wait for itself */
+		atomic_fetch_add_explicit(&APPLOG_dropped_records, 1, memory_order_relaxed);
+	} else if (APPLOG_BACKPRESSURE_OVERWRITE_OLDEST == policy){
+		/* the ring is safe for more than one consumer: discard as the writer would */
+		for (tries = 0; (NULL == p_slot) && (tries < APPLOG_RING_CAPACITY); tries++){
+			if (NULL != (p_oldest = LOGRING_Acquire(&APPLOG_ring))){
+				LOGRING_Release(&APPLOG_ring, p_oldest);
+				atomic_fetch_add_explicit(&APPLOG_overwritten_records, 1, memory_order_relaxed);
+			}
+			p_slot = LOGRING_Reserve(&APPLOG_ring);
 		}
+		if (NULL == p_slot){
+			atomic_fetch_add_explicit(&APPLOG_dropped_records, 1, memory_order_relaxed);
+		}
+	} else if ((APPLOG_BACKPRESSURE_BLOCK == policy) || (APPLOG_BACKPRESSURE_TIMED == policy)){
+		/* sleep until the writer frees a slot: announce first, then retry, then wait */
+		APPLOG_Deadline(&deadline, CLOCK_REALTIME, atomic_load_explicit(&APPLOG_bp_timeout_ms, memory_order_relaxed));
+		atomic_fetch_add(&APPLOG_space_waiters, 1);
+		atomic_thread_fence(memory_order_seq_cst);
+		do {
+			APPLOG_WakeWriter();
+			if (NULL != (p_slot = LOGRING_Reserve(&APPLOG_ring))){
+				;
+			} else if (APPLOG_BACKPRESSURE_BLOCK == policy){
+				wait_res = sem_wait(&APPLOG_space_wakeup);
+			} else {
+				wait_res = sem_timedwait(&APPLOG_space_wakeup, &deadline);
+			}
+		} while ((NULL == p_slot) && ((0 == wait_res) || (EINTR == errno)));
+		atomic_fetch_sub(&APPLOG_space_waiters, 1);
 
-		destroy_result = sem_destroy(&APPLOG_log_busy_mutex);
-
-		if (0 > destroy_result){
-			APPLOG_Log(fn, LOGLV_WARNING, "Couldn't destroy semaphore:%s", strerror(errno));
+		if (NULL != p_slot){
+			atomic_fetch_add_explicit(&APPLOG_delayed_records, 1, memory_order_relaxed);
 		} else {
-			rv = true;
+			atomic_fetch_add_explicit(&APPLOG_dropped_records, 1, memory_order_relaxed);
 		}
-
-		APPLOG_is_init = false;
+	} else {
+		atomic_fetch_add_explicit(&APPLOG_dropped_records, 1, memory_order_relaxed);
 	}
-	return rv;
+	return p_slot;
 }
 
 /* ----------------------------------------------------------------------*/
-void APPLOG_SetLogBits(const uint64_t bits)
+static void APPLOG_ReportBackpressure(void)
 {
-	APPLOG_debug_bits |= bits;
+	static const char* fn = "APPLOG_ReportBackpressure";
+	struct APPLOG_COUNTERS_S counters;
+
+	APPLOG_GetCounters(&counters);
+	if ((0 != counters.dropped) || (0 != counters.overwritten) || (0 != counters.delayed)){
+		APPLOG_Log(fn, LOGLV_WARNING, "Backpressure (%s): %llu records dropped, %llu overwritten, %llu delayed",
+				APPLOG_bp_names[atomic_load(&APPLOG_backpressure)], (unsigned long long)counters.dropped,
+				(unsigned long long)counters.overwritten, (unsigned long long)counters.delayed);
+	}
 }
 
 /* ----------------------------------------------------------------------*/
-void APPLOG_ResetLogBits(const uint64_t bits)
+static void APPLOG_Deadline(struct timespec* const p_ts, const clockid_t clock_id, const uint32_t ms)
 {
-	APPLOG_debug_bits &= ~bits;
+	clock_gettime(clock_id, p_ts);
+	p_ts->tv_sec += ms / 1000;
+	p_ts->tv_nsec += (ms % 1000) * 1000000L;
+	if (p_ts->tv_nsec >= 1000000000L){
+		p_ts->tv_sec++;
+		p_ts->tv_nsec -= 1000000000L;
+	}
 }
 
 /* ----------------------------------------------------------------------*/
-void APPLOG_LogDebug(
-		const char* fn,
-		const uint64_t bits,
-		char* fmt, ...)
+static void APPLOG_ApplyThread(uint32_t* const p_gen)
 {
-	va_list args;
+	static const char* fn = "APPLOG_ApplyThread";
+	static const int policies[APPLOG_SCHED_SENTINEL] = { SCHED_OTHER, SCHED_IDLE };
+	struct APPLOG_THREAD_S thread;
+	struct sched_param param;
+	cpu_set_t cpus;
+	uint32_t gen = atomic_load(&APPLOG_thread_gen);
+	int cpu;
+	int res;
 
-	if (APPLOG_level_bits & LOGLV_DEBUG){
-		if (bits & APPLOG_debug_bits){
-			if (APPLOG_GetLogAccess()){
-				APPLOG_TimeNCo(fn, "DEBUG");
+	if (gen != *p_gen){
+		*p_gen = gen;
 
-				va_start(args, fmt);
-				vprintf(fmt, args);
-				va_end(args);
-				putc('\n', stdout);
+		pthread_mutex_lock(&APPLOG_thread_mutex);
+		thread = APPLOG_thread;
+		pthread_mutex_unlock(&APPLOG_thread_mutex);
 
-				if (!APPLOG_ReleaseLogAccess()){
-					printf("APPLOG_LogDebug: Releasing log access fails!");
-				}
+		/* no CPUs selected: every CPU the process may use */
+		CPU_ZERO(&cpus);
+		for (cpu = 0; cpu < CPU_SETSIZE; cpu++){
+			if ((0 == thread.cpus) || ((APPLOG_CPU_MAX > cpu) && (0 != (thread.cpus & (1ULL << cpu))))){
+				CPU_SET(cpu, &cpus);
 			}
 		}
+		if (0 != (res = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus))){
+			APPLOG_Log(fn, LOGLV_ERROR, "Couldn't set the CPUs 0x%llx:%s", (unsigned long long)thread.cpus, strerror(res));
+		}
+
+		memset(&param, 0, sizeof(param));
+		if (0 != (res = pthread_setschedparam(pthread_self(), policies[thread.policy], &param))){
+			APPLOG_Log(fn, LOGLV_ERROR, "Couldn't set the %s policy:%s", APPLOG_sched_names[thread.policy], strerror(res));
+		}
+
+		/* the nice value belongs to the thread on Linux */
+		if (0 > setpriority(PRIO_PROCESS, gettid(), thread.nice)){
+			APPLOG_Log(fn, LOGLV_ERROR, "Couldn't set nice %d:%s", thread.nice, strerror(errno));
+		}
+
+		APPLOG_Log(fn, LOGLV_INFO, "Log writer thread: CPUs 0x%llx, policy %s, nice %d",
+				(unsigned long long)thread.cpus, APPLOG_sched_names[thread.policy], thread.nice);
 	}
 }
 
 /* ----------------------------------------------------------------------*/
-void APPLOG_Log(
-		const char* fn,
-		const uint64_t level,
-		char* fmt, ...)
+static void APPLOG_RecordFlush(const uint32_t depth, const uint64_t ns)
 {
-	char level_str[20] = "";
-	bool log_out = false;
-	va_list args;
-
-	if (LOGLV_UNDEFINED == level || LOGLV_SENTINEL < level){
-		strcat(level_str, "????");
-		log_out = true;
-	} else {
-		if      (level & LOGLV_INFO)     strcat(level_str, ANSI_COLOR_GREEN   "INFO"     ANSI_COLOR_RESET);
-		else if (level & LOGLV_DEBUG)    strcat(level_str, ANSI_COLOR_BLUE    "DEBUG"    ANSI_COLOR_RESET);
-		else if (level & LOGLV_WARNING)  strcat(level_str, ANSI_COLOR_YELLOW  "WARNING"  ANSI_COLOR_RESET);
-		else if (level & LOGLV_ERROR)    strcat(level_str, ANSI_COLOR_RED     "ERROR"    ANSI_COLOR_RESET);
-		else if (level & LOGLV_CRITICAL) strcat(level_str, ANSI_COLOR_RED     "CRITICAL" ANSI_COLOR_RESET);
-		else if (level & LOGLV_TEST)     strcat(level_str, ANSI_COLOR_MAGENTA "TEST"     ANSI_COLOR_RESET);
+	atomic_store_explicit(&APPLOG_stat_depth, depth, memory_order_relaxed);
+	if (depth > atomic_load_explicit(&APPLOG_stat_max_depth, memory_order_relaxed)){
+		atomic_store_explicit(&APPLOG_stat_max_depth, depth, memory_order_relaxed);
 	}
+	atomic_store_explicit(&APPLOG_stat_last_ns, ns, memory_order_relaxed);
+	if (ns > atomic_load_explicit(&APPLOG_stat_max_ns, memory_order_relaxed)){
+		atomic_store_explicit(&APPLOG_stat_max_ns, ns, memory_order_relaxed);
+	}
+	atomic_fetch_add_explicit(&APPLOG_stat_total_ns, ns, memory_order_relaxed);
+	atomic_fetch_add_explicit(&APPLOG_stat_flushes, 1, memory_order_relaxed);
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_ReportWriter(void)
+{
+	static const char* fn = "APPLOG_ReportWriter";
+	struct APPLOG_WRITER_STATS_S stats;
 
-	if (level & APPLOG_level_bits){
-		log_out = true;
+	APPLOG_GetWriterStats(&stats);
+	if (0 != stats.flushes){
+		APPLOG_Log(fn, LOGLV_INFO, "Log writer: %llu flushes, max queue depth %u of %u, flush latency avg %llu ns, max %llu ns",
+				(unsigned long long)stats.flushes, (unsigned)stats.max_depth, (unsigned)stats.capacity,
+				(unsigned long long)(stats.total_flush_ns / stats.flushes), (unsigned long long)stats.max_flush_ns);
 	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_FlushStages(const bool all)
+{
+	struct APPLOG_STAGE_S* stages[APPLOG_STAGE_IOV_MAX];
+	struct LOGSINK_CHUNK_S chunks[APPLOG_STAGE_IOV_MAX];
+	struct APPLOG_STAGE_S* p_stage;
+	int64_t oldest = APPLOG_StageClock() - APPLOG_STAGE_AGE_MS * 1000000LL;
+	int count = 0;
 
-	if(log_out){
-		if (APPLOG_GetLogAccess()){
-			APPLOG_TimeNCo(fn, level_str);
+	pthread_mutex_lock(&APPLOG_stages_mutex);
 
-			va_start(args, fmt);
-			vprintf(fmt, args);
-			va_end(args);
-			putc('\n', stdout);
+	for (p_stage = APPLOG_stages; NULL != p_stage; p_stage = p_stage->p_next){
+		if (all){
+			pthread_mutex_lock(&p_stage->mutex);
+		} else if (0 != pthread_mutex_trylock(&p_stage->mutex)){
+			/* the owner is logging: it checks the age itself */
+			continue;
+		}
 
-			if (!APPLOG_ReleaseLogAccess()){
-				printf("APPLOG_LogDebug: Releasing log access fails!");
-			}
+		if ((0 < p_stage->len) && (all || (p_stage->since <= oldest))){
+			stages[count] = p_stage;
+			chunks[count].text = p_stage->buf;
+			chunks[count].p_lines = p_stage->lines;
+			chunks[count].n_lines = p_stage->n_lines;
+			chunks[count].levels = p_stage->levels;
+			count++;
+		} else {
+			pthread_mutex_unlock(&p_stage->mutex);
+		}
+
+		if (APPLOG_STAGE_IOV_MAX == count){
+			APPLOG_WriteStages(stages, chunks, count);
+			count = 0;
 		}
 	}
-}
+	if (0 < count){
+		APPLOG_WriteStages(stages, chunks, count);
+	}
 
-/* ----------------------------------------------------------------------
- * functions with internal linkage (static) definition section
- * ----------------------------------------------------------------------*/
+	pthread_mutex_unlock(&APPLOG_stages_mutex);
+}
 
 /* ----------------------------------------------------------------------*/
-static void APPLOG_TimeNCo(const char* fn, const char* level_str)
+static void APPLOG_WriteStages(
+		struct APPLOG_STAGE_S** const p_stages,
+		const struct LOGSINK_CHUNK_S* const p_chunks,
+		const int count)
 {
-	struct timeval current_time_fine;
-	time_t current_time;
-	struct tm broken_time;
+	int i;
 
-	time(&current_time);
-	gettimeofday(&current_time_fine, NULL);
-	{
-		char time_str[20];
-		unsigned long ms = current_time_fine.tv_usec/1000;
+	sem_wait(&APPLOG_output_mutex);
+	APPLOG_WriteChunks(p_chunks, count);
+	sem_post(&APPLOG_output_mutex);
 
-		strftime(time_str, 20, "%Y-%m-%d %X", localtime_r(&current_time, &broken_time));
-		printf("%s.%lu) [%s] %s: ", time_str, ms, level_str, fn);
+	for (i = 0; i < count; i++){
+		p_stages[i]->len = 0;
+		p_stages[i]->n_lines = 0;
+		p_stages[i]->levels = 0;
+		pthread_mutex_unlock(&p_stages[i]->mutex);
 	}
 }
 
-/* --------------------------------------------------------------------- */
-static bool APPLOG_GetLogAccess(void)
+/* ----------------------------------------------------------------------*/
+static int64_t APPLOG_StageClock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(APPLOG_SITE_CLOCKID, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ----------------------------------------------------------------------*/
+static bool APPLOG_StartFlusher(void)
 {
-	static const char* fn = "APPLOG_GetLogAccess";
+	static const char* fn = "APPLOG_StartFlusher";
 	bool rv = false;
-	int wait_res;
+	int create_res;
 
-	if (!APPLOG_is_init){
-		printf("%s: Log component not initialized!\n", fn);
+	if (0 > sem_init(&APPLOG_flusher_wakeup, 0, 0)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't initialize flusher semaphore:%s", strerror(errno));
 	} else {
-		/** @todo implement timeout */
-		wait_res = sem_wait(&APPLOG_log_busy_mutex);
+		atomic_store(&APPLOG_flusher_running, true);
+
+		create_res = pthread_create(&APPLOG_flusher_thread, NULL, APPLOG_Flusher, NULL);
 
-		if (0 > wait_res){
-			APPLOG_Log(fn, LOGLV_ERROR, "Error getting memory resource access:%s", strerror(errno));
-		} else if (APPLOG_RESOURCE_BUSY != wait_res){
-			APPLOG_Log(fn, LOGLV_ERROR, "Illegal semaphore value:%d", wait_res);
+		if (0 != create_res){
+			APPLOG_Log(fn, LOGLV_ERROR, "Couldn't create flusher thread:%s", strerror(create_res));
+			sem_destroy(&APPLOG_flusher_wakeup);
 		} else {
+			pthread_setname_np(APPLOG_flusher_thread, "applog-flush");
+			APPLOG_flusher_active = true;
 			rv = true;
 		}
 	}
 	return rv;
 }
 
-/* --------------------------------------------------------------------- */
-static bool APPLOG_ReleaseLogAccess(void)
+/* ----------------------------------------------------------------------*/
+static void APPLOG_StopFlusher(void)
+{
+	if (APPLOG_flusher_active){
+		atomic_store(&APPLOG_flusher_running, false);
+		sem_post(&APPLOG_flusher_wakeup);
+		pthread_join(APPLOG_flusher_thread, NULL);
+		sem_destroy(&APPLOG_flusher_wakeup);
+		APPLOG_flusher_active = false;
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void* APPLOG_Flusher(void* p_arg)
+{
+	struct timespec deadline;
+	uint32_t thread_gen = 0;
+
+	(void)p_arg;
+
+	while (atomic_load(&APPLOG_flusher_running)){
+		APPLOG_ApplyThread(&thread_gen);
+
+		APPLOG_Deadline(&deadline, CLOCK_REALTIME, APPLOG_STAGE_AGE_MS);
+		if ((0 > sem_timedwait(&APPLOG_flusher_wakeup, &deadline)) && (ETIMEDOUT == errno)){
+			APPLOG_ReportRepeats(false);
+			APPLOG_FlushStages(false);
+		}
+	}
+	return NULL;
+}
+
+/* ----------------------------------------------------------------------*/
+static bool APPLOG_LoadFileConfig(const char* const filename)
 {
-	static const char* fn = "APPLOG_ReleaseLogAccess";
+	static const char* fn="APPLOG_LoadFileConfig";
+	struct LOGFILE_CONFIG_S file_config;
+	uint64_t console_levels;
+	int64_t value;
+	uint64_t bits;
+	int get_res;
 	bool rv = false;
-	int post_res;
-	int val_res;
-	int val;
 
-	if (!APPLOG_is_init){
-		printf("%s: Log component not initialized!\n", fn);
+	memset(&file_config, 0, sizeof(file_config));
+	file_config.segment_size = APPLOG_DEFAULT_SEGMENT_SIZE;
+	file_config.rotate_seconds = APPLOG_DEFAULT_ROTATE_SECONDS;
+	file_config.max_segments = APPLOG_DEFAULT_MAX_SEGMENTS;
+	file_config.sync_bytes = APPLOG_DEFAULT_SYNC_BYTES;
+
+	get_res = APPCFG_GetConfigStringParamFromFile(filename, APPLOG_CFG_FILE, file_config.path, sizeof(file_config.path));
+
+	if (0 > get_res){
+		APPLOG_Log(fn, LOGLV_ERROR, "Log output left unchanged: no usable %s in %s", APPLOG_CFG_FILE, filename);
+	} else if (APPCFG_NOT_FOUND == get_res){
+		/* the log output stays as it is */
+		rv = true;
 	} else {
-		/** @todo implement timeout */
-		post_res = sem_post(&APPLOG_log_busy_mutex);
+		if ((0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_SEGMENT_SIZE, &value)) && (0 < value)){
+			file_config.segment_size = value;
+		}
+		if ((0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_ROTATE_SECONDS, &value)) && (0 <= value) && (UINT32_MAX >= value)){
+			file_config.rotate_seconds = value;
+		}
+		if ((0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_MAX_SEGMENTS, &value)) && (0 <= value) && (UINT32_MAX >= value)){
+			file_config.max_segments = value;
+		}
+		if ((0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_SYNC_BYTES, &value)) && (0 <= value)){
+			file_config.sync_bytes = value;
+		}
+		if (0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_COMPRESS, &value)){
+			file_config.compress = (0 != value);
+		}
+		if ((0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_INDEX_LINES, &value)) && (0 <= value) && (UINT32_MAX >= value)){
+			file_config.index_lines = value;
+		}
+		if (0 == APPCFG_GetConfigUint64ParamFromFile(filename, APPLOG_CFG_FILE_LEVELS, &bits)){
+			APPLOG_SetSinkLevels(APPLOG_SINK_FILE, bits);
+		}
 
-		if (0 > post_res){
-			APPLOG_Log(fn, LOGLV_ERROR, "Coudn't release memory resource access:%s", strerror(errno));
+		/* without levels of its own, the console gives way to a log file */
+		if (0 == APPCFG_GetConfigUint64ParamFromFile(filename, APPLOG_CFG_CONSOLE_LEVELS, &bits)){
+			console_levels = bits;
 		} else {
-			val_res = sem_getvalue(&APPLOG_log_busy_mutex, &val);
+			console_levels = ('\0' == file_config.path[0]) ? APPLOG_SINK_ALL_LEVELS : 0;
+		}
 
-			if (0 > val_res){
-				APPLOG_Log(fn, LOGLV_ERROR, "Coudn't get memory resource access semaphore value:%s", strerror(errno));
-			} else if ((APPLOG_RESOURCE_IDLE != val) && (APPLOG_RESOURCE_BUSY != val)){
-				APPLOG_Log(fn, LOGLV_ERROR, "Illegal memory resource access semaphore value:%d", val);
-			} else {
-				rv = true;
-			}
+		rv = APPLOG_SetFileOutput(&file_config, console_levels);
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static bool APPLOG_LoadSinkConfig(const char* const filename)
+{
+	char socket_path[APPLOG_FILENAME_SIZE] = "";
+	int64_t value;
+	uint64_t bits;
+	bool rv = true;
+
+	if (0 == APPCFG_GetConfigUint64ParamFromFile(filename, APPLOG_CFG_SOCKET_LEVELS, &bits)){
+		APPLOG_SetSinkLevels(APPLOG_SINK_SOCKET, bits);
+	}
+	if (0 == APPCFG_GetConfigUint64ParamFromFile(filename, APPLOG_CFG_MEMORY_LEVELS, &bits)){
+		APPLOG_SetSinkLevels(APPLOG_SINK_MEMORY, bits);
+	}
+	if (0 == APPCFG_GetConfigStringParamFromFile(filename, APPLOG_CFG_SOCKET, socket_path, sizeof(socket_path))){
+		rv = APPLOG_SetLogSocket(socket_path);
+	}
+	if ((0 == APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_MEMORY_RECORDS, &value)) && (0 <= value) && (UINT32_MAX >= value)){
+		rv = APPLOG_SetMemorySink(value) && rv;
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static bool APPLOG_LoadThreadConfig(const char* const filename)
+{
+	static const char* fn="APPLOG_LoadThreadConfig";
+	struct APPLOG_THREAD_S thread;
+	char policy_name[APPLOG_BP_NAME_SIZE] = "";
+	uint64_t cpus;
+	int64_t nice;
+	int policy;
+	int get_res;
+	int differs;
+	bool rv = true;
+
+	pthread_mutex_lock(&APPLOG_thread_mutex);
+	thread = APPLOG_thread;
+	pthread_mutex_unlock(&APPLOG_thread_mutex);
+
+	/* a mask like taskset's */
+	get_res = APPCFG_GetConfigUint64ParamFromFile(filename, APPLOG_CFG_WRITER_CPUS, &cpus);
+	if (0 == get_res){
+		thread.cpus = cpus;
+	} else if (0 > get_res){
+		rv = false;
+	}
+	if ((0 == APPCFG_GetConfigStringParamFromFile(filename, APPLOG_CFG_WRITER_POLICY, policy_name, sizeof(policy_name)))
+			&& ('\0' != policy_name[0])){
+		for (policy = 0; (policy < APPLOG_SCHED_SENTINEL) && (0 != strcmp(policy_name, APPLOG_sched_names[policy])); policy++){
+			;
+		}
+		if (APPLOG_SCHED_SENTINEL == policy){
+			APPLOG_Log(fn, LOGLV_ERROR, "Unknown scheduling policy:%s", policy_name);
+			rv = false;
+		} else {
+			thread.policy = policy;
 		}
 	}
+	get_res = APPCFG_GetConfigInt64ParamFromFile(filename, APPLOG_CFG_WRITER_NICE, &nice);
+	if (0 > get_res){
+		rv = false;
+	} else if (APPCFG_NOT_FOUND == get_res){
+		;
+	} else if ((APPLOG_NICE_MIN > nice) || (APPLOG_NICE_MAX < nice)){
+		APPLOG_Log(fn, LOGLV_ERROR, "Illegal nice value:%lld", (long long)nice);
+		rv = false;
+	} else {
+		thread.nice = nice;
+	}
+
+	/* a reload with the same settings leaves the thread alone */
+	pthread_mutex_lock(&APPLOG_thread_mutex);
+	differs = memcmp(&thread, &APPLOG_thread, sizeof(thread));
+	pthread_mutex_unlock(&APPLOG_thread_mutex);
+
+	if (rv && (0 != differs)){
+		rv = APPLOG_SetWriterThread(&thread);
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static bool APPLOG_SetFileOutput(const struct LOGFILE_CONFIG_S* const p_config, const uint64_t console_levels)
+{
+	static const char* fn = "APPLOG_SetFileOutput";
+	struct LOGSINK_S new_sink;
+	bool active;
+	bool unchanged;
+	bool rv = true;
+
+	sem_wait(&APPLOG_output_mutex);
+	active = (NULL != APPLOG_sinks[APPLOG_SINK_FILE].p_write);
+	unchanged = (active && (0 == memcmp(&APPLOG_sinks[APPLOG_SINK_FILE].file.config, p_config, sizeof(*p_config))))
+			|| (!active && ('\0' == p_config->path[0]));
+	sem_post(&APPLOG_output_mutex);
+
+	if (unchanged){
+		APPLOG_SetSinkLevels(APPLOG_SINK_CONSOLE, console_levels);
+	} else if (('\0' != p_config->path[0])
+			&& !LOGSINK_OpenFile(&new_sink, p_config, APPLOG_sink_levels[APPLOG_SINK_FILE])){
+		APPLOG_Log(fn, LOGLV_ERROR, "Couldn't open log file %s, output unchanged", p_config->path);
+		rv = false;
+	} else {
+		APPLOG_SwapSink(APPLOG_SINK_FILE, ('\0' != p_config->path[0]) ? &new_sink : NULL);
+		APPLOG_SetSinkLevels(APPLOG_SINK_CONSOLE, console_levels);
+
+		APPLOG_Log(fn, LOGLV_INFO, "Log file: %s", ('\0' != p_config->path[0]) ? p_config->path : "none");
+	}
 	return rv;
 }
+
+/* ----------------------------------------------------------------------*/
+static void APPLOG_SwapSink(const enum APPLOG_SINK_E sink, const struct LOGSINK_S* const p_new)
+{
+	struct LOGSINK_S old_sink;
+
+	/* the staged lines belong to the former output */
+	APPLOG_FlushStages(true);
+
+	sem_wait(&APPLOG_output_mutex);
+	fflush(stdout);
+	old_sink = APPLOG_sinks[sink];
+	if (NULL != p_new){
+		APPLOG_sinks[sink] = *p_new;
+		APPLOG_sinks[sink].levels = APPLOG_sink_levels[sink];
+	} else {
+		APPLOG_sinks[sink].p_write = NULL;
+		APPLOG_sinks[sink].p_flush = NULL;
+		APPLOG_sinks[sink].p_close = NULL;
+	}
+	sem_post(&APPLOG_output_mutex);
+
+	/* closing may wait (log file compression): not while holding the output */
+	LOGSINK_Close(&old_sink);
+}
+
+/* ----------------------------------------------------------------------*/
+static void* APPLOG_Writer(void* p_arg)
+{
+	struct LOGRING_SLOT_S* p_slot;
+	struct timespec deadline;
+	struct timespec start;
+	struct timespec end;
+	uint32_t thread_gen = 0;
+	uint32_t depth;
+	uint32_t freed;
+	bool running;
+	bool drained;
+
+	(void)p_arg;
+
+	do {
+		APPLOG_ApplyThread(&thread_gen);
+
+		/* sample the flag first: a stop request is only honored after a drain */
+		running = atomic_load(&APPLOG_writer_running);
+		drained = false;
+		freed = 0;
+		depth = LOGRING_Depth(&APPLOG_ring);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		while (NULL != (p_slot = LOGRING_Acquire(&APPLOG_ring))){
+			APPLOG_WriteSlot(p_slot);
+			LOGRING_Release(&APPLOG_ring, p_slot);
+			if (APPLOG_SPACE_BATCH == ++freed){
+				APPLOG_WakeProducer();
+				freed = 0;
+			}
+			drained = true;
+		}
+		/* the ring is empty: nobody waits for the next batch */
+		APPLOG_WakeProducer();
+
+		if (NULL != APPLOG_binary_fp){
+			fflush(APPLOG_binary_fp);
+		} else {
+			APPLOG_FlushOut();
+		}
+		/* lines logged while the writer wasn't running */
+		APPLOG_FlushStages(false);
+
+		if (drained){
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			APPLOG_RecordFlush(depth, (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec));
+		}
+
+		if (running){
+			atomic_store(&APPLOG_writer_sleeping, true);
+			atomic_thread_fence(memory_order_seq_cst);
+
+			if (0 == LOGRING_Depth(&APPLOG_ring)){
+				APPLOG_Deadline(&deadline, CLOCK_REALTIME, APPLOG_WRITER_IDLE_MS);
+				while ((0 > sem_timedwait(&APPLOG_writer_wakeup, &deadline)) && (EINTR == errno)){
+					;
+				}
+			} else if (!drained){
+				/* a producer reserved a slot but has not committed it yet */
+				sched_yield();
+			}
+			atomic_store(&APPLOG_writer_sleeping, false);
+		}
+	} while (running);
+
+	return NULL;
+}
+
+/* --------------------------------------------------------------------- */
+static void APPLOG_UpdateFilters(void)
+{
+	uint64_t level_bits;
+
+	if (atomic_load(&APPLOG_flight_active)){
+		/* the flight recorder wants every record the build kept */
+		atomic_store_explicit(&APPLOG_log_filter, LOGLV_SENTINEL - 1, memory_order_relaxed);
+		atomic_store_explicit(&APPLOG_debug_filter, LOGBIT_SENTINEL - 1, memory_order_relaxed);
+	} else {
+		level_bits = atomic_load_explicit(&APPLOG_level_bits, memory_order_relaxed);
+		atomic_store_explicit(&APPLOG_log_filter, level_bits, memory_order_relaxed);
+		atomic_store_explicit(&APPLOG_debug_filter,
+				(level_bits & LOGLV_DEBUG) ? atomic_load_explicit(&APPLOG_debug_bits, memory_order_relaxed) : 0,
+				memory_order_relaxed);
+	}
+	APPLOG_UpdateSites();
+}
@@ -13,11 +13,13 @@
  * include section
  * ----------------------------------------------------------------------*/
 /* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdatomic.h>
 #include <stdbool.h>
 
 /* project specific includes - if possible alphabetically ordered */
 
 /* module specific includes (log) - if possible alphabetically ordered */
+#include "logfmt_t.h"
 
 /* component include */
 #include "log_t.h"
@@ -32,21 +34,283 @@
  */
 bool APPLOG_Init(void);
 
+/**
+ * @brief Select how log records are delivered.
+ * @param[in] mode the delivery mode - refer to APPLOG_MODE_E
+ * @pre[tested] the component must not be initialized yet
+ * @pre[tested] mode must be < APPLOG_MODE_SENTINEL
+ * @return true if the mode is accepted, false otherwise.
+ * @details
+ * In APPLOG_MODE_SYNC, every thread renders into its own staging buffer;
+ * the buffer is written with one writev when it is full, when its oldest
+ * line is 100 ms old, right after an ERROR or CRITICAL line and at
+ * APPLOG_Breakdown.
+ * In APPLOG_MODE_ASYNC, callers push formatted records into a bounded
+ * lock-free ring and a dedicated writer thread prints them. When the ring
+ * is full the backpressure policy applies, refer to APPLOG_SetBackpressure.
+ * APPLOG_Breakdown flushes the ring before it returns.
+ * In APPLOG_MODE_DEFERRED, callers only store the timestamp, the fn and fmt
+ * pointers and the raw arguments; the writer thread renders the text or,
+ * see APPLOG_SetBinaryOutput, writes the records to a binary stream.
+ * fn and fmt must then stay valid for the life of the process (literals).
+ */
+bool APPLOG_SetMode(const enum APPLOG_MODE_E mode);
+
+/**
+ * @brief Select colored (ANSI) or plain level indications
+ * @param[in] color true for colors (default), false for plain text
+ * @pre[tested] the component must not be initialized
+ * @return true if the selection is accepted, false otherwise.
+ */
+bool APPLOG_SetColor(const bool color);
+
+/**
+ * @brief Select the binary stream of the deferred mode
+ * @param[in] filename the file to (re)create, NULL to render to the console
+ * @pre[tested] the component must not be initialized yet
+ * @return true if the output is accepted, false otherwise.
+ * @details
+ * The stream is turned back into text by the logdecode tool.
+ */
+bool APPLOG_SetBinaryOutput(const char* const filename);
+
+/**
+ * @brief Apply the log settings of a configuration file
+ * @param[in] filename the configuration file (refer to config.cfg)
+ * @pre[tested] the component must be initialized
+ * @return true if the settings are applied, false otherwise.
+ * @details
+ * Every parameter is optional: a missing one keeps its value, without an
+ * error. Numbers are decimal, or hexadecimal with 0x.
+ * LOG_LEVEL and LOG_DEBUG_BITS (LOGLV_xxx and LOGBIT_xxx bit combinations,
+ * all 64 bits) replace the log level and debug bits.
+ * LOG_FILE selects a memory-mapped log file instead of the console (empty
+ * for the console). LOG_FILE_SEGMENT_SIZE (bytes), LOG_FILE_ROTATE_SECONDS
+ * (0 for size-only rotation), LOG_FILE_MAX_SEGMENTS and LOG_FILE_SYNC_BYTES
+ * (bytes appended between two msync) tune the rotation and write-back;
+ * LOG_FILE_COMPRESS=1 compresses the rotated segments on a background
+ * thread (path.1.lz, ..., read back with logdecode -z).
+ * LOG_FILE_INDEX_LINES (0 for none) gives every segment an index with a
+ * mark per that many lines, for the time range queries of logquery.
+ * Settings identical to the active ones leave the log file untouched.
+ * LOG_CONSOLE_LEVELS and LOG_FILE_LEVELS (LOGLV_xxx bits) select
+ * the levels of both; without LOG_CONSOLE_LEVELS the console takes every
+ * level without a log file and none with one. LOG_SOCKET (empty for none)
+ * and LOG_SOCKET_LEVELS add a socket output, LOG_MEMORY_RECORDS (0 for
+ * none) and LOG_MEMORY_LEVELS a memory output, refer to APPLOG_SetSinkLevels.
+ * LOG_RATE_LIMIT (0 for none, the default) and LOG_RATE_BURST set the rate
+ * limit of every log statement, refer to APPLOG_SetRateLimit.
+ * LOG_COLLAPSE_REPEATS=1 collapses repeated messages, refer to
+ * APPLOG_SetRepeatCollapse.
+ * LOG_CRASH_FILE (empty for none, the default) and LOG_CRASH_RECORDS start
+ * the flight recorder, e.g. LOG_CRASH_FILE=RCMsx.crash to diagnose crashes
+ * in the field; it renders every record, DEBUG included, refer to
+ * APPLOG_StartFlightRecorder. LOG_BACKPRESSURE (block, timed, drop or
+ * overwrite) and LOG_BACKPRESSURE_TIMEOUT_MS select the backpressure
+ * policy, refer to APPLOG_SetBackpressure. LOG_WRITER_CPUS (a CPU bit mask,
+ * e.g. 0xC for CPUs 2 and 3, 0 for any), LOG_WRITER_POLICY (other or idle)
+ * and LOG_WRITER_NICE (-20 .. 19) place the writer thread, refer to
+ * APPLOG_SetWriterThread.
+ */
+bool APPLOG_LoadConfig(const char* const filename);
+
+/**
+ * @brief Switch the log output to a memory-mapped log file with the
+ * default rotation settings, or back to the console
+ * @param[in] path the log file, NULL or empty for the console
+ * @pre[tested] the component must be initialized
+ * @return true on success, false otherwise (the output is unchanged).
+ */
+bool APPLOG_SetLogFile(const char* const path);
+
+/**
+ * @brief Select the levels written by one log output
+ * @param[in] sink the log output - refer to APPLOG_SINK_E
+ * @param[in] level_bits the LOGLV_xxx bits, 0 for none
+ * @pre[tested] the component must be initialized
+ * @pre[tested] sink must be < APPLOG_SINK_SENTINEL
+ * @return true if accepted, false otherwise.
+ * @details
+ * The levels apply to the next lines written, staged lines included, and
+ * survive reopening the output. Lines are rendered once, whatever the
+ * number of outputs taking them.
+ */
+bool APPLOG_SetSinkLevels(const enum APPLOG_SINK_E sink, const uint64_t level_bits);
+
+/**
+ * @brief Send the log lines to a UNIX datagram socket as well, one
+ * syslog-style datagram ("<PRI>" + line) per line
+ * @param[in] path the socket, e.g. /dev/log, NULL or empty for none
+ * @pre[tested] the component must be initialized
+ * @return true on success, false otherwise (the socket output is unchanged).
+ * @details
+ * The datagrams are sent without waiting: the lines a busy collector
+ * doesn't take are counted as dropped, refer to APPLOG_GetCounters.
+ */
+bool APPLOG_SetLogSocket(const char* const path);
+
+/**
+ * @brief Keep the most recent log lines in memory as well
+ * @param[in] records the number of lines kept (rounded up to a power of
+ * two), 0 for none
+ * @pre[tested] the component must be initialized
+ * @return true on success, false otherwise (the memory output is unchanged).
+ */
+bool APPLOG_SetMemorySink(const uint32_t records);
+
+/**
+ * @brief Write the lines kept in memory, oldest first
+ * @param[in] fd the file descriptor to write to
+ * @details
+ * Does nothing without a memory output, refer to APPLOG_SetMemorySink.
+ */
+void APPLOG_DumpMemorySink(const int fd);
+
+/**
+ * @brief Select what a log call does when the output can't keep up
+ * @param[in] policy the policy - refer to APPLOG_BACKPRESSURE_E
+ * @param[in] timeout_ms the max wait of APPLOG_BACKPRESSURE_TIMED (ms)
+ * @pre[tested] policy must be < APPLOG_BACKPRESSURE_SENTINEL
+ * @return true if the policy is accepted, false otherwise.
+ * @details
+ * The default, APPLOG_BACKPRESSURE_DROP_NEWEST, doesn't hold up a log call:
+ * in the asynchronous modes the record is dropped when the ring is full, in
+ * the synchronous mode the line is dropped when the staging buffer of the
+ * thread is full and the output is taken by another thread (refer to
+ * APPLOG_GetCounters). ERROR and CRITICAL records are never dropped, with
+ * any policy but APPLOG_BACKPRESSURE_OVERWRITE_OLDEST: they wait for the
+ * output, as with APPLOG_BACKPRESSURE_BLOCK. Changes apply at once. A write already in progress to a stalled console
+ * isn't interrupted: in the synchronous mode it holds up the thread doing
+ * it, the other threads follow the policy. In the asynchronous modes only
+ * the writer thread writes, so the policy bounds every log call.
+ */
+bool APPLOG_SetBackpressure(const enum APPLOG_BACKPRESSURE_E policy, const uint32_t timeout_ms);
+
+/**
+ * @brief Set where and how the log writer thread runs
+ * @param[in] p_thread the CPUs, scheduling policy and nice value
+ * @pre[tested] p_thread must not be null
+ * @pre[tested] policy must be < APPLOG_SCHED_SENTINEL, nice within -20 .. 19
+ * @return true if accepted, false otherwise.
+ * @details
+ * Applies to the writer thread of the asynchronous modes, or to the thread
+ * flushing the staged lines in the synchronous mode, within 100 ms and on
+ * every start. Keeps log I/O off the CPUs of the time critical threads.
+ * A lower nice value than the current one needs CAP_SYS_NICE.
+ */
+bool APPLOG_SetWriterThread(const struct APPLOG_THREAD_S* const p_thread);
+
+/**
+ * @brief Get the queue and flush figures of the log writer thread
+ * @param[out] p_stats the figures, all zero in the synchronous mode
+ * @details
+ * A max_depth close to capacity means records had to wait or were dropped,
+ * refer to APPLOG_GetCounters. APPLOG_Breakdown prints them.
+ */
+void APPLOG_GetWriterStats(struct APPLOG_WRITER_STATS_S* const p_stats);
+
+/**
+ * @brief Get the record counts of the backpressure policy
+ * @param[out] p_counters the counts since APPLOG_Init
+ * @details
+ * APPLOG_Breakdown prints them when not all zero.
+ */
+void APPLOG_GetCounters(struct APPLOG_COUNTERS_S* const p_counters);
+
+/**
+ * @brief Set the rate limit of every log statement
+ * @param[in] per_second the average number of messages per second, 0 for
+ * no limit
+ * @param[in] burst the number of messages allowed at once
+ * @details
+ * Changes apply at once, also to statements which are being throttled.
+ * There is no limit until the first call. ERROR and CRITICAL messages are
+ * never dropped.
+ */
+void APPLOG_SetRateLimit(const uint32_t per_second, const uint32_t burst);
+
+/**
+ * @brief Count identical messages of a log statement instead of printing
+ * them
+ * @param[in] collapse true to collapse, false (the default) to print every
+ * message
+ * @details
+ * A message equal to the last one of its statement, arguments included,
+ * within a second of its last print is held back; the "last message
+ * repeated N times" line follows with the next different message of the
+ * statement, or a second later from the flusher thread, after which the
+ * message is printed again. Comparing captures and hashes the arguments
+ * of every message printed; without collapsing that cost is not paid.
+ * Switching it off prints the lines still held back.
+ */
+void APPLOG_SetRepeatCollapse(const bool collapse);
+
+/**
+ * @brief Keep the most recent records in memory and dump them on a crash
+ * @param[in] filename the dump file, created now and removed by
+ * APPLOG_Breakdown if no crash happened
+ * @param[in] records the number of records kept (rounded up to a power of
+ * two)
+ * @pre[tested] the component must be initialized
+ * @return true if the flight recorder runs, false otherwise.
+ * @details
+ * Every record is kept, also the ones filtered out by the log level and
+ * debug bits (as far as compiled in, refer to APPLOG_BUILD_LEVELS), so
+ * DEBUG detail is available after a crash without printing it. On SIGSEGV,
+ * SIGBUS or SIGABRT the records are written to the dump file, after which
+ * the signal takes its former course.
+ * While it runs, the filters let every statement through to render its
+ * record: a filtered out statement costs a formatted line instead of a
+ * load. Start it to chase a crash, not by default.
+ */
+bool APPLOG_StartFlightRecorder(const char* const filename, const uint32_t records);
+
+/**
+ * @brief Render a deferred record into a text line
+ * @param[out] buf the text buffer
+ * @param[in] size the size of buf
+ * @param[in] p_rec the record
+ * @pre[untested] size must be large enough for the time reference (> 64)
+ * @return the length of the line, '\n' included
+ * @details
+ * The line is identical to the one printed by APPLOG_Log/APPLOG_LogDebug.
+ */
+size_t APPLOG_RenderRecord(
+		char* const buf,
+		const size_t size,
+		const struct LOGFMT_RECORD_S* const p_rec);
+
 /**
  * @brief Destroy the log component.
  * @return true if the breakdown was successful, false otherwise.
  */
 bool APPLOG_Breakdown(void);
 
+/**
+ * @brief Reload the log settings of a configuration file on SIGUSR1
+ * @param[in] filename the configuration file, refer to APPLOG_LoadConfig
+ * @pre[tested] the component must be initialized
+ * @return true if a reload thread watches for SIGUSR1, false otherwise.
+ * @details
+ * The signal handler only wakes up a thread, which applies the file with
+ * APPLOG_LoadConfig: log level, debug bits, rate limit and log file change
+ * without restarting the process nor blocking the logging threads.
+ */
+bool APPLOG_WatchConfig(const char* const filename);
+
 /**
  * @brief Set log flags
  * @param[in] bits the set of bits to activate
+ * @details
+ * Thread-safe. Logging threads see the change without taking a lock.
  */
 void APPLOG_SetLogBits(const uint64_t bits);
 
 /**
  * @brief Reset log flags
  * @param[in] bits the set of bits to in-activate
+ * @details
+ * Thread-safe. Logging threads see the change without taking a lock.
  */
 void APPLOG_ResetLogBits(const uint64_t bits);
 
@@ -56,9 +320,59 @@ void APPLOG_ResetLogBits(const uint64_t bits);
  * @param[in] level_bits
  * @pre[tested] level_bits must use bit values > LOGLV_UNDEFINED
  * and < LOGLV_SENTINEL
+ * @details
+ * Thread-safe. Logging threads see the change without taking a lock.
  */
 void APPLOG_SetLogLevel(const uint64_t level_bits);
 
+/**
+ * @brief Switch log statements on or off
+ * @param[in] file the source file of the statements, or its end (e.g.
+ * "timers.c")
+ * @param[in] line the source line of the statement, 0 for every statement
+ * of the file
+ * @param[in] on true to let the statements log at their level, false to
+ * silence them
+ * @return the number of statements matched
+ * @details
+ * Thread-safe. Logging threads see the change without taking a lock.
+ */
+unsigned APPLOG_SetSiteEnabled(const char* const file, const int line, const bool on);
+
+/**
+ * @brief Log the statements called most often, with their call counts
+ * @param[in] count the number of statements listed
+ * @details
+ * Only the calls of enabled statements are counted.
+ */
+void APPLOG_ReportHotSites(const unsigned count);
+
+/**
+ * @brief APPLOG_LogDebug through the rate limiter of a callsite
+ * @param[in, out] p_site the callsite, refer to APPLOG_LogDebug
+ * @param[in] fn the function name
+ * @param[in] bits the debug bit(s) to use
+ * @param[in] fmt, ... the variable arguments list (printf-like)
+ */
+void APPLOG_SiteLogDebug(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t bits,
+		char* fmt, ...);
+
+/**
+ * @brief APPLOG_Log through the rate limiter of a callsite
+ * @param[in, out] p_site the callsite, refer to APPLOG_Log
+ * @param[in] fn the function name
+ * @param[in] level the log level to use - refer to APPLOG_LEVELS_E
+ * @param[in] fmt, ... the variable arguments list (printf-like)
+ */
+void APPLOG_SiteLog(
+		struct APPLOG_SITE_S* const p_site,
+		const char* fn,
+		const uint64_t level,
+		char* fmt, ...);
+
 /**
  * @brief Print to console conditionally with time reference and
  * log level indications
@@ -96,5 +410,53 @@ void APPLOG_Log(
  * exported variables declaration section
  * ----------------------------------------------------------------------*/
 
+/* ----------------------------------------------------------------------
+ * macro declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Rate limited APPLOG_Log, one descriptor and limiter per statement
+ * @details
+ * A statement whose level is outside APPLOG_BUILD_LEVELS compiles to
+ * nothing, descriptor included. A statement whose level is filtered out or
+ * which is switched off (refer to APPLOG_SetSiteEnabled) costs one load of
+ * its descriptor.
+ * With a rate limit, every statement allows LOG_RATE_BURST messages at
+ * once and LOG_RATE_LIMIT messages per second on average, ERROR and
+ * CRITICAL ones excepted (refer to APPLOG_LoadConfig). The number of
+ * dropped messages is printed with the next message let through and at
+ * APPLOG_Breakdown. With collapsing (refer to APPLOG_SetRepeatCollapse)
+ * consecutive identical messages of a statement are counted instead of
+ * printed. (APPLOG_Log)(...) calls the function without limiter.
+ */
+#define APPLOG_Log(fn, level, ...) do {                                       \
+	if (APPLOG_BUILD_KEEPS_LEVEL(level)) {                                     \
+		static struct APPLOG_SITE_S APPLOG_site APPLOG_SITE_SECTION =          \
+				APPLOG_SITE_INIT(level, 0, APPLOG_SITE_FMT(__VA_ARGS__, 0));   \
+		if (atomic_load_explicit(&APPLOG_site.enabled, memory_order_relaxed)) { \
+			APPLOG_SiteLog(&APPLOG_site, fn, level, __VA_ARGS__);              \
+		}                                                                      \
+	}                                                                          \
+} while (0)
+
+/**
+ * @brief Rate limited APPLOG_LogDebug, one descriptor and limiter per
+ * statement
+ * @details
+ * Refer to APPLOG_Log. A statement compiles to nothing if LOGLV_DEBUG is
+ * outside APPLOG_BUILD_LEVELS or its bits are outside
+ * APPLOG_BUILD_DEBUG_BITS. (APPLOG_LogDebug)(...) calls the function
+ * without limiter.
+ */
+#define APPLOG_LogDebug(fn, bits, ...) do {                                   \
+	if (APPLOG_BUILD_KEEPS_BITS(bits)) {                                       \
+		static struct APPLOG_SITE_S APPLOG_site APPLOG_SITE_SECTION =          \
+				APPLOG_SITE_INIT(LOGLV_DEBUG, bits, APPLOG_SITE_FMT(__VA_ARGS__, 0)); \
+		if (atomic_load_explicit(&APPLOG_site.enabled, memory_order_relaxed)) { \
+			APPLOG_SiteLogDebug(&APPLOG_site, fn, bits, __VA_ARGS__);          \
+		}                                                                      \
+	}                                                                          \
+} while (0)
+
 #endif /* if !defined(LOG_H_INCLUDE)*/
 
@@ -13,6 +13,8 @@
  * include section
  * ----------------------------------------------------------------------*/
 /* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* project specific includes - if possible alphabetically ordered */
@@ -49,6 +51,26 @@
 #define LOGBIT_OCSRV     (0x0400L) /**< OCIT-C Server */
 #define LOGBIT_SENTINEL  (0x0800L) /**< DO NOT USE */
 
+/**
+ * @brief The log levels compiled in, set per build type by the Makefile
+ * @details
+ * APPLOG_Log statements using other levels compile away (refer to
+ * APPLOG_BUILD_KEEPS_LEVEL).
+ */
+#if !defined(APPLOG_BUILD_LEVELS)
+#define APPLOG_BUILD_LEVELS (LOGLV_SENTINEL - 1)
+#endif
+
+/**
+ * @brief The debug bits compiled in, set per build type by the Makefile
+ * @details
+ * APPLOG_LogDebug statements using other bits compile away (refer to
+ * APPLOG_BUILD_KEEPS_BITS).
+ */
+#if !defined(APPLOG_BUILD_DEBUG_BITS)
+#define APPLOG_BUILD_DEBUG_BITS (LOGBIT_SENTINEL - 1)
+#endif
+
 /**
  * @brief Print to console with time reference and log level indications
  * if conditions are fulfilled
@@ -67,9 +89,176 @@
 	}                                              \
 }
 
+/**
+ * @brief True if APPLOG_Log statements of a level are compiled in
+ * @param[in] level the level of the statement
+ * @details
+ * Levels of APPLOG_BUILD_LEVELS are, and the undefined and illegal ones,
+ * which always log.
+ */
+#define APPLOG_BUILD_KEEPS_LEVEL(level) ((0 != ((level) & APPLOG_BUILD_LEVELS)) \
+		|| (LOGLV_UNDEFINED == (level)) || (LOGLV_SENTINEL <= (level)))
+
+/**
+ * @brief True if APPLOG_LogDebug statements of debug bits are compiled in
+ * @param[in] bits the debug bits of the statement
+ */
+#define APPLOG_BUILD_KEEPS_BITS(bits) ((0 != (LOGLV_DEBUG & APPLOG_BUILD_LEVELS)) \
+		&& (0 != ((bits) & APPLOG_BUILD_DEBUG_BITS)))
+
+/**
+ * @brief Placement of the callsite descriptors
+ * @details
+ * All descriptors land in one ELF section, which the linker brackets with
+ * __start_applog_sites and __stop_applog_sites. The alignment is fixed (no
+ * padding added by the compiler), so the section is an array. They are
+ * not marked used: the descriptor of a statement compiled away goes with
+ * it.
+ */
+#define APPLOG_SITE_SECTION __attribute__((section("applog_sites"), aligned(8)))
+
+/**
+ * @brief The format of a log statement: the first of its variable arguments
+ */
+#define APPLOG_SITE_FMT(fmt, ...) (fmt)
+
+/**
+ * @brief Initializer of a struct APPLOG_SITE_S for the current source line
+ * @param[in] level the level of the statement
+ * @param[in] bits the debug bits of the statement, 0 for APPLOG_Log
+ * @param[in] format the format of the statement
+ * @details
+ * What isn't a constant is left to the filters of the call.
+ */
+#define APPLOG_SITE_INIT(level, bits, format) {                                \
+	.file = __FILE__,                                                          \
+	.line = __LINE__,                                                          \
+	.func = __func__,                                                          \
+	.fmt = __builtin_constant_p(format) ? (format) : NULL,                     \
+	.site_level = __builtin_constant_p(level) ? (level) : LOGLV_UNDEFINED,     \
+	.site_bits = __builtin_constant_p(bits) ? (bits) : (LOGBIT_SENTINEL - 1),  \
+	.enabled = true                                                            \
+}
+
 /* ----------------------------------------------------------------------
  * type declaration section
  * ----------------------------------------------------------------------*/
 
+/**
+ * @brief The descriptor and rate limiter of one log statement (callsite)
+ * @details
+ * One static instance per log statement, created by the APPLOG_Log and
+ * APPLOG_LogDebug macros in the APPLOG_SITE_SECTION. enabled folds the
+ * level and debug bits of the statement, the current filters and the
+ * switch of the statement (APPLOG_SetSiteEnabled); a disabled statement
+ * costs one load. The token bucket is kept as the theoretical arrival time
+ * of the next message (GCRA), so admitting a message is one load and one
+ * compare-and-swap. With collapsing (APPLOG_SetRepeatCollapse) a message
+ * is identified by a hash of its arguments; copies of the last one are
+ * counted instead of printed for a while. Callsites which
+ * ever dropped or held back a message are linked in a list for the
+ * reports of the flusher thread and APPLOG_Breakdown.
+ */
+struct APPLOG_SITE_S {
+	const char* file;                /**< Source file of the statement */
+	int line;                        /**< Source line of the statement */
+	const char* func;                /**< Function of the statement */
+	const char* fmt;                 /**< Format of the statement, NULL if not a constant */
+	uint64_t site_level;             /**< Level of the statement, LOGLV_UNDEFINED if not a constant */
+	uint64_t site_bits;              /**< Debug bits of an APPLOG_LogDebug statement, 0 otherwise */
+	atomic_bool enabled;             /**< The statement may log */
+	bool switched_off;               /**< Silenced by APPLOG_SetSiteEnabled */
+	atomic_uint_fast64_t hits;       /**< Calls of the statement while enabled */
+	_Atomic int64_t tat;             /**< Theoretical arrival time (ns) of the next message */
+	atomic_uint suppressed;          /**< Messages dropped since the last one let through */
+	_Atomic uint64_t last_hash;      /**< Hash of the last message, 0 if none */
+	atomic_uint repeats;             /**< Copies of the last message held back */
+	_Atomic int64_t repeat_since;    /**< When the first held back copy arrived (ns) */
+	_Atomic int64_t last_at;         /**< When the last message was printed (ns), with collapsing */
+	atomic_bool listed;              /**< True once linked in the site list */
+	const char* fn;                  /**< Function name of the first dropped message */
+	uint64_t level;                  /**< Level of the first dropped message */
+	uint16_t flags;                  /**< LOGFMT_FLAG_xxx of the first dropped message */
+	struct APPLOG_SITE_S* p_next;    /**< Next listed site */
+};
+
+/**
+ * @brief The ways a log record can travel to the console
+ */
+enum APPLOG_MODE_E {
+	APPLOG_MODE_SYNC = 0, /**< format on the caller's thread, print in batches of its staged lines (default) */
+	APPLOG_MODE_ASYNC,    /**< format on the caller's thread, print on the writer thread */
+	APPLOG_MODE_DEFERRED, /**< capture raw arguments on the caller's thread, format on the writer thread */
+	APPLOG_MODE_SENTINEL  /**< DO NOT USE */
+};
+
+/**
+ * @brief What a log call does when the output can't keep up
+ * @details
+ * The queue is the ring in the asynchronous modes and the staging buffer
+ * of the calling thread in the synchronous mode; the policy applies when it
+ * is full and the output is busy. ERROR and CRITICAL records are only
+ * dropped by APPLOG_BACKPRESSURE_OVERWRITE_OLDEST, the other policies make
+ * them wait.
+ */
+enum APPLOG_BACKPRESSURE_E {
+	APPLOG_BACKPRESSURE_BLOCK = 0,        /**< wait for the output */
+	APPLOG_BACKPRESSURE_TIMED,            /**< wait up to a timeout, then drop the new record */
+	APPLOG_BACKPRESSURE_DROP_NEWEST,      /**< drop the new record at once (default) */
+	APPLOG_BACKPRESSURE_OVERWRITE_OLDEST, /**< drop the oldest queued record(s) to make room */
+	APPLOG_BACKPRESSURE_SENTINEL          /**< DO NOT USE */
+};
+
+/**
+ * @brief The log outputs; each takes the lines of its own levels
+ */
+enum APPLOG_SINK_E {
+	APPLOG_SINK_CONSOLE = 0, /**< the standard output */
+	APPLOG_SINK_FILE,        /**< the memory-mapped log file, refer to APPLOG_SetLogFile */
+	APPLOG_SINK_SOCKET,      /**< a syslog-style UNIX datagram socket, refer to APPLOG_SetLogSocket */
+	APPLOG_SINK_MEMORY,      /**< the most recent lines in memory, refer to APPLOG_SetMemorySink */
+	APPLOG_SINK_SENTINEL     /**< DO NOT USE */
+};
+
+/**
+ * @brief The scheduling policies of the log writer thread
+ */
+enum APPLOG_SCHED_E {
+	APPLOG_SCHED_OTHER = 0, /**< SCHED_OTHER, the time-sharing default */
+	APPLOG_SCHED_IDLE,      /**< SCHED_IDLE, runs only when a CPU has nothing else to do */
+	APPLOG_SCHED_SENTINEL   /**< DO NOT USE */
+};
+
+/**
+ * @brief Where and how the log writer thread runs
+ */
+struct APPLOG_THREAD_S {
+	uint64_t cpus;                /**< CPU bits (bit n for CPU n), 0 for any */
+	enum APPLOG_SCHED_E policy;   /**< The scheduling policy */
+	int nice;                     /**< The nice value, -20 .. 19 */
+};
+
+/**
+ * @brief Queue and flush figures of the log writer thread since it started
+ */
+struct APPLOG_WRITER_STATS_S {
+	uint32_t capacity;        /**< Record slots of the ring */
+	uint32_t depth;           /**< Records queued at the start of the last flush */
+	uint32_t max_depth;       /**< Most records queued at the start of a flush */
+	uint64_t flushes;         /**< Flushes writing at least one record */
+	uint64_t last_flush_ns;   /**< Duration of the last flush */
+	uint64_t max_flush_ns;    /**< Duration of the longest flush */
+	uint64_t total_flush_ns;  /**< Duration of all flushes */
+};
+
+/**
+ * @brief Exact record counts of the backpressure policy since APPLOG_Init
+ */
+struct APPLOG_COUNTERS_S {
+	uint64_t dropped;      /**< New records dropped (full queue, timeout) */
+	uint64_t overwritten;  /**< Queued records dropped to make room */
+	uint64_t delayed;      /**< Records that had to wait for the output */
+};
+
 #endif /* if !defined(LOG_T_H_INCLUDE) */
 
@@ -0,0 +1,561 @@
+/**
+ * @file logfile.c
+ * @brief implementation of the memory-mapped log file
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * Every segment is allocated at its full size and mapped, so appending a
+ * line is a memcpy. The kernel is asked to write back every sync_bytes
+ * (msync, MS_ASYNC). A closed segment is cut to its used length and
+ * renamed path.1, older ones shift up to path.max_segments; the oldest is
+ * overwritten, which caps the disk usage at (max_segments + 1) segments.
+ * With compression, a closed segment is renamed path.raw<n> and handed to
+ * the compressor thread, which writes path.1.lz and shifts the older .lz
+ * segments; the thread that rotates only pays for the rename.
+ * The index of a segment is mapped the same way, sized for the most marks
+ * the segment can have (a sparse file); closing the segment seals it (the
+ * floors of the marks) and cuts it to its used length.
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+#include "logtime.h"
+#include "logz.h"
+
+/* component include */
+#include "logfile.h"
+
+/* ----------------------------------------------------------------------
+ * internal macro declaration section
+ * ----------------------------------------------------------------------*/
+
+/** Size of a segment file name: the path and a suffix */
+#define LOGFILE_NAME_SIZE (LOGFILE_PATH_SIZE + 24)
+
+/** Suffix of the compressed segments */
+#define LOGFILE_PACKED_SUFFIX ".lz"
+
+/* ----------------------------------------------------------------------
+ * internal type declaration section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * function with internal linkage (static) declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Create, allocate and map a new active segment
+ * @param[in, out] p_file the log file
+ * @return true on success, false otherwise
+ */
+static bool LOGFILE_StartSegment(struct LOGFILE_S* const p_file);
+
+/**
+ * @brief Write back, unmap and cut the active segment
+ * @param[in, out] p_file the log file
+ */
+static void LOGFILE_EndSegment(struct LOGFILE_S* const p_file);
+
+/**
+ * @brief Create and map the index of the active segment
+ * @param[in, out] p_file the log file
+ * @details
+ * Without index_lines, an index left at the path is removed. The segment
+ * goes on without an index if it can't be created.
+ */
+static void LOGFILE_StartIndex(struct LOGFILE_S* const p_file);
+
+/**
+ * @brief Seal, unmap and cut the index of the active segment
+ * @param[in, out] p_file the log file
+ */
+static void LOGFILE_EndIndex(struct LOGFILE_S* const p_file);
+
+/**
+ * @brief Shift the rotated segments and rename a file to the first one
+ * @param[in] p_config the settings
+ * @param[in] from the file becoming path.1<suffix>, removed if no
+ * segments are kept
+ * @param[in] suffix the suffix of the rotated segments
+ */
+static void LOGFILE_ShiftSegments(const struct LOGFILE_CONFIG_S* const p_config, const char* const from, const char* const suffix);
+
+/**
+ * @brief Hand the closed active segment over to the rotated ones
+ * @param[in, out] p_file the log file
+ */
+static void LOGFILE_Retire(struct LOGFILE_S* const p_file);
+
+/**
+ * @brief Start the compressor thread of a log file
+ * @param[in, out] p_file the log file
+ * @return true on success, false otherwise
+ */
+static bool LOGFILE_StartPacker(struct LOGFILE_S* const p_file);
+
+/**
+ * @brief Compress the queued segments and stop the compressor thread
+ * @param[in, out] p_file the log file
+ */
+static void LOGFILE_StopPacker(struct LOGFILE_S* const p_file);
+
+/**
+ * @brief Compressor thread: compress the queued segments until stopped
+ * @param[in] p_arg the struct LOGFILE_PACKER_S
+ * @return NULL
+ */
+static void* LOGFILE_Pack(void* p_arg);
+
+/**
+ * @brief Compress one queued segment into path.1.lz
+ * @param[in, out] p_packer the compressor
+ * @param[in] job the number of the segment
+ * @param[in] skip true to drop it, it would be shifted out at once
+ */
+static void LOGFILE_PackSegment(struct LOGFILE_PACKER_S* const p_packer, const uint32_t job, const bool skip);
+
+/* ----------------------------------------------------------------------
+ * variable with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported variable definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported function definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+bool LOGFILE_Open(struct LOGFILE_S* const p_file, const struct LOGFILE_CONFIG_S* const p_config)
+{
+	static const char* fn = "LOGFILE_Open";
+	struct stat st;
+	bool rv = false;
+
+	memset(p_file, 0, sizeof(*p_file));
+	p_file->fd = -1;
+	p_file->index_fd = -1;
+
+	if ('\0' == p_config->path[0]) {
+		printf("%s: [ERROR] Empty log file path\n", fn);
+	} else if (0 == p_config->segment_size) {
+		printf("%s: [ERROR] Log file segment size is 0\n", fn);
+	} else {
+		p_file->config = *p_config;
+
+		if (p_config->compress && !LOGFILE_StartPacker(p_file)) {
+			printf("%s: [ERROR] Couldn't start the compressor, rotated segments stay uncompressed\n", fn);
+		}
+		if ((0 == stat(p_file->config.path, &st)) && (0 < st.st_size)) {
+			LOGFILE_Retire(p_file);
+		}
+		rv = LOGFILE_StartSegment(p_file);
+		if (!rv) {
+			LOGFILE_StopPacker(p_file);
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+bool LOGFILE_Append(struct LOGFILE_S* const p_file, const void* const data, size_t len)
+{
+	bool rv = true;
+
+	if (len > p_file->config.segment_size) {
+		len = p_file->config.segment_size;
+	}
+
+	if (NULL == p_file->p_map) {
+		/* a previous segment couldn't be started: retry without shifting */
+		rv = LOGFILE_StartSegment(p_file);
+	} else if ((p_file->offset + len > p_file->config.segment_size)
+			|| ((0 != p_file->config.rotate_seconds)
+				&& (time(NULL) - p_file->opened >= (time_t)p_file->config.rotate_seconds))) {
+		rv = LOGFILE_Rotate(p_file);
+	}
+
+	if (rv) {
+		memcpy(p_file->p_map + p_file->offset, data, len);
+		p_file->offset += len;
+
+		if (p_file->offset - p_file->synced >= p_file->config.sync_bytes) {
+			LOGFILE_Flush(p_file);
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGFILE_IndexLine(struct LOGFILE_S* const p_file, const size_t offset, const char* const line, const size_t len, const uint64_t level)
+{
+	struct LOGFILE_INDEX_S* p_index = p_file->p_index;
+	struct LOGFILE_MARK_S* p_mark;
+	int64_t ms;
+
+	/* a line cut by LOGFILE_Append may lie beyond the segment */
+	if ((NULL != p_index) && (offset < p_file->config.segment_size)) {
+		if (0 == p_file->mark_lines) {
+			p_mark = (struct LOGFILE_MARK_S*)(p_index + 1) + p_index->count;
+			p_mark->offset = offset;
+			p_mark->min_ms = INT64_MAX;
+			p_mark->max_ms = (0 == p_index->count) ? INT64_MIN : p_mark[-1].max_ms;
+			p_mark->floor_ms = INT64_MAX;
+			p_mark->levels = 0;
+			p_index->count++;
+		} else {
+			p_mark = (struct LOGFILE_MARK_S*)(p_index + 1) + p_index->count - 1;
+		}
+
+		if (0 < LOGTIME_Parse(line, len, &ms)) {
+			if (ms < p_mark->min_ms) {
+				p_mark->min_ms = ms;
+				p_mark->floor_ms = ms;
+			}
+			if (ms > p_mark->max_ms) {
+				p_mark->max_ms = ms;
+			}
+		}
+		p_mark->levels |= level;
+
+		if (++p_file->mark_lines == p_index->lines) {
+			p_file->mark_lines = 0;
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGFILE_Flush(struct LOGFILE_S* const p_file)
+{
+	size_t page_mask = (size_t)sysconf(_SC_PAGESIZE) - 1;
+	size_t start;
+
+	if ((NULL != p_file->p_map) && (p_file->offset > p_file->synced)) {
+		start = p_file->synced & ~page_mask;
+		msync(p_file->p_map + start, p_file->offset - start, MS_ASYNC);
+		p_file->synced = p_file->offset;
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+bool LOGFILE_Rotate(struct LOGFILE_S* const p_file)
+{
+	LOGFILE_EndSegment(p_file);
+	LOGFILE_Retire(p_file);
+	return LOGFILE_StartSegment(p_file);
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGFILE_Close(struct LOGFILE_S* const p_file)
+{
+	LOGFILE_EndSegment(p_file);
+	LOGFILE_StopPacker(p_file);
+}
+
+/* ----------------------------------------------------------------------
+ * functions with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+static bool LOGFILE_StartSegment(struct LOGFILE_S* const p_file)
+{
+	static const char* fn = "LOGFILE_StartSegment";
+	const char* path = p_file->config.path;
+	size_t size = p_file->config.segment_size;
+	void* p_map;
+	int alloc_res;
+	bool rv = false;
+
+	p_file->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+	if (0 > p_file->fd) {
+		printf("%s: [ERROR] Couldn't open %s:%s\n", fn, path, strerror(errno));
+	} else {
+		/* reserve the blocks up-front: a full disk must not SIGBUS a memcpy */
+		alloc_res = posix_fallocate(p_file->fd, 0, size);
+		if ((0 != alloc_res) && (0 > ftruncate(p_file->fd, size))) {
+			printf("%s: [ERROR] Couldn't size %s:%s\n", fn, path, strerror(errno));
+		} else if (MAP_FAILED == (p_map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, p_file->fd, 0))) {
+			printf("%s: [ERROR] Couldn't map %s:%s\n", fn, path, strerror(errno));
+		} else {
+			p_file->p_map = p_map;
+			p_file->offset = 0;
+			p_file->synced = 0;
+			p_file->opened = time(NULL);
+			LOGFILE_StartIndex(p_file);
+			rv = true;
+		}
+
+		if (!rv) {
+			close(p_file->fd);
+			p_file->fd = -1;
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGFILE_EndSegment(struct LOGFILE_S* const p_file)
+{
+	if (NULL != p_file->p_map) {
+		msync(p_file->p_map, p_file->offset, MS_SYNC);
+		munmap(p_file->p_map, p_file->config.segment_size);
+		p_file->p_map = NULL;
+	}
+	if (0 <= p_file->fd) {
+		if (0 > ftruncate(p_file->fd, p_file->offset)) {
+			printf("LOGFILE_EndSegment: [ERROR] Couldn't cut %s:%s\n", p_file->config.path, strerror(errno));
+		}
+		close(p_file->fd);
+		p_file->fd = -1;
+	}
+	LOGFILE_EndIndex(p_file);
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGFILE_StartIndex(struct LOGFILE_S* const p_file)
+{
+	static const char* fn = "LOGFILE_StartIndex";
+	const struct LOGFILE_CONFIG_S* p_config = &p_file->config;
+	char name[LOGFILE_NAME_SIZE];
+	void* p_map;
+
+	snprintf(name, sizeof(name), "%s%s", p_config->path, LOGFILE_INDEX_SUFFIX);
+
+	if (0 == p_config->index_lines) {
+		unlink(name);
+	} else if (0 > (p_file->index_fd = open(name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))) {
+		printf("%s: [ERROR] Couldn't open %s:%s\n", fn, name, strerror(errno));
+	} else {
+		/* a line takes at least a byte: room for the most marks of a segment */
+		p_file->index_size = sizeof(struct LOGFILE_INDEX_S)
+				+ (p_config->segment_size / p_config->index_lines + 1) * sizeof(struct LOGFILE_MARK_S);
+
+		if (0 > ftruncate(p_file->index_fd, p_file->index_size)) {
+			printf("%s: [ERROR] Couldn't size %s:%s\n", fn, name, strerror(errno));
+		} else if (MAP_FAILED == (p_map = mmap(NULL, p_file->index_size, PROT_READ | PROT_WRITE, MAP_SHARED, p_file->index_fd, 0))) {
+			printf("%s: [ERROR] Couldn't map %s:%s\n", fn, name, strerror(errno));
+		} else {
+			p_file->p_index = p_map;
+			memcpy(p_file->p_index->magic, LOGFILE_INDEX_MAGIC, sizeof(p_file->p_index->magic));
+			p_file->p_index->lines = p_config->index_lines;
+			p_file->p_index->count = 0;
+			p_file->p_index->sealed = 0;
+			p_file->mark_lines = 0;
+		}
+
+		if (NULL == p_file->p_index) {
+			close(p_file->index_fd);
+			p_file->index_fd = -1;
+			unlink(name);
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGFILE_EndIndex(struct LOGFILE_S* const p_file)
+{
+	struct LOGFILE_INDEX_S* p_index = p_file->p_index;
+	struct LOGFILE_MARK_S* p_marks;
+	int64_t floor_ms = INT64_MAX;
+	size_t used = 0;
+	uint32_t i;
+
+	if (NULL != p_index) {
+		p_marks = (struct LOGFILE_MARK_S*)(p_index + 1);
+
+		for (i = p_index->count; i > 0; i--) {
+			if (p_marks[i - 1].min_ms < floor_ms) {
+				floor_ms = p_marks[i - 1].min_ms;
+			}
+			p_marks[i - 1].floor_ms = floor_ms;
+		}
+		p_index->sealed = 1;
+		used = sizeof(*p_index) + p_index->count * sizeof(*p_marks);
+
+		msync(p_index, used, MS_SYNC);
+		munmap(p_index, p_file->index_size);
+		p_file->p_index = NULL;
+	}
+	if (0 <= p_file->index_fd) {
+		if (0 > ftruncate(p_file->index_fd, used)) {
+			printf("LOGFILE_EndIndex: [ERROR] Couldn't cut the index of %s:%s\n", p_file->config.path, strerror(errno));
+		}
+		close(p_file->index_fd);
+		p_file->index_fd = -1;
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGFILE_ShiftSegments(const struct LOGFILE_CONFIG_S* const p_config, const char* const from, const char* const suffix)
+{
+	char older[LOGFILE_NAME_SIZE];
+	char to[LOGFILE_NAME_SIZE];
+	uint32_t i;
+
+	if (0 == p_config->max_segments) {
+		unlink(from);
+	} else {
+		for (i = p_config->max_segments - 1; i > 0; i--) {
+			snprintf(older, sizeof(older), "%s.%u%s", p_config->path, i, suffix);
+			snprintf(to, sizeof(to), "%s.%u%s", p_config->path, i + 1, suffix);
+			rename(older, to);
+		}
+		snprintf(to, sizeof(to), "%s.1%s", p_config->path, suffix);
+		rename(from, to);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGFILE_Retire(struct LOGFILE_S* const p_file)
+{
+	struct LOGFILE_PACKER_S* p_packer = p_file->p_packer;
+	char raw[LOGFILE_NAME_SIZE];
+	char index[LOGFILE_NAME_SIZE];
+	char raw_index[LOGFILE_NAME_SIZE];
+
+	/* the indexes shift along, a segment without one leaves a gap */
+	snprintf(index, sizeof(index), "%s%s", p_file->config.path, LOGFILE_INDEX_SUFFIX);
+
+	if (NULL == p_packer) {
+		LOGFILE_ShiftSegments(&p_file->config, p_file->config.path, "");
+		LOGFILE_ShiftSegments(&p_file->config, index, LOGFILE_INDEX_SUFFIX);
+	} else {
+		/* only this thread queues: queued is stable outside the lock */
+		snprintf(raw, sizeof(raw), "%s.raw%u", p_file->config.path, p_packer->queued);
+
+		if (0 > rename(p_file->config.path, raw)) {
+			printf("LOGFILE_Retire: [ERROR] Couldn't rename %s:%s\n", p_file->config.path, strerror(errno));
+		} else {
+			snprintf(raw_index, sizeof(raw_index), "%s.raw%u%s", p_file->config.path, p_packer->queued, LOGFILE_INDEX_SUFFIX);
+			if (0 > rename(index, raw_index)) {
+				unlink(raw_index);
+			}
+			pthread_mutex_lock(&p_packer->mutex);
+			p_packer->queued++;
+			pthread_cond_signal(&p_packer->wakeup);
+			pthread_mutex_unlock(&p_packer->mutex);
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static bool LOGFILE_StartPacker(struct LOGFILE_S* const p_file)
+{
+	struct LOGFILE_PACKER_S* p_packer;
+	bool rv = false;
+
+	if (NULL != (p_packer = calloc(1, sizeof(*p_packer)))) {
+		p_packer->config = p_file->config;
+		pthread_mutex_init(&p_packer->mutex, NULL);
+		pthread_cond_init(&p_packer->wakeup, NULL);
+
+		if (!LOGZ_Create(&p_packer->z)) {
+			printf("LOGFILE_StartPacker: [ERROR] Couldn't allocate the compressor\n");
+		} else if (0 != pthread_create(&p_packer->thread, NULL, LOGFILE_Pack, p_packer)) {
+			printf("LOGFILE_StartPacker: [ERROR] Couldn't create the compressor thread\n");
+			LOGZ_Destroy(&p_packer->z);
+		} else {
+			pthread_setname_np(p_packer->thread, "applog-lz");
+			p_file->p_packer = p_packer;
+			rv = true;
+		}
+
+		if (!rv) {
+			pthread_cond_destroy(&p_packer->wakeup);
+			pthread_mutex_destroy(&p_packer->mutex);
+			free(p_packer);
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGFILE_StopPacker(struct LOGFILE_S* const p_file)
+{
+	struct LOGFILE_PACKER_S* p_packer = p_file->p_packer;
+
+	if (NULL != p_packer) {
+		pthread_mutex_lock(&p_packer->mutex);
+		p_packer->stop = true;
+		pthread_cond_signal(&p_packer->wakeup);
+		pthread_mutex_unlock(&p_packer->mutex);
+		pthread_join(p_packer->thread, NULL);
+
+		LOGZ_Destroy(&p_packer->z);
+		pthread_cond_destroy(&p_packer->wakeup);
+		pthread_mutex_destroy(&p_packer->mutex);
+		free(p_packer);
+		p_file->p_packer = NULL;
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void* LOGFILE_Pack(void* p_arg)
+{
+	struct LOGFILE_PACKER_S* p_packer = p_arg;
+	uint32_t job;
+	bool skip;
+
+	pthread_mutex_lock(&p_packer->mutex);
+
+	while (!p_packer->stop || (p_packer->done != p_packer->queued)) {
+		if (p_packer->done == p_packer->queued) {
+			pthread_cond_wait(&p_packer->wakeup, &p_packer->mutex);
+		} else {
+			job = p_packer->done;
+			/* behind by more than the kept segments: this one would be shifted out */
+			skip = (p_packer->queued - job > p_packer->config.max_segments);
+			pthread_mutex_unlock(&p_packer->mutex);
+
+			LOGFILE_PackSegment(p_packer, job, skip);
+
+			pthread_mutex_lock(&p_packer->mutex);
+			p_packer->done++;
+		}
+	}
+
+	pthread_mutex_unlock(&p_packer->mutex);
+	return NULL;
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGFILE_PackSegment(struct LOGFILE_PACKER_S* const p_packer, const uint32_t job, const bool skip)
+{
+	const struct LOGFILE_CONFIG_S* p_config = &p_packer->config;
+	char raw[LOGFILE_NAME_SIZE];
+	char raw_index[LOGFILE_NAME_SIZE];
+	char packed[LOGFILE_NAME_SIZE];
+
+	snprintf(raw, sizeof(raw), "%s.raw%u", p_config->path, job);
+	snprintf(raw_index, sizeof(raw_index), "%s.raw%u%s", p_config->path, job, LOGFILE_INDEX_SUFFIX);
+	snprintf(packed, sizeof(packed), "%s%s.tmp", p_config->path, LOGFILE_PACKED_SUFFIX);
+
+	if (skip || (0 == p_config->max_segments)) {
+		unlink(raw);
+		unlink(raw_index);
+	} else if (LOGZ_CompressFile(&p_packer->z, raw, packed)) {
+		LOGFILE_ShiftSegments(p_config, packed, LOGFILE_PACKED_SUFFIX);
+		/* the offsets stay the ones of the uncompressed segment */
+		LOGFILE_ShiftSegments(p_config, raw_index, LOGFILE_PACKED_SUFFIX LOGFILE_INDEX_SUFFIX);
+		unlink(raw);
+	}
+	/* else: the segment and its index stay at the raw name */
+}
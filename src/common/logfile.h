@@ -0,0 +1,95 @@
+#if !defined (LOGFILE_H_INCLUDE)
+#define LOGFILE_H_INCLUDE
+/**
+ * @file logfile.h
+ * @brief functional interface declarations for the memory-mapped log file
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdbool.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logfile_t.h"
+
+/* ----------------------------------------------------------------------
+ * function declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Start a log file
+ * @param[out] p_file the log file
+ * @param[in] p_config the settings
+ * @pre[tested] p_config->path must not be empty
+ * @pre[tested] p_config->segment_size must not be 0
+ * @return true on success, false otherwise
+ * @details
+ * A non-empty file left at the path is rotated first. With
+ * p_config->compress, a thread of the log file compresses the rotated
+ * segments; they become path.1.lz, path.2.lz, ... With
+ * p_config->index_lines, every segment gets an index (path.idx) mapping
+ * timestamps and levels to offsets, refer to struct LOGFILE_INDEX_S.
+ */
+bool LOGFILE_Open(struct LOGFILE_S* const p_file, const struct LOGFILE_CONFIG_S* const p_config);
+
+/**
+ * @brief Append bytes to the log file, rotating it when needed
+ * @param[in, out] p_file the log file
+ * @param[in] data the bytes
+ * @param[in] len the number of bytes
+ * @return true on success, false otherwise
+ * @details
+ * Records larger than a segment are truncated.
+ */
+bool LOGFILE_Append(struct LOGFILE_S* const p_file, const void* const data, size_t len);
+
+/**
+ * @brief Note an appended line in the index of the active segment
+ * @param[in, out] p_file the log file
+ * @param[in] offset the segment offset of the line
+ * @param[in] line the line, starting with its timestamp
+ * @param[in] len the number of characters of the line
+ * @param[in] level the LOGLV_xxx level of the line
+ * @details
+ * Does nothing without an index (p_file->p_index is NULL). Every
+ * config.index_lines lines start a new mark.
+ */
+void LOGFILE_IndexLine(struct LOGFILE_S* const p_file, const size_t offset, const char* const line, const size_t len, const uint64_t level);
+
+/**
+ * @brief Schedule the write-back of all appended bytes (msync, MS_ASYNC)
+ * @param[in, out] p_file the log file
+ */
+void LOGFILE_Flush(struct LOGFILE_S* const p_file);
+
+/**
+ * @brief Close the active segment and start a new one
+ * @param[in, out] p_file the log file
+ * @return true on success, false otherwise
+ */
+bool LOGFILE_Rotate(struct LOGFILE_S* const p_file);
+
+/**
+ * @brief Write back and close the log file
+ * @param[in, out] p_file the log file
+ * @details
+ * The active segment is cut to its used length. Waits for the rotated
+ * segments still queued for compression.
+ */
+void LOGFILE_Close(struct LOGFILE_S* const p_file);
+
+/* ----------------------------------------------------------------------
+ * exported variables declaration section
+ * ----------------------------------------------------------------------*/
+
+#endif /* if !defined(LOGFILE_H_INCLUDE)*/
@@ -0,0 +1,116 @@
+#if !defined (LOGFILE_T_H_INCLUDE)
+#define LOGFILE_T_H_INCLUDE
+/**
+ * @file logfile_t.h
+ * @brief interface type declarations for the memory-mapped log file
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+#include "logz_t.h"
+
+/* ----------------------------------------------------------------------
+ * macro declaration section
+ * ----------------------------------------------------------------------*/
+
+#define LOGFILE_PATH_SIZE (200) /**< Max length of the log file path */
+
+#define LOGFILE_INDEX_MAGIC  "LOGI"  /**< First bytes of a segment index */
+#define LOGFILE_INDEX_SUFFIX ".idx"  /**< Index of a segment: its name and this suffix */
+
+/* ----------------------------------------------------------------------
+ * type declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Settings of a log file
+ */
+struct LOGFILE_CONFIG_S {
+	char path[LOGFILE_PATH_SIZE]; /**< The active segment, rotated ones get .1, .2, ... */
+	size_t segment_size;          /**< Size of one segment (bytes) */
+	uint32_t rotate_seconds;      /**< Max age of a segment (s), 0 for size-only rotation */
+	uint32_t max_segments;        /**< Number of rotated segments kept */
+	size_t sync_bytes;            /**< Bytes appended between two msync calls */
+	uint32_t index_lines;         /**< Lines per mark of the segment index, 0 for no index */
+	bool compress;                /**< Compress the rotated segments: path.1.lz, path.2.lz, ... */
+};
+
+/**
+ * @brief The header of a segment index, followed by count marks
+ * @details
+ * The index of path is path.idx and follows the segment through the
+ * rotation (path.1.idx, path.1.lz.idx, ...); its offsets are the ones of
+ * the uncompressed segment.
+ */
+struct LOGFILE_INDEX_S {
+	char magic[4];    /**< LOGFILE_INDEX_MAGIC */
+	uint32_t lines;   /**< Lines per mark */
+	uint32_t count;   /**< Marks following the header, the last one may be open */
+	uint32_t sealed;  /**< 1 once the segment is closed: floor_ms is set */
+};
+
+/**
+ * @brief A mark of a segment index: a span of lines
+ * @details
+ * The lines are written a batch per thread, so their timestamps only
+ * roughly ascend. max_ms and floor_ms ascend over the marks and bound the
+ * spans which may hold a time range.
+ */
+struct LOGFILE_MARK_S {
+	uint64_t offset;   /**< Segment offset of the first line of the span */
+	int64_t min_ms;    /**< Earliest timestamp of the span (ms since the epoch) */
+	int64_t max_ms;    /**< Latest timestamp of the span and the ones before */
+	int64_t floor_ms;  /**< Sealed: earliest timestamp of the span and the ones after */
+	uint64_t levels;   /**< LOGLV_xxx bits of the lines of the span */
+};
+
+/**
+ * @brief The background compression of the rotated segments
+ * @details
+ * A rotation renames the active segment to path.raw<n> and queues it; the
+ * compressor thread turns it into path.1.lz, shifting the older ones.
+ */
+struct LOGFILE_PACKER_S {
+	struct LOGFILE_CONFIG_S config; /**< The settings of the log file */
+	pthread_t thread;               /**< The compressor thread */
+	pthread_mutex_t mutex;          /**< Guards queued, done and stop */
+	pthread_cond_t wakeup;          /**< Signals a queued segment or stop */
+	uint32_t queued;                /**< Segments queued since the start */
+	uint32_t done;                  /**< Segments handled since the start */
+	bool stop;                      /**< Finish the queue and end */
+	struct LOGZ_S z;                /**< The compressor */
+};
+
+/**
+ * @brief An open log file: the active segment is mapped in memory
+ */
+struct LOGFILE_S {
+	struct LOGFILE_CONFIG_S config; /**< The settings */
+	int fd;                         /**< The active segment, -1 if closed */
+	uint8_t* p_map;                 /**< Its mapping */
+	size_t offset;                  /**< Bytes appended to the segment */
+	size_t synced;                  /**< Offset up to which msync was issued */
+	time_t opened;                  /**< When the segment was started */
+	int index_fd;                   /**< The index of the active segment, -1 if none */
+	struct LOGFILE_INDEX_S* p_index; /**< Its mapping, NULL if none */
+	size_t index_size;              /**< Size of the mapping (bytes) */
+	uint32_t mark_lines;            /**< Lines in the last mark */
+	struct LOGFILE_PACKER_S* p_packer; /**< Compresses the rotated segments, NULL if off */
+};
+
+#endif /* if !defined(LOGFILE_T_H_INCLUDE) */
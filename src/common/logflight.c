@@ -0,0 +1,131 @@
+/**
+ * @file logflight.c
+ * @brief implementation of the crash flight recorder
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * Writers claim a position with one fetch-and-add and never wait: when the
+ * ring wraps, the oldest record is overwritten. The dump runs from a signal
+ * handler, so it doesn't lock nor allocate and only trusts records whose
+ * sequence number matches their position.
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logflight.h"
+
+/* ----------------------------------------------------------------------
+ * internal macro declaration section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * internal type declaration section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * function with internal linkage (static) declaration section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * variable with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported variable definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported function definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+bool LOGFLIGHT_Create(struct LOGFLIGHT_S* const p_flight, const size_t capacity)
+{
+	bool rv = false;
+	size_t i;
+
+	if (NULL == p_flight) {
+		rv = false;
+	} else if ((capacity < 2) || (0 != (capacity & (capacity - 1)))) {
+		rv = false;
+	} else if (NULL == (p_flight->p_entries = aligned_alloc(LOGFLIGHT_CACHE_LINE, capacity * sizeof(struct LOGFLIGHT_ENTRY_S)))) {
+		rv = false;
+	} else {
+		for (i = 0; i < capacity; i++) {
+			atomic_init(&p_flight->p_entries[i].seq, 0);
+			p_flight->p_entries[i].len = 0;
+		}
+		p_flight->mask = capacity - 1;
+		atomic_init(&p_flight->head, 0);
+		rv = true;
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGFLIGHT_Destroy(struct LOGFLIGHT_S* const p_flight)
+{
+	if (NULL != p_flight) {
+		free(p_flight->p_entries);
+		p_flight->p_entries = NULL;
+		p_flight->mask = 0;
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGFLIGHT_Record(struct LOGFLIGHT_S* const p_flight, const char* const text, const size_t len)
+{
+	struct LOGFLIGHT_ENTRY_S* p_entry;
+	size_t pos;
+	size_t copy_len = (len < LOGFLIGHT_TEXT_SIZE) ? len : LOGFLIGHT_TEXT_SIZE;
+
+	pos = atomic_fetch_add_explicit(&p_flight->head, 1, memory_order_relaxed);
+	p_entry = &p_flight->p_entries[pos & p_flight->mask];
+
+	/* invalidate before touching the text: a dump must not see a mix */
+	atomic_store_explicit(&p_entry->seq, 0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	memcpy(p_entry->text, text, copy_len);
+	if (copy_len < len) {
+		p_entry->text[copy_len - 1] = '\n';
+	}
+	p_entry->len = copy_len;
+
+	atomic_store_explicit(&p_entry->seq, pos + 1, memory_order_release);
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGFLIGHT_Dump(struct LOGFLIGHT_S* const p_flight, const int fd)
+{
+	struct LOGFLIGHT_ENTRY_S* p_entry;
+	size_t head = atomic_load_explicit(&p_flight->head, memory_order_acquire);
+	size_t capacity = p_flight->mask + 1;
+	size_t pos = (head > capacity) ? head - capacity : 0;
+	bool write_ok = true;
+
+	for (; (pos < head) && write_ok; pos++) {
+		p_entry = &p_flight->p_entries[pos & p_flight->mask];
+
+		if ((pos + 1) == atomic_load_explicit(&p_entry->seq, memory_order_acquire)) {
+			write_ok = (0 <= write(fd, p_entry->text, p_entry->len));
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------
+ * functions with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
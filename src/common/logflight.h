@@ -0,0 +1,63 @@
+#if !defined (LOGFLIGHT_H_INCLUDE)
+#define LOGFLIGHT_H_INCLUDE
+/**
+ * @file logflight.h
+ * @brief functional interface declarations for the crash flight recorder
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdbool.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logflight_t.h"
+
+/* ----------------------------------------------------------------------
+ * function declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Allocate the records of a flight recorder
+ * @param[out] p_flight the flight recorder to set up
+ * @param[in] capacity the number of records kept
+ * @pre[tested] p_flight must not be null
+ * @pre[tested] capacity must be a power of two >= 2
+ * @return true on success, false otherwise
+ */
+bool LOGFLIGHT_Create(struct LOGFLIGHT_S* const p_flight, const size_t capacity);
+
+/**
+ * @brief Release the records of a flight recorder
+ * @param[in, out] p_flight the flight recorder to destroy
+ * @pre[untested] no thread may record or dump anymore
+ */
+void LOGFLIGHT_Destroy(struct LOGFLIGHT_S* const p_flight);
+
+/**
+ * @brief Keep a rendered line, overwriting the oldest record (lock-free)
+ * @param[in, out] p_flight the flight recorder
+ * @param[in] text the line
+ * @param[in] len the number of characters
+ */
+void LOGFLIGHT_Record(struct LOGFLIGHT_S* const p_flight, const char* const text, const size_t len);
+
+/**
+ * @brief Write the complete records, oldest first
+ * @param[in] p_flight the flight recorder
+ * @param[in] fd the file descriptor to write to
+ * @details
+ * Async-signal-safe: only calls write(2).
+ */
+void LOGFLIGHT_Dump(struct LOGFLIGHT_S* const p_flight, const int fd);
+
+#endif /* if !defined(LOGFLIGHT_H_INCLUDE) */
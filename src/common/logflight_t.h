@@ -0,0 +1,57 @@
+#if !defined (LOGFLIGHT_T_H_INCLUDE)
+#define LOGFLIGHT_T_H_INCLUDE
+/**
+ * @file logflight_t.h
+ * @brief interface type declarations for the crash flight recorder
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* ----------------------------------------------------------------------
+ * macro declaration section
+ * ----------------------------------------------------------------------*/
+
+#define LOGFLIGHT_CACHE_LINE (64)  /**< Assumed cache line size (bytes) */
+#define LOGFLIGHT_TEXT_SIZE  (240) /**< Max text per record (bytes), longer lines are cut */
+
+/* ----------------------------------------------------------------------
+ * type declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief One record of the flight recorder
+ * @details
+ * seq is 0 while the record is written and position + 1 once it is
+ * complete, so a dump skips records torn by a crash.
+ */
+struct LOGFLIGHT_ENTRY_S {
+	atomic_size_t seq;                /**< Position + 1 of the record, 0 if incomplete */
+	uint32_t len;                     /**< Number of text bytes */
+	char text[LOGFLIGHT_TEXT_SIZE];   /**< The rendered line, '\n' terminated */
+};
+
+/**
+ * @brief A fixed-size ring keeping the most recent records, overwriting
+ * the oldest
+ */
+struct LOGFLIGHT_S {
+	struct LOGFLIGHT_ENTRY_S* p_entries;                /**< The record array */
+	size_t mask;                                        /**< capacity - 1 */
+	_Alignas(LOGFLIGHT_CACHE_LINE) atomic_size_t head;  /**< Next position to write */
+};
+
+#endif /* if !defined(LOGFLIGHT_T_H_INCLUDE) */
@@ -0,0 +1,677 @@
+/**
+ * @file logfmt.c
+ * @brief implementation of the deferred (binary) log formatting
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * The caller's thread only walks the format to learn the argument types and
+ * copies the raw argument bytes. The text is produced later by
+ * LOGFMT_RenderArgs, which replays every conversion through snprintf, on
+ * the log writer thread or offline from a binary stream.
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <ctype.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logfmt.h"
+
+/* ----------------------------------------------------------------------
+ * internal macro declaration section
+ * ----------------------------------------------------------------------*/
+
+#define LOGFMT_MAX_SPEC    (32)   /**< Max length of one conversion specification */
+#define LOGFMT_ENDIAN_MARK (0x0102)
+
+/**
+ * @brief snprintf a conversion that may take '*' width and/or precision
+ */
+#define LOGFMT_SNPRINTF(out, size, spec, n_star, stars, value)        \
+	((0 == (n_star)) ? snprintf(out, size, spec, value) :              \
+	 (1 == (n_star)) ? snprintf(out, size, spec, stars[0], value) :    \
+	 snprintf(out, size, spec, stars[0], stars[1], value))
+
+/**
+ * @brief Capture one argument of the given type
+ */
+#define LOGFMT_CAPTURE(type, promoted) {                               \
+	type value = (type) va_arg(ap, promoted);                          \
+	full = !LOGFMT_Put(buf, size, &used, &value, sizeof(value));       \
+}
+
+/**
+ * @brief Render one captured argument of the given type
+ */
+#define LOGFMT_RENDER(type) {                                          \
+	type value;                                                        \
+	if (!LOGFMT_Get(args, args_len, &off, &value, sizeof(value))) {    \
+		missing = true;                                                \
+	} else {                                                           \
+		n = LOGFMT_SNPRINTF(out + pos, size - pos, spec_str, spec.n_star, stars, value); \
+	}                                                                  \
+}
+
+/* ----------------------------------------------------------------------
+ * internal type declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief The argument class of a conversion specification
+ */
+enum LOGFMT_ARG_E {
+	LOGFMT_ARG_NONE = 0, /**< not a conversion: printed literally */
+	LOGFMT_ARG_PERCENT,  /**< %% */
+	LOGFMT_ARG_INT,
+	LOGFMT_ARG_LONG,
+	LOGFMT_ARG_LLONG,
+	LOGFMT_ARG_SIZE,
+	LOGFMT_ARG_INTMAX,
+	LOGFMT_ARG_PTRDIFF,
+	LOGFMT_ARG_DOUBLE,
+	LOGFMT_ARG_LDOUBLE,
+	LOGFMT_ARG_STRING,
+	LOGFMT_ARG_WSTRING,  /**< %ls: consumed, not captured */
+	LOGFMT_ARG_POINTER,
+	LOGFMT_ARG_COUNT,    /**< %n: consumed, not captured */
+	LOGFMT_ARG_ERRNO     /**< %m: errno of the caller */
+};
+
+/**
+ * @brief One parsed conversion specification
+ */
+struct LOGFMT_SPEC_S {
+	const char* start;      /**< The '%' */
+	size_t len;             /**< Length up to and including the conversion */
+	int n_star;             /**< Number of '*' width/precision arguments */
+	int precision;          /**< Literal precision, -1 if none */
+	bool star_precision;    /**< Precision is given by an argument */
+	enum LOGFMT_ARG_E arg;  /**< The argument class */
+};
+
+/* ----------------------------------------------------------------------
+ * function with internal linkage (static) declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Parse the conversion specification starting at p
+ * @param[in] p the '%' that starts the specification
+ * @param[out] p_spec the parsed specification
+ * @return the first character after the specification
+ */
+static const char* LOGFMT_ParseSpec(const char* p, struct LOGFMT_SPEC_S* const p_spec);
+
+/**
+ * @brief Append bytes to a capture buffer
+ * @return false if they don't fit
+ */
+static bool LOGFMT_Put(uint8_t* const buf, const size_t size, size_t* const p_used, const void* const src, const size_t n);
+
+/**
+ * @brief Take bytes from a capture buffer
+ * @return false if there are not enough bytes left
+ */
+static bool LOGFMT_Get(const uint8_t* const buf, const size_t len, size_t* const p_off, void* const dst, const size_t n);
+
+/**
+ * @brief Get the stream id of a string, writing its definition if new
+ * @return true on success, false on write error
+ */
+static bool LOGFMT_Intern(FILE* const fp, struct LOGFMT_DICT_S* const p_dict, const char* str, uint32_t* const p_id);
+
+/**
+ * @brief Fill a stream header for this ABI
+ */
+static void LOGFMT_LocalHeader(struct LOGFMT_STREAM_HEADER_S* const p_header);
+
+/* ----------------------------------------------------------------------
+ * variable with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported variable definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported function definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+size_t LOGFMT_CaptureArgs(
+		uint8_t* const buf,
+		const size_t size,
+		const char* fmt,
+		va_list args,
+		bool* const p_truncated)
+{
+	struct LOGFMT_SPEC_S spec;
+	const char* p = fmt;
+	int saved_errno = errno;
+	int stars[2];
+	size_t used = 0;
+	bool full = false;
+	va_list ap;
+	int i;
+
+	va_copy(ap, args);
+
+	while (('\0' != *p) && !full) {
+		if ('%' != *p) {
+			p++;
+			continue;
+		}
+		p = LOGFMT_ParseSpec(p, &spec);
+
+		for (i = 0; (i < spec.n_star) && !full; i++) {
+			stars[i] = va_arg(ap, int);
+			full = !LOGFMT_Put(buf, size, &used, &stars[i], sizeof(stars[i]));
+		}
+		if (full) {
+			break;
+		}
+
+		switch (spec.arg) {
+		case LOGFMT_ARG_INT:     LOGFMT_CAPTURE(int, int); break;
+		case LOGFMT_ARG_LONG:    LOGFMT_CAPTURE(long, long); break;
+		case LOGFMT_ARG_LLONG:   LOGFMT_CAPTURE(long long, long long); break;
+		case LOGFMT_ARG_SIZE:    LOGFMT_CAPTURE(size_t, size_t); break;
+		case LOGFMT_ARG_INTMAX:  LOGFMT_CAPTURE(intmax_t, intmax_t); break;
+		case LOGFMT_ARG_PTRDIFF: LOGFMT_CAPTURE(ptrdiff_t, ptrdiff_t); break;
+		case LOGFMT_ARG_DOUBLE:  LOGFMT_CAPTURE(double, double); break;
+		case LOGFMT_ARG_LDOUBLE: LOGFMT_CAPTURE(long double, long double); break;
+		case LOGFMT_ARG_POINTER: LOGFMT_CAPTURE(void*, void*); break;
+		case LOGFMT_ARG_ERRNO:
+			full = !LOGFMT_Put(buf, size, &used, &saved_errno, sizeof(saved_errno));
+			break;
+		case LOGFMT_ARG_STRING: {
+			const char* str = va_arg(ap, const char*);
+			uint16_t str_len = LOGFMT_NULL_STRING;
+			size_t max = LOGFMT_MAX_STRING;
+			int precision = spec.star_precision ? stars[spec.n_star - 1] : spec.precision;
+			bool shortened = false;
+
+			if (NULL != str) {
+				if ((0 <= precision) && ((size_t)precision < max)) {
+					max = precision;
+				}
+				if (used + sizeof(str_len) + max > size) {
+					/* shorten the string rather than dropping it */
+					max = (used + sizeof(str_len) < size) ? size - used - sizeof(str_len) : 0;
+					shortened = true;
+				}
+				str_len = strnlen(str, max);
+				/* only a string longer than the room left is cut */
+				if (shortened && (str_len == max) && ('\0' != str[max])) {
+					*p_truncated = true;
+				}
+			}
+			full = !LOGFMT_Put(buf, size, &used, &str_len, sizeof(str_len));
+			if (!full && (LOGFMT_NULL_STRING != str_len)) {
+				full = !LOGFMT_Put(buf, size, &used, str, str_len);
+			}
+			break;
+		}
+		case LOGFMT_ARG_WSTRING:
+			(void) va_arg(ap, wchar_t*);
+			break;
+		case LOGFMT_ARG_COUNT:
+			(void) va_arg(ap, int*);
+			break;
+		default:
+			break;
+		}
+	}
+
+	va_end(ap);
+
+	if (full) {
+		*p_truncated = true;
+	}
+	return used;
+}
+
+/* ----------------------------------------------------------------------*/
+size_t LOGFMT_RenderArgs(
+		char* const out,
+		const size_t size,
+		const char* fmt,
+		const uint8_t* const args,
+		const size_t args_len)
+{
+	struct LOGFMT_SPEC_S spec;
+	char spec_str[LOGFMT_MAX_SPEC];
+	const char* p = fmt;
+	size_t pos = 0;
+	size_t off = 0;
+	bool missing = false;
+	int stars[2];
+	int n;
+	int i;
+
+	while (('\0' != *p) && (pos < size - 1) && !missing) {
+		if ('%' != *p) {
+			out[pos++] = *p++;
+			continue;
+		}
+		p = LOGFMT_ParseSpec(p, &spec);
+		n = 0;
+
+		if (spec.len >= sizeof(spec_str)) {
+			spec.arg = LOGFMT_ARG_NONE;
+		} else {
+			memcpy(spec_str, spec.start, spec.len);
+			spec_str[spec.len] = '\0';
+		}
+
+		for (i = 0; (i < spec.n_star) && !missing; i++) {
+			missing = !LOGFMT_Get(args, args_len, &off, &stars[i], sizeof(stars[i]));
+		}
+		if (missing) {
+			break;
+		}
+
+		switch (spec.arg) {
+		case LOGFMT_ARG_PERCENT:
+			out[pos] = '%';
+			n = 1;
+			break;
+		case LOGFMT_ARG_INT:     LOGFMT_RENDER(int); break;
+		case LOGFMT_ARG_LONG:    LOGFMT_RENDER(long); break;
+		case LOGFMT_ARG_LLONG:   LOGFMT_RENDER(long long); break;
+		case LOGFMT_ARG_SIZE:    LOGFMT_RENDER(size_t); break;
+		case LOGFMT_ARG_INTMAX:  LOGFMT_RENDER(intmax_t); break;
+		case LOGFMT_ARG_PTRDIFF: LOGFMT_RENDER(ptrdiff_t); break;
+		case LOGFMT_ARG_DOUBLE:  LOGFMT_RENDER(double); break;
+		case LOGFMT_ARG_LDOUBLE: LOGFMT_RENDER(long double); break;
+		case LOGFMT_ARG_POINTER: LOGFMT_RENDER(void*); break;
+		case LOGFMT_ARG_ERRNO: {
+			int err;
+			if (!LOGFMT_Get(args, args_len, &off, &err, sizeof(err))) {
+				missing = true;
+			} else {
+				spec_str[spec.len - 1] = 's';
+				n = LOGFMT_SNPRINTF(out + pos, size - pos, spec_str, spec.n_star, stars, strerror(err));
+			}
+			break;
+		}
+		case LOGFMT_ARG_STRING: {
+			char str[LOGFMT_MAX_STRING + 1];
+			uint16_t str_len;
+
+			if (!LOGFMT_Get(args, args_len, &off, &str_len, sizeof(str_len))) {
+				missing = true;
+			} else if (LOGFMT_NULL_STRING == str_len) {
+				n = LOGFMT_SNPRINTF(out + pos, size - pos, spec_str, spec.n_star, stars, "(null)");
+			} else if ((str_len > LOGFMT_MAX_STRING) || !LOGFMT_Get(args, args_len, &off, str, str_len)) {
+				missing = true;
+			} else {
+				str[str_len] = '\0';
+				n = LOGFMT_SNPRINTF(out + pos, size - pos, spec_str, spec.n_star, stars, str);
+			}
+			break;
+		}
+		case LOGFMT_ARG_WSTRING:
+			n = snprintf(out + pos, size - pos, "(wstr)");
+			break;
+		case LOGFMT_ARG_COUNT:
+			break;
+		default:
+			n = snprintf(out + pos, size - pos, "%.*s", (int)spec.len, spec.start);
+			break;
+		}
+
+		if (0 < n) {
+			pos = (pos + n < size - 1) ? pos + n : size - 1;
+		}
+	}
+
+	if (missing) {
+		n = snprintf(out + pos, size - pos, "...");
+		if (0 < n) {
+			pos = (pos + n < size - 1) ? pos + n : size - 1;
+		}
+	}
+	out[pos] = '\0';
+	return pos;
+}
+
+/* ----------------------------------------------------------------------*/
+bool LOGFMT_WriteHeader(FILE* const fp, struct LOGFMT_DICT_S* const p_dict)
+{
+	struct LOGFMT_STREAM_HEADER_S header;
+
+	memset(p_dict, 0, sizeof(*p_dict));
+	LOGFMT_LocalHeader(&header);
+	return (1 == fwrite(&header, sizeof(header), 1, fp));
+}
+
+/* ----------------------------------------------------------------------*/
+bool LOGFMT_WriteRecord(
+		FILE* const fp,
+		struct LOGFMT_DICT_S* const p_dict,
+		const struct LOGFMT_RECORD_S* const p_rec)
+{
+	uint8_t entry[1 + sizeof(int64_t) + sizeof(uint32_t) + 2 * sizeof(uint16_t) + sizeof(uint64_t) + 2 * sizeof(uint32_t)];
+	size_t used = 0;
+	uint8_t tag = LOGFMT_ENTRY_RECORD;
+	uint32_t fn_id;
+	uint32_t fmt_id;
+	bool rv = false;
+
+	if (LOGFMT_Intern(fp, p_dict, p_rec->fn, &fn_id) && LOGFMT_Intern(fp, p_dict, p_rec->fmt, &fmt_id)) {
+		LOGFMT_Put(entry, sizeof(entry), &used, &tag, sizeof(tag));
+		LOGFMT_Put(entry, sizeof(entry), &used, &p_rec->sec, sizeof(p_rec->sec));
+		LOGFMT_Put(entry, sizeof(entry), &used, &p_rec->nsec, sizeof(p_rec->nsec));
+		LOGFMT_Put(entry, sizeof(entry), &used, &p_rec->flags, sizeof(p_rec->flags));
+		LOGFMT_Put(entry, sizeof(entry), &used, &p_rec->args_len, sizeof(p_rec->args_len));
+		LOGFMT_Put(entry, sizeof(entry), &used, &p_rec->level, sizeof(p_rec->level));
+		LOGFMT_Put(entry, sizeof(entry), &used, &fn_id, sizeof(fn_id));
+		LOGFMT_Put(entry, sizeof(entry), &used, &fmt_id, sizeof(fmt_id));
+
+		rv = (1 == fwrite(entry, used, 1, fp))
+			&& ((0 == p_rec->args_len) || (1 == fwrite(p_rec->args, p_rec->args_len, 1, fp)));
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+bool LOGFMT_OpenReader(struct LOGFMT_READER_S* const p_reader, FILE* const fp)
+{
+	struct LOGFMT_STREAM_HEADER_S header;
+	struct LOGFMT_STREAM_HEADER_S local;
+
+	memset(p_reader, 0, sizeof(*p_reader));
+	p_reader->fp = fp;
+	LOGFMT_LocalHeader(&local);
+
+	return (1 == fread(&header, sizeof(header), 1, fp))
+		&& (0 == memcmp(&header, &local, sizeof(header)));
+}
+
+/* ----------------------------------------------------------------------*/
+int LOGFMT_ReadRecord(struct LOGFMT_READER_S* const p_reader, struct LOGFMT_RECORD_S* const p_rec)
+{
+	FILE* fp = p_reader->fp;
+	uint32_t fn_id;
+	uint32_t fmt_id;
+	uint32_t id;
+	uint16_t len;
+	int tag;
+	int rv = -1;
+
+	for (;;) {
+		tag = fgetc(fp);
+
+		if (EOF == tag) {
+			rv = feof(fp) ? 0 : -1;
+			break;
+		} else if (LOGFMT_ENTRY_STRING == tag) {
+			if ((1 != fread(&id, sizeof(id), 1, fp)) || (1 != fread(&len, sizeof(len), 1, fp))) {
+				break;
+			}
+			if (id >= p_reader->n_strings) {
+				uint32_t n = (id < 64) ? 128 : 2 * id;
+				char** p_new = realloc(p_reader->strings, n * sizeof(char*));
+				if (NULL == p_new) {
+					break;
+				}
+				memset(p_new + p_reader->n_strings, 0, (n - p_reader->n_strings) * sizeof(char*));
+				p_reader->strings = p_new;
+				p_reader->n_strings = n;
+			}
+			free(p_reader->strings[id]);
+			if (NULL == (p_reader->strings[id] = malloc(len + 1))) {
+				break;
+			}
+			if ((0 != len) && (1 != fread(p_reader->strings[id], len, 1, fp))) {
+				break;
+			}
+			p_reader->strings[id][len] = '\0';
+		} else if (LOGFMT_ENTRY_RECORD == tag) {
+			if ((1 != fread(&p_rec->sec, sizeof(p_rec->sec), 1, fp))
+					|| (1 != fread(&p_rec->nsec, sizeof(p_rec->nsec), 1, fp))
+					|| (1 != fread(&p_rec->flags, sizeof(p_rec->flags), 1, fp))
+					|| (1 != fread(&p_rec->args_len, sizeof(p_rec->args_len), 1, fp))
+					|| (1 != fread(&p_rec->level, sizeof(p_rec->level), 1, fp))
+					|| (1 != fread(&fn_id, sizeof(fn_id), 1, fp))
+					|| (1 != fread(&fmt_id, sizeof(fmt_id), 1, fp))
+					|| ((0 != p_rec->args_len) && (1 != fread(p_rec->args, p_rec->args_len, 1, fp)))) {
+				break;
+			}
+			p_rec->fn = ((fn_id < p_reader->n_strings) && (NULL != p_reader->strings[fn_id])) ? p_reader->strings[fn_id] : "?";
+			p_rec->fmt = ((fmt_id < p_reader->n_strings) && (NULL != p_reader->strings[fmt_id])) ? p_reader->strings[fmt_id] : "?";
+			rv = 1;
+			break;
+		} else {
+			break;
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGFMT_CloseReader(struct LOGFMT_READER_S* const p_reader)
+{
+	uint32_t i;
+
+	for (i = 0; i < p_reader->n_strings; i++) {
+		free(p_reader->strings[i]);
+	}
+	free(p_reader->strings);
+	p_reader->strings = NULL;
+	p_reader->n_strings = 0;
+}
+
+/* ----------------------------------------------------------------------
+ * functions with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+static const char* LOGFMT_ParseSpec(const char* p, struct LOGFMT_SPEC_S* const p_spec)
+{
+	const char* it = p + 1;
+	char mod = '\0';
+
+	p_spec->start = p;
+	p_spec->n_star = 0;
+	p_spec->precision = -1;
+	p_spec->star_precision = false;
+	p_spec->arg = LOGFMT_ARG_NONE;
+
+	/* flags */
+	while (('\0' != *it) && (NULL != strchr("-+ #0'I", *it))) {
+		it++;
+	}
+	/* width */
+	if ('*' == *it) {
+		p_spec->n_star++;
+		it++;
+	} else {
+		while (isdigit((unsigned char)*it)) {
+			it++;
+		}
+	}
+	/* precision */
+	if ('.' == *it) {
+		it++;
+		if ('*' == *it) {
+			p_spec->n_star++;
+			p_spec->star_precision = true;
+			it++;
+		} else {
+			p_spec->precision = 0;
+			while (isdigit((unsigned char)*it)) {
+				p_spec->precision = 10 * p_spec->precision + (*it - '0');
+				it++;
+			}
+		}
+	}
+	/* length modifier, 'L' stands for 'll' as well as for long double */
+	switch (*it) {
+	case 'h':
+		it += ('h' == it[1]) ? 2 : 1;
+		mod = 'h';
+		break;
+	case 'l':
+		if ('l' == it[1]) {
+			mod = 'L';
+			it += 2;
+		} else {
+			mod = 'l';
+			it++;
+		}
+		break;
+	case 'q':
+	case 'L':
+		mod = 'L';
+		it++;
+		break;
+	case 'j':
+	case 'z':
+	case 'Z':
+	case 't':
+		mod = *it++;
+		break;
+	default:
+		break;
+	}
+	/* conversion */
+	switch (*it) {
+	case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+		switch (mod) {
+		case 'l': p_spec->arg = LOGFMT_ARG_LONG; break;
+		case 'L': p_spec->arg = LOGFMT_ARG_LLONG; break;
+		case 'j': p_spec->arg = LOGFMT_ARG_INTMAX; break;
+		case 'z': case 'Z': p_spec->arg = LOGFMT_ARG_SIZE; break;
+		case 't': p_spec->arg = LOGFMT_ARG_PTRDIFF; break;
+		default: p_spec->arg = LOGFMT_ARG_INT; break;
+		}
+		break;
+	case 'c': case 'C':
+		p_spec->arg = LOGFMT_ARG_INT;
+		break;
+	case 's':
+		p_spec->arg = ('l' == mod) ? LOGFMT_ARG_WSTRING : LOGFMT_ARG_STRING;
+		break;
+	case 'S':
+		p_spec->arg = LOGFMT_ARG_WSTRING;
+		break;
+	case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		p_spec->arg = ('L' == mod) ? LOGFMT_ARG_LDOUBLE : LOGFMT_ARG_DOUBLE;
+		break;
+	case 'p':
+		p_spec->arg = LOGFMT_ARG_POINTER;
+		break;
+	case 'n':
+		p_spec->arg = LOGFMT_ARG_COUNT;
+		break;
+	case 'm':
+		p_spec->arg = LOGFMT_ARG_ERRNO;
+		break;
+	case '%':
+		p_spec->arg = LOGFMT_ARG_PERCENT;
+		break;
+	default:
+		break;
+	}
+
+	if ('\0' != *it) {
+		it++;
+	}
+	p_spec->len = it - p;
+	return it;
+}
+
+/* ----------------------------------------------------------------------*/
+static bool LOGFMT_Put(uint8_t* const buf, const size_t size, size_t* const p_used, const void* const src, const size_t n)
+{
+	bool rv = false;
+
+	if (*p_used + n <= size) {
+		memcpy(buf + *p_used, src, n);
+		*p_used += n;
+		rv = true;
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static bool LOGFMT_Get(const uint8_t* const buf, const size_t len, size_t* const p_off, void* const dst, const size_t n)
+{
+	bool rv = false;
+
+	if (*p_off + n <= len) {
+		memcpy(dst, buf + *p_off, n);
+		*p_off += n;
+		rv = true;
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static bool LOGFMT_Intern(FILE* const fp, struct LOGFMT_DICT_S* const p_dict, const char* str, uint32_t* const p_id)
+{
+	uint8_t tag = LOGFMT_ENTRY_STRING;
+	size_t idx;
+	size_t len;
+	uint16_t len16;
+	bool rv = true;
+
+	if (NULL == str) {
+		str = "(null)";
+	}
+
+	/* open addressing on the string address (Fibonacci hashing) */
+	idx = (((uintptr_t)str >> 2) * 0x9E3779B97F4A7C15ULL) % LOGFMT_DICT_SIZE;
+	while ((NULL != p_dict->keys[idx]) && (str != p_dict->keys[idx])) {
+		idx = (idx + 1) % LOGFMT_DICT_SIZE;
+	}
+
+	if (str == p_dict->keys[idx]) {
+		*p_id = p_dict->ids[idx];
+	} else {
+		*p_id = p_dict->next_id++;
+		len = strlen(str);
+		len16 = (len > UINT16_MAX) ? UINT16_MAX : len;
+
+		rv = (1 == fwrite(&tag, sizeof(tag), 1, fp))
+			&& (1 == fwrite(p_id, sizeof(*p_id), 1, fp))
+			&& (1 == fwrite(&len16, sizeof(len16), 1, fp))
+			&& ((0 == len16) || (1 == fwrite(str, len16, 1, fp)));
+
+		/* keep the table sparse: once 3/4 full, strings are re-defined on use */
+		if (rv && (p_dict->used < (LOGFMT_DICT_SIZE / 4) * 3)) {
+			p_dict->keys[idx] = str;
+			p_dict->ids[idx] = *p_id;
+			p_dict->used++;
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGFMT_LocalHeader(struct LOGFMT_STREAM_HEADER_S* const p_header)
+{
+	memset(p_header, 0, sizeof(*p_header));
+	memcpy(p_header->magic, LOGFMT_STREAM_MAGIC, sizeof(p_header->magic));
+	p_header->endian = LOGFMT_ENDIAN_MARK;
+	p_header->sizeof_long = sizeof(long);
+	p_header->sizeof_ptr = sizeof(void*);
+	p_header->sizeof_ldouble = sizeof(long double);
+	p_header->sizeof_size = sizeof(size_t);
+	p_header->sizeof_intmax = sizeof(intmax_t);
+	p_header->sizeof_ptrdiff = sizeof(ptrdiff_t);
+}
@@ -0,0 +1,119 @@
+#if !defined (LOGFMT_H_INCLUDE)
+#define LOGFMT_H_INCLUDE
+/**
+ * @file logfmt.h
+ * @brief functional interface declarations for the deferred (binary) log
+ * formatting
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logfmt_t.h"
+
+/* ----------------------------------------------------------------------
+ * function declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Store the raw arguments of a printf-like call
+ * @param[out] buf the buffer receiving the argument bytes
+ * @param[in] size the size of buf
+ * @param[in] fmt the printf-like format
+ * @param[in] args the arguments of fmt
+ * @param[out] p_truncated set to true if not all arguments fitted
+ * @pre[untested] buf, fmt and p_truncated must not be null
+ * @return the number of bytes used in buf
+ */
+size_t LOGFMT_CaptureArgs(
+		uint8_t* const buf,
+		const size_t size,
+		const char* fmt,
+		va_list args,
+		bool* const p_truncated);
+
+/**
+ * @brief Render a format with arguments captured by LOGFMT_CaptureArgs
+ * @param[out] out the text buffer
+ * @param[in] size the size of out
+ * @param[in] fmt the printf-like format
+ * @param[in] args the captured argument bytes
+ * @param[in] args_len the number of captured bytes
+ * @pre[untested] out, fmt and args must not be null
+ * @pre[untested] size must be > 0
+ * @return the number of characters written (excluding the null byte)
+ */
+size_t LOGFMT_RenderArgs(
+		char* const out,
+		const size_t size,
+		const char* fmt,
+		const uint8_t* const args,
+		const size_t args_len);
+
+/**
+ * @brief Start a binary stream
+ * @param[in] fp the stream
+ * @param[out] p_dict the string dictionary of the stream to reset
+ * @return true on success, false otherwise
+ */
+bool LOGFMT_WriteHeader(FILE* const fp, struct LOGFMT_DICT_S* const p_dict);
+
+/**
+ * @brief Append one record to a binary stream
+ * @param[in] fp the stream
+ * @param[in, out] p_dict the string dictionary of the stream
+ * @param[in] p_rec the record
+ * @return true on success, false otherwise
+ * @details
+ * fn and fmt are written once per stream as string entries and referenced
+ * by id afterwards.
+ */
+bool LOGFMT_WriteRecord(
+		FILE* const fp,
+		struct LOGFMT_DICT_S* const p_dict,
+		const struct LOGFMT_RECORD_S* const p_rec);
+
+/**
+ * @brief Open a binary stream for reading
+ * @param[out] p_reader the reader state
+ * @param[in] fp the stream, positioned at its header
+ * @return true if the header matches this ABI, false otherwise
+ */
+bool LOGFMT_OpenReader(struct LOGFMT_READER_S* const p_reader, FILE* const fp);
+
+/**
+ * @brief Read the next record of a binary stream
+ * @param[in, out] p_reader the reader state
+ * @param[out] p_rec the record, its args must offer UINT16_MAX bytes
+ * @return 1 if a record is read, 0 at the end of the stream, -1 on error
+ * @details
+ * fn and fmt of the record point into the reader and stay valid until
+ * LOGFMT_CloseReader.
+ */
+int LOGFMT_ReadRecord(struct LOGFMT_READER_S* const p_reader, struct LOGFMT_RECORD_S* const p_rec);
+
+/**
+ * @brief Release the reader state (the stream is not closed)
+ * @param[in, out] p_reader the reader state
+ */
+void LOGFMT_CloseReader(struct LOGFMT_READER_S* const p_reader);
+
+/* ----------------------------------------------------------------------
+ * exported variables declaration section
+ * ----------------------------------------------------------------------*/
+
+#endif /* if !defined(LOGFMT_H_INCLUDE)*/
@@ -0,0 +1,92 @@
+#if !defined (LOGFMT_T_H_INCLUDE)
+#define LOGFMT_T_H_INCLUDE
+/**
+ * @file logfmt_t.h
+ * @brief interface type declarations for the deferred (binary) log formatting
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdint.h>
+#include <stdio.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* ----------------------------------------------------------------------
+ * macro declaration section
+ * ----------------------------------------------------------------------*/
+
+#define LOGFMT_MAX_STRING     (255)        /**< Max captured length of a %s argument */
+#define LOGFMT_NULL_STRING    (0xFFFF)     /**< Captured length of a null %s argument */
+#define LOGFMT_DICT_SIZE      (4096)       /**< Number of interned strings per stream */
+#define LOGFMT_STREAM_MAGIC   "APPLOGB1"   /**< First bytes of a binary log stream */
+#define LOGFMT_ENTRY_STRING   ('S')        /**< Stream entry: string definition */
+#define LOGFMT_ENTRY_RECORD   ('R')        /**< Stream entry: log record */
+
+/* record flags */
+#define LOGFMT_FLAG_DEBUG     (0x0001)     /**< Record issued by APPLOG_LogDebug */
+#define LOGFMT_FLAG_TRUNCATED (0x0002)     /**< Not all arguments fitted the record */
+
+/* ----------------------------------------------------------------------
+ * type declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief A log record whose text rendering is deferred
+ * @details
+ * fn and fmt are only referenced, the arguments are stored as raw bytes
+ * in the order of the conversions of fmt (strings are copied).
+ */
+struct LOGFMT_RECORD_S {
+	int64_t sec;         /**< Timestamp (LOGTIME_CLOCKID) seconds */
+	uint32_t nsec;       /**< Timestamp nanoseconds */
+	uint16_t flags;      /**< LOGFMT_FLAG_xxx */
+	uint16_t args_len;   /**< Number of bytes in args */
+	uint64_t level;      /**< The LOGLV_xxx level */
+	const char* fn;      /**< The function name */
+	const char* fmt;     /**< The printf-like format */
+	uint8_t args[];      /**< The captured arguments */
+};
+
+/**
+ * @brief Stream header, checked by readers against their own ABI
+ */
+struct LOGFMT_STREAM_HEADER_S {
+	char magic[8];           /**< LOGFMT_STREAM_MAGIC */
+	uint16_t endian;         /**< 0x0102 in the writer's byte order */
+	uint8_t sizeof_long;     /**< sizeof(long) of the writer */
+	uint8_t sizeof_ptr;      /**< sizeof(void*) of the writer */
+	uint8_t sizeof_ldouble;  /**< sizeof(long double) of the writer */
+	uint8_t sizeof_size;     /**< sizeof(size_t) of the writer */
+	uint8_t sizeof_intmax;   /**< sizeof(intmax_t) of the writer */
+	uint8_t sizeof_ptrdiff;  /**< sizeof(ptrdiff_t) of the writer */
+};
+
+/**
+ * @brief Writer side dictionary mapping string addresses to stream ids
+ */
+struct LOGFMT_DICT_S {
+	const char* keys[LOGFMT_DICT_SIZE]; /**< Interned addresses, NULL if free */
+	uint32_t ids[LOGFMT_DICT_SIZE];     /**< Stream id of each key */
+	uint32_t used;                      /**< Number of keys in use */
+	uint32_t next_id;                   /**< Next stream id to hand out */
+};
+
+/**
+ * @brief Reader side state of a binary stream
+ */
+struct LOGFMT_READER_S {
+	FILE* fp;          /**< The stream */
+	char** strings;    /**< Strings indexed by stream id */
+	uint32_t n_strings;/**< Allocated entries in strings */
+};
+
+#endif /* if !defined(LOGFMT_T_H_INCLUDE) */
@@ -0,0 +1,164 @@
+/**
+ * @file logring.c
+ * @brief implementation of the bounded lock-free log record ring
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * Bounded queue after D. Vyukov: every slot carries a sequence number, so
+ * producers only contend on one compare-and-swap of the enqueue position and
+ * never wait for each other. The consumer side uses the same scheme, which
+ * keeps the ring safe for more than one consumer as well.
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdlib.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logring.h"
+
+/* ----------------------------------------------------------------------
+ * internal macro declaration section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * internal type declaration section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * function with internal linkage (static) declaration section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * variable with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported variable definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported function definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+bool LOGRING_Create(struct LOGRING_S* const p_ring, const size_t capacity)
+{
+	bool rv = false;
+	size_t i;
+
+	if (NULL == p_ring) {
+		rv = false;
+	} else if ((capacity < 2) || (0 != (capacity & (capacity - 1)))) {
+		rv = false;
+	} else if (NULL == (p_ring->p_slots = aligned_alloc(LOGRING_CACHE_LINE, capacity * sizeof(struct LOGRING_SLOT_S)))) {
+		rv = false;
+	} else {
+		for (i = 0; i < capacity; i++) {
+			atomic_init(&p_ring->p_slots[i].seq, i);
+		}
+		p_ring->mask = capacity - 1;
+		atomic_init(&p_ring->enqueue_pos, 0);
+		atomic_init(&p_ring->dequeue_pos, 0);
+		rv = true;
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGRING_Destroy(struct LOGRING_S* const p_ring)
+{
+	if (NULL != p_ring) {
+		free(p_ring->p_slots);
+		p_ring->p_slots = NULL;
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+struct LOGRING_SLOT_S* LOGRING_Reserve(struct LOGRING_S* const p_ring)
+{
+	struct LOGRING_SLOT_S* p_slot;
+	size_t pos = atomic_load_explicit(&p_ring->enqueue_pos, memory_order_relaxed);
+	size_t seq;
+
+	for (;;) {
+		p_slot = &p_ring->p_slots[pos & p_ring->mask];
+		seq = atomic_load_explicit(&p_slot->seq, memory_order_acquire);
+
+		if (seq == pos) {
+			if (atomic_compare_exchange_weak_explicit(&p_ring->enqueue_pos, &pos, pos + 1,
+					memory_order_relaxed, memory_order_relaxed)) {
+				p_slot->pos = pos;
+				break;
+			}
+		} else if ((intptr_t)(seq - pos) < 0) {
+			/* the slot still holds the record of the previous lap: full */
+			p_slot = NULL;
+			break;
+		} else {
+			pos = atomic_load_explicit(&p_ring->enqueue_pos, memory_order_relaxed);
+		}
+	}
+	return p_slot;
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGRING_Commit(struct LOGRING_SLOT_S* const p_slot)
+{
+	atomic_store_explicit(&p_slot->seq, p_slot->pos + 1, memory_order_release);
+}
+
+/* ----------------------------------------------------------------------*/
+struct LOGRING_SLOT_S* LOGRING_Acquire(struct LOGRING_S* const p_ring)
+{
+	struct LOGRING_SLOT_S* p_slot;
+	size_t pos = atomic_load_explicit(&p_ring->dequeue_pos, memory_order_relaxed);
+	size_t seq;
+
+	for (;;) {
+		p_slot = &p_ring->p_slots[pos & p_ring->mask];
+		seq = atomic_load_explicit(&p_slot->seq, memory_order_acquire);
+
+		if (seq == pos + 1) {
+			if (atomic_compare_exchange_weak_explicit(&p_ring->dequeue_pos, &pos, pos + 1,
+					memory_order_relaxed, memory_order_relaxed)) {
+				p_slot->pos = pos;
+				break;
+			}
+		} else if ((intptr_t)(seq - (pos + 1)) < 0) {
+			/* nothing committed at this position yet: empty */
+			p_slot = NULL;
+			break;
+		} else {
+			pos = atomic_load_explicit(&p_ring->dequeue_pos, memory_order_relaxed);
+		}
+	}
+	return p_slot;
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGRING_Release(struct LOGRING_S* const p_ring, struct LOGRING_SLOT_S* const p_slot)
+{
+	atomic_store_explicit(&p_slot->seq, p_slot->pos + p_ring->mask + 1, memory_order_release);
+}
+
+/* ----------------------------------------------------------------------*/
+size_t LOGRING_Depth(struct LOGRING_S* const p_ring)
+{
+	size_t enq = atomic_load_explicit(&p_ring->enqueue_pos, memory_order_relaxed);
+	size_t deq = atomic_load_explicit(&p_ring->dequeue_pos, memory_order_relaxed);
+
+	return (enq > deq) ? (enq - deq) : 0;
+}
+
+/* ----------------------------------------------------------------------
+ * functions with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
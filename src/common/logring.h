@@ -0,0 +1,89 @@
+#if !defined (LOGRING_H_INCLUDE)
+#define LOGRING_H_INCLUDE
+/**
+ * @file logring.h
+ * @brief functional interface declarations for the bounded lock-free log
+ * record ring
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdbool.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logring_t.h"
+
+/* ----------------------------------------------------------------------
+ * function declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Allocate the slots of a ring
+ * @param[out] p_ring the ring to set up
+ * @param[in] capacity the number of slots
+ * @pre[tested] p_ring must not be null
+ * @pre[tested] capacity must be a power of two >= 2
+ * @return true on success, false otherwise
+ */
+bool LOGRING_Create(struct LOGRING_S* const p_ring, const size_t capacity);
+
+/**
+ * @brief Release the slots of a ring
+ * @param[in, out] p_ring the ring to destroy
+ * @pre[untested] no producer nor consumer may use the ring anymore
+ */
+void LOGRING_Destroy(struct LOGRING_S* const p_ring);
+
+/**
+ * @brief Reserve a free slot for writing (producer side, lock-free)
+ * @param[in, out] p_ring the ring
+ * @return the reserved slot, NULL if the ring is full
+ * @details
+ * The slot belongs to the caller until LOGRING_Commit is called.
+ */
+struct LOGRING_SLOT_S* LOGRING_Reserve(struct LOGRING_S* const p_ring);
+
+/**
+ * @brief Publish a reserved slot to the consumer
+ * @param[in, out] p_slot the slot returned by LOGRING_Reserve
+ */
+void LOGRING_Commit(struct LOGRING_SLOT_S* const p_slot);
+
+/**
+ * @brief Take the oldest committed slot for reading (consumer side)
+ * @param[in, out] p_ring the ring
+ * @return the oldest committed slot, NULL if there is none
+ * @details
+ * The slot belongs to the caller until LOGRING_Release is called.
+ */
+struct LOGRING_SLOT_S* LOGRING_Acquire(struct LOGRING_S* const p_ring);
+
+/**
+ * @brief Hand an acquired slot back to the producers
+ * @param[in, out] p_ring the ring
+ * @param[in, out] p_slot the slot returned by LOGRING_Acquire
+ */
+void LOGRING_Release(struct LOGRING_S* const p_ring, struct LOGRING_SLOT_S* const p_slot);
+
+/**
+ * @brief Get the number of reserved but not yet released slots
+ * @param[in] p_ring the ring
+ * @return the approximate queue depth
+ */
+size_t LOGRING_Depth(struct LOGRING_S* const p_ring);
+
+/* ----------------------------------------------------------------------
+ * exported variables declaration section
+ * ----------------------------------------------------------------------*/
+
+#endif /* if !defined(LOGRING_H_INCLUDE)*/
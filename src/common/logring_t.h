@@ -0,0 +1,60 @@
+#if !defined (LOGRING_T_H_INCLUDE)
+#define LOGRING_T_H_INCLUDE
+/**
+ * @file logring_t.h
+ * @brief interface type declarations for the bounded lock-free log record ring
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* ----------------------------------------------------------------------
+ * macro declaration section
+ * ----------------------------------------------------------------------*/
+
+#define LOGRING_CACHE_LINE   (64)  /**< Assumed cache line size (bytes) */
+#define LOGRING_PAYLOAD_SIZE (488) /**< Max record payload per slot (bytes) */
+
+/* ----------------------------------------------------------------------
+ * type declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief One record slot of the ring
+ * @details
+ * seq is the slot sequence number (D. Vyukov's bounded queue): it equals
+ * the enqueue position when the slot is free, position + 1 when a record
+ * is committed and position + capacity once the record is released.
+ */
+struct LOGRING_SLOT_S {
+	atomic_size_t seq;                      /**< Slot sequence number */
+	size_t pos;                             /**< Position claimed by the current owner */
+	uint32_t len;                           /**< Number of payload bytes in use */
+	uint32_t tag;                           /**< Free to use by the record owner */
+	uint8_t payload[LOGRING_PAYLOAD_SIZE];  /**< The record bytes */
+};
+
+/**
+ * @brief A bounded multi-producer ring of fixed-size record slots
+ */
+struct LOGRING_S {
+	struct LOGRING_SLOT_S* p_slots;                         /**< The slot array */
+	size_t mask;                                            /**< capacity - 1 */
+	_Alignas(LOGRING_CACHE_LINE) atomic_size_t enqueue_pos; /**< Next position to reserve */
+	_Alignas(LOGRING_CACHE_LINE) atomic_size_t dequeue_pos; /**< Next position to acquire */
+};
+
+#endif /* if !defined(LOGRING_T_H_INCLUDE) */
@@ -0,0 +1,544 @@
+/**
+ * @file logsink.c
+ * @brief implementation of the log output sinks
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * The lines are rendered once, by the caller of LOGSINK_Write; a sink only
+ * selects the lines of its levels. Adjacent selected lines are merged into
+ * one iovec entry, so a sink taking every level writes whole chunks.
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <syslog.h>
+#include <unistd.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+#include "logfile.h"
+#include "logflight.h"
+
+/* component include */
+#include "logsink.h"
+
+/* ----------------------------------------------------------------------
+ * internal macro declaration section
+ * ----------------------------------------------------------------------*/
+
+/** Number of syslog priority prefixes: the levels, unknown */
+#define LOGSINK_PRI_COUNT (7)
+
+/** Max datagrams per sendmmsg */
+#define LOGSINK_MSG_MAX (LOGSINK_IOV_MAX / 2)
+
+/* ----------------------------------------------------------------------
+ * internal type declaration section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * function with internal linkage (static) declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Find the next run of consecutive lines of the sink's levels
+ * @param[in] p_sink the sink
+ * @param[in] p_chunk the lines
+ * @param[in, out] p_first the line to start from, then the first line of
+ * the run
+ * @return the number of lines of the run, 0 if none is left
+ */
+static uint32_t LOGSINK_NextRun(const struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunk, uint32_t* const p_first);
+
+/**
+ * @brief Collect the lines of the sink's levels in iovec entries
+ * @param[in, out] p_sink the sink
+ * @param[in] p_chunks the lines
+ * @param[in] count the number of chunks
+ * @param[in] p_emit writes the collected entries, called per LOGSINK_IOV_MAX
+ */
+static void LOGSINK_Gather(
+		struct LOGSINK_S* const p_sink,
+		const struct LOGSINK_CHUNK_S* const p_chunks,
+		const int count,
+		void (*p_emit)(struct LOGSINK_S* const p_sink, struct iovec* const p_iov, const int count));
+
+/**
+ * @brief Write iovec entries completely (partial writes, EINTR)
+ * @param[in] fd the file descriptor
+ * @param[in, out] p_iov the entries, consumed
+ * @param[in] count the number of entries
+ */
+static void LOGSINK_WriteFd(const int fd, struct iovec* p_iov, int count);
+
+/**
+ * @brief p_write of the console sink
+ */
+static uint32_t LOGSINK_ConsoleWrite(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count);
+
+/**
+ * @brief Emitter of the console sink
+ */
+static void LOGSINK_ConsoleEmit(struct LOGSINK_S* const p_sink, struct iovec* const p_iov, const int count);
+
+/**
+ * @brief p_write of the file sink
+ */
+static uint32_t LOGSINK_FileWrite(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count);
+
+/**
+ * @brief p_flush of the file sink
+ */
+static void LOGSINK_FileFlush(struct LOGSINK_S* const p_sink);
+
+/**
+ * @brief p_close of the file sink
+ */
+static void LOGSINK_FileClose(struct LOGSINK_S* const p_sink);
+
+/**
+ * @brief p_write of the socket sink
+ */
+static uint32_t LOGSINK_SocketWrite(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count);
+
+/**
+ * @brief Send datagrams without blocking
+ * @param[in] fd the socket
+ * @param[in] p_msgs the datagrams
+ * @param[in] count the number of datagrams
+ * @return the number of datagrams lost
+ */
+static uint32_t LOGSINK_SocketSend(const int fd, struct mmsghdr* const p_msgs, const int count);
+
+/**
+ * @brief p_close of the socket sink
+ */
+static void LOGSINK_SocketClose(struct LOGSINK_S* const p_sink);
+
+/**
+ * @brief p_write of the memory sink
+ */
+static uint32_t LOGSINK_MemoryWrite(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count);
+
+/**
+ * @brief p_close of the memory sink
+ */
+static void LOGSINK_MemoryClose(struct LOGSINK_S* const p_sink);
+
+/* ----------------------------------------------------------------------
+ * variable with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief The syslog priority (LOG_USER | severity) per level bit, unknown last
+ */
+static const char* const LOGSINK_pri[LOGSINK_PRI_COUNT] = {
+	"<14>", /* INFO: LOG_INFO */
+	"<15>", /* DEBUG: LOG_DEBUG */
+	"<12>", /* WARNING: LOG_WARNING */
+	"<11>", /* ERROR: LOG_ERR */
+	"<10>", /* CRITICAL: LOG_CRIT */
+	"<15>", /* TEST: LOG_DEBUG */
+	"<13>"  /* unknown: LOG_NOTICE */
+};
+
+/* ----------------------------------------------------------------------
+ * exported variable definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported function definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+void LOGSINK_OpenConsole(struct LOGSINK_S* const p_sink, const int fd, const uint64_t levels)
+{
+	memset(p_sink, 0, sizeof(*p_sink));
+	p_sink->name = "console";
+	p_sink->levels = levels;
+	p_sink->p_write = LOGSINK_ConsoleWrite;
+	p_sink->fd = fd;
+}
+
+/* ----------------------------------------------------------------------*/
+bool LOGSINK_OpenFile(struct LOGSINK_S* const p_sink, const struct LOGFILE_CONFIG_S* const p_config, const uint64_t levels)
+{
+	bool rv;
+
+	memset(p_sink, 0, sizeof(*p_sink));
+	p_sink->fd = -1;
+	rv = LOGFILE_Open(&p_sink->file, p_config);
+
+	if (rv) {
+		p_sink->name = "file";
+		p_sink->levels = levels;
+		p_sink->p_write = LOGSINK_FileWrite;
+		p_sink->p_flush = LOGSINK_FileFlush;
+		p_sink->p_close = LOGSINK_FileClose;
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+bool LOGSINK_OpenSocket(struct LOGSINK_S* const p_sink, const char* const path, const uint64_t levels)
+{
+	static const char* fn = "LOGSINK_OpenSocket";
+	struct sockaddr_un addr;
+	bool rv = false;
+
+	memset(p_sink, 0, sizeof(*p_sink));
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+
+	if (sizeof(addr.sun_path) <= strlen(path)) {
+		printf("%s: [ERROR] Socket path too long:%s\n", fn, path);
+	} else {
+		strcpy(addr.sun_path, path);
+
+		if (0 > (p_sink->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0))) {
+			printf("%s: [ERROR] Couldn't create socket:%s\n", fn, strerror(errno));
+		} else if (0 > connect(p_sink->fd, (struct sockaddr*)&addr, sizeof(addr))) {
+			printf("%s: [ERROR] Couldn't connect to %s:%s\n", fn, path, strerror(errno));
+			close(p_sink->fd);
+		} else {
+			p_sink->name = "socket";
+			p_sink->levels = levels;
+			p_sink->p_write = LOGSINK_SocketWrite;
+			p_sink->p_close = LOGSINK_SocketClose;
+			rv = true;
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+bool LOGSINK_OpenMemory(struct LOGSINK_S* const p_sink, const uint32_t records, const uint64_t levels)
+{
+	size_t capacity = 2;
+	bool rv;
+
+	memset(p_sink, 0, sizeof(*p_sink));
+	p_sink->fd = -1;
+
+	while (capacity < records) {
+		capacity <<= 1;
+	}
+	rv = LOGFLIGHT_Create(&p_sink->ring, capacity);
+
+	if (rv) {
+		p_sink->name = "memory";
+		p_sink->levels = levels;
+		p_sink->p_write = LOGSINK_MemoryWrite;
+		p_sink->p_close = LOGSINK_MemoryClose;
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+uint32_t LOGSINK_Write(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count)
+{
+	uint32_t rv = 0;
+
+	if ((NULL != p_sink->p_write) && (0 != p_sink->levels)) {
+		rv = p_sink->p_write(p_sink, p_chunks, count);
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGSINK_Flush(struct LOGSINK_S* const p_sink)
+{
+	if (NULL != p_sink->p_flush) {
+		p_sink->p_flush(p_sink);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGSINK_Close(struct LOGSINK_S* const p_sink)
+{
+	if (NULL != p_sink->p_close) {
+		p_sink->p_close(p_sink);
+	}
+	p_sink->p_write = NULL;
+	p_sink->p_flush = NULL;
+	p_sink->p_close = NULL;
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGSINK_DumpMemory(struct LOGSINK_S* const p_sink, const int fd)
+{
+	if (LOGSINK_MemoryWrite == p_sink->p_write) {
+		LOGFLIGHT_Dump(&p_sink->ring, fd);
+	}
+}
+
+/* ----------------------------------------------------------------------
+ * functions with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+static uint32_t LOGSINK_NextRun(const struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunk, uint32_t* const p_first)
+{
+	uint32_t i = *p_first;
+	uint32_t rv = 0;
+
+	while ((i < p_chunk->n_lines) && (0 == (p_chunk->p_lines[i].level & p_sink->levels))) {
+		i++;
+	}
+	if (i < p_chunk->n_lines) {
+		*p_first = i;
+		/* all of them in the common case */
+		if (0 == (p_chunk->levels & ~p_sink->levels)) {
+			i = p_chunk->n_lines - 1;
+		} else {
+			while ((i + 1 < p_chunk->n_lines) && (0 != (p_chunk->p_lines[i + 1].level & p_sink->levels))) {
+				i++;
+			}
+		}
+		rv = i + 1 - *p_first;
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGSINK_Gather(
+		struct LOGSINK_S* const p_sink,
+		const struct LOGSINK_CHUNK_S* const p_chunks,
+		const int count,
+		void (*p_emit)(struct LOGSINK_S* const p_sink, struct iovec* const p_iov, const int count))
+{
+	struct iovec iov[LOGSINK_IOV_MAX];
+	const struct LOGSINK_CHUNK_S* p_chunk;
+	const char* text;
+	size_t len;
+	uint32_t first;
+	uint32_t lines;
+	int n = 0;
+	int c;
+
+	for (c = 0; c < count; c++) {
+		p_chunk = &p_chunks[c];
+
+		for (first = 0; 0 < (lines = LOGSINK_NextRun(p_sink, p_chunk, &first)); first += lines) {
+			text = p_chunk->text + ((0 == first) ? 0 : p_chunk->p_lines[first - 1].end);
+			len = p_chunk->p_lines[first + lines - 1].end - (text - p_chunk->text);
+
+			if (LOGSINK_IOV_MAX == n) {
+				p_emit(p_sink, iov, n);
+				n = 0;
+			}
+			iov[n].iov_base = (void*)text;
+			iov[n].iov_len = len;
+			n++;
+		}
+	}
+	if (0 < n) {
+		p_emit(p_sink, iov, n);
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGSINK_WriteFd(const int fd, struct iovec* p_iov, int count)
+{
+	ssize_t written;
+
+	while (0 < count) {
+		written = writev(fd, p_iov, count);
+
+		if (0 > written) {
+			if (EINTR != errno) {
+				break;
+			}
+		} else {
+			/* skip what the (partial) write consumed */
+			while ((0 < count) && ((size_t)written >= p_iov->iov_len)) {
+				written -= p_iov->iov_len;
+				p_iov++;
+				count--;
+			}
+			if (0 < count) {
+				p_iov->iov_base = (char*)p_iov->iov_base + written;
+				p_iov->iov_len -= written;
+			}
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------*/
+static uint32_t LOGSINK_ConsoleWrite(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count)
+{
+	LOGSINK_Gather(p_sink, p_chunks, count, LOGSINK_ConsoleEmit);
+	return 0;
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGSINK_ConsoleEmit(struct LOGSINK_S* const p_sink, struct iovec* const p_iov, const int count)
+{
+	LOGSINK_WriteFd(p_sink->fd, p_iov, count);
+}
+
+/* ----------------------------------------------------------------------*/
+static uint32_t LOGSINK_FileWrite(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count)
+{
+	const struct LOGSINK_CHUNK_S* p_chunk;
+	struct iovec iov;
+	size_t start;
+	size_t base;
+	uint32_t first;
+	uint32_t lines;
+	uint32_t i;
+	int c;
+
+	for (c = 0; c < count; c++) {
+		p_chunk = &p_chunks[c];
+
+		/* one append per run: a run never straddles two segments */
+		for (first = 0; 0 < (lines = LOGSINK_NextRun(p_sink, p_chunk, &first)); first += lines) {
+			start = (0 == first) ? 0 : p_chunk->p_lines[first - 1].end;
+			iov.iov_base = (void*)(p_chunk->text + start);
+			iov.iov_len = p_chunk->p_lines[first + lines - 1].end - start;
+
+			if (!LOGFILE_Append(&p_sink->file, iov.iov_base, iov.iov_len)) {
+				/* don't lose the lines: fall back to the console */
+				LOGSINK_WriteFd(STDOUT_FILENO, &iov, 1);
+			} else if ((NULL != p_sink->file.p_index) && (iov.iov_len <= p_sink->file.config.segment_size)) {
+				/* the segment offset of the chunk text (the run isn't cut) */
+				base = p_sink->file.offset - iov.iov_len - start;
+
+				for (i = first; i < first + lines; i++, start = p_chunk->p_lines[i - 1].end) {
+					LOGFILE_IndexLine(&p_sink->file, base + start, p_chunk->text + start,
+							p_chunk->p_lines[i].end - start, p_chunk->p_lines[i].level);
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGSINK_FileFlush(struct LOGSINK_S* const p_sink)
+{
+	LOGFILE_Flush(&p_sink->file);
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGSINK_FileClose(struct LOGSINK_S* const p_sink)
+{
+	LOGFILE_Close(&p_sink->file);
+}
+
+/* ----------------------------------------------------------------------*/
+static uint32_t LOGSINK_SocketWrite(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count)
+{
+	struct mmsghdr msgs[LOGSINK_MSG_MAX];
+	struct iovec iov[LOGSINK_MSG_MAX][2];
+	const struct LOGSINK_CHUNK_S* p_chunk;
+	const struct LOGSINK_LINE_S* p_line;
+	uint32_t start;
+	uint32_t lost = 0;
+	uint32_t i;
+	size_t pri;
+	int n = 0;
+	int c;
+
+	memset(msgs, 0, sizeof(msgs));
+
+	for (c = 0; c < count; c++) {
+		p_chunk = &p_chunks[c];
+
+		for (i = 0, start = 0; i < p_chunk->n_lines; start = p_chunk->p_lines[i].end, i++) {
+			p_line = &p_chunk->p_lines[i];
+			if ((0 == (p_line->level & p_sink->levels)) || (p_line->end - start < 2)) {
+				continue;
+			}
+
+			pri = (LOGSINK_LEVEL_ANY == p_line->level) ? LOGSINK_PRI_COUNT - 1 : (size_t)__builtin_ctz(p_line->level);
+			if (LOGSINK_PRI_COUNT <= pri) {
+				pri = LOGSINK_PRI_COUNT - 1;
+			}
+
+			/* one datagram per line, without its '\n' */
+			iov[n][0].iov_base = (void*)LOGSINK_pri[pri];
+			iov[n][0].iov_len = strlen(LOGSINK_pri[pri]);
+			iov[n][1].iov_base = (void*)(p_chunk->text + start);
+			iov[n][1].iov_len = p_line->end - start - 1;
+			msgs[n].msg_hdr.msg_iov = iov[n];
+			msgs[n].msg_hdr.msg_iovlen = 2;
+			n++;
+
+			if (LOGSINK_MSG_MAX == n) {
+				lost += LOGSINK_SocketSend(p_sink->fd, msgs, n);
+				n = 0;
+			}
+		}
+	}
+	if (0 < n) {
+		lost += LOGSINK_SocketSend(p_sink->fd, msgs, n);
+	}
+	return lost;
+}
+
+/* ----------------------------------------------------------------------*/
+static uint32_t LOGSINK_SocketSend(const int fd, struct mmsghdr* const p_msgs, const int count)
+{
+	int sent = 0;
+	int res;
+
+	while (sent < count) {
+		res = sendmmsg(fd, p_msgs + sent, count - sent, MSG_DONTWAIT);
+
+		if (0 < res) {
+			sent += res;
+		} else if ((0 > res) && (EINTR == errno)) {
+			;
+		} else {
+			/* the collector is busy or gone: never wait for it */
+			break;
+		}
+	}
+	return count - sent;
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGSINK_SocketClose(struct LOGSINK_S* const p_sink)
+{
+	close(p_sink->fd);
+	p_sink->fd = -1;
+}
+
+/* ----------------------------------------------------------------------*/
+static uint32_t LOGSINK_MemoryWrite(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count)
+{
+	const struct LOGSINK_CHUNK_S* p_chunk;
+	uint32_t start;
+	uint32_t i;
+	int c;
+
+	for (c = 0; c < count; c++) {
+		p_chunk = &p_chunks[c];
+
+		for (i = 0, start = 0; i < p_chunk->n_lines; start = p_chunk->p_lines[i].end, i++) {
+			if (0 != (p_chunk->p_lines[i].level & p_sink->levels)) {
+				LOGFLIGHT_Record(&p_sink->ring, p_chunk->text + start, p_chunk->p_lines[i].end - start);
+			}
+		}
+	}
+	return 0;
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGSINK_MemoryClose(struct LOGSINK_S* const p_sink)
+{
+	LOGFLIGHT_Destroy(&p_sink->ring);
+}
@@ -0,0 +1,99 @@
+#if !defined (LOGSINK_H_INCLUDE)
+#define LOGSINK_H_INCLUDE
+/**
+ * @file logsink.h
+ * @brief functional interface declarations for the log output sinks
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdbool.h>
+#include <stddef.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logsink_t.h"
+
+/* ----------------------------------------------------------------------
+ * function declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Set up a sink writing to a file descriptor with writev
+ * @param[out] p_sink the sink
+ * @param[in] fd the file descriptor (stays open on close)
+ * @param[in] levels the LOGLV_xxx bits of the lines taken
+ */
+void LOGSINK_OpenConsole(struct LOGSINK_S* const p_sink, const int fd, const uint64_t levels);
+
+/**
+ * @brief Set up a sink appending to a memory-mapped, rotating log file
+ * @param[out] p_sink the sink
+ * @param[in] p_config the log file settings
+ * @param[in] levels the LOGLV_xxx bits of the lines taken
+ * @return true on success, false otherwise
+ * @details
+ * Lines the file can't take are written to the standard output instead.
+ */
+bool LOGSINK_OpenFile(struct LOGSINK_S* const p_sink, const struct LOGFILE_CONFIG_S* const p_config, const uint64_t levels);
+
+/**
+ * @brief Set up a sink sending one datagram per line to a UNIX-domain
+ * socket, syslog style ("<PRI>" + line, facility LOG_USER)
+ * @param[out] p_sink the sink
+ * @param[in] path the socket path, e.g. /dev/log
+ * @param[in] levels the LOGLV_xxx bits of the lines taken
+ * @return true on success, false otherwise
+ * @details
+ * Datagrams are sent in batches (sendmmsg) without blocking; the lines a
+ * busy collector doesn't take are lost and counted.
+ */
+bool LOGSINK_OpenSocket(struct LOGSINK_S* const p_sink, const char* const path, const uint64_t levels);
+
+/**
+ * @brief Set up a sink keeping the most recent lines in memory
+ * @param[out] p_sink the sink
+ * @param[in] records the number of lines kept (rounded up to a power of two)
+ * @param[in] levels the LOGLV_xxx bits of the lines taken
+ * @return true on success, false otherwise
+ */
+bool LOGSINK_OpenMemory(struct LOGSINK_S* const p_sink, const uint32_t records, const uint64_t levels);
+
+/**
+ * @brief Write the lines of the sink's levels
+ * @param[in, out] p_sink the sink
+ * @param[in] p_chunks the lines
+ * @param[in] count the number of chunks
+ * @return the number of lines lost
+ */
+uint32_t LOGSINK_Write(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count);
+
+/**
+ * @brief Push the written lines out
+ * @param[in, out] p_sink the sink
+ */
+void LOGSINK_Flush(struct LOGSINK_S* const p_sink);
+
+/**
+ * @brief Release the resources of a sink
+ * @param[in, out] p_sink the sink
+ */
+void LOGSINK_Close(struct LOGSINK_S* const p_sink);
+
+/**
+ * @brief Write the lines kept by a memory sink, oldest first
+ * @param[in] p_sink the memory sink
+ * @param[in] fd the file descriptor to write to
+ */
+void LOGSINK_DumpMemory(struct LOGSINK_S* const p_sink, const int fd);
+
+#endif /* if !defined(LOGSINK_H_INCLUDE) */
@@ -0,0 +1,74 @@
+#if !defined (LOGSINK_T_H_INCLUDE)
+#define LOGSINK_T_H_INCLUDE
+/**
+ * @file logsink_t.h
+ * @brief interface type declarations for the log output sinks
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdint.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+#include "logfile_t.h"
+#include "logflight_t.h"
+
+/* ----------------------------------------------------------------------
+ * macro declaration section
+ * ----------------------------------------------------------------------*/
+
+#define LOGSINK_LEVEL_ANY (0xFFFF) /**< Line level taken by every sink */
+#define LOGSINK_IOV_MAX   (256)    /**< Max iovec entries per write */
+
+/* ----------------------------------------------------------------------
+ * type declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Where a rendered line ends and which level it has
+ */
+struct LOGSINK_LINE_S {
+	uint16_t end;    /**< Offset just past the line's '\n' */
+	uint16_t level;  /**< The LOGLV_xxx level, LOGSINK_LEVEL_ANY if unknown */
+};
+
+/**
+ * @brief Consecutive rendered lines, shared by all sinks
+ */
+struct LOGSINK_CHUNK_S {
+	const char* text;                     /**< The lines */
+	const struct LOGSINK_LINE_S* p_lines; /**< Their ends and levels */
+	uint32_t n_lines;                     /**< Number of lines */
+	uint64_t levels;                      /**< All levels of the lines or'ed */
+};
+
+/**
+ * @brief A log output
+ * @details
+ * A sink only sees the lines of its levels. Beyond the ones of logsink.h,
+ * a sink is anything that fills in p_write (p_flush and p_close are
+ * optional).
+ */
+struct LOGSINK_S {
+	const char* name;   /**< For the messages */
+	uint64_t levels;    /**< LOGLV_xxx bits of the lines taken, 0 for none */
+	/** Write the lines of the sink's levels, return the number lost */
+	uint32_t (*p_write)(struct LOGSINK_S* const p_sink, const struct LOGSINK_CHUNK_S* const p_chunks, const int count);
+	/** Push the written lines out, NULL if nothing to do */
+	void (*p_flush)(struct LOGSINK_S* const p_sink);
+	/** Release the resources, NULL if none */
+	void (*p_close)(struct LOGSINK_S* const p_sink);
+	int fd;                   /**< Console and socket: the file descriptor */
+	struct LOGFILE_S file;    /**< File: the memory-mapped log file */
+	struct LOGFLIGHT_S ring;  /**< Memory: the most recent lines */
+};
+
+#endif /* if !defined(LOGSINK_T_H_INCLUDE) */
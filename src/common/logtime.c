@@ -0,0 +1,169 @@
+/**
+ * @file logtime.c
+ * @brief implementation of the log timestamps
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <ctype.h>
+#include <string.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logtime.h"
+
+/* ----------------------------------------------------------------------
+ * internal macro declaration section
+ * ----------------------------------------------------------------------*/
+
+/** Length of the cached "YYYY-MM-DD HH:MM:SS" part */
+#define LOGTIME_SEC_STR_LEN (19)
+
+/* ----------------------------------------------------------------------
+ * internal type declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief The per-thread rendering of the last second seen
+ */
+struct LOGTIME_CACHE_S {
+	time_t sec;                           /**< The cached second, -1 if none */
+	char text[LOGTIME_SEC_STR_LEN + 1];   /**< Its rendering */
+};
+
+/* ----------------------------------------------------------------------
+ * function with internal linkage (static) declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Read a number of digits
+ * @param[in] text the digits
+ * @param[in] count the number of digits
+ * @return the number, -1 if a character isn't a digit
+ */
+static int LOGTIME_Digits(const char* const text, const int count);
+
+/* ----------------------------------------------------------------------
+ * variable with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+static __thread struct LOGTIME_CACHE_S LOGTIME_cache = { -1, "" };
+
+/** The last second read back by LOGTIME_Parse */
+static __thread struct LOGTIME_CACHE_S LOGTIME_parse_cache = { -1, "" };
+
+/* ----------------------------------------------------------------------
+ * exported variable definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported function definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+void LOGTIME_Now(struct timespec* const p_ts)
+{
+	clock_gettime(LOGTIME_CLOCKID, p_ts);
+}
+
+/* ----------------------------------------------------------------------*/
+size_t LOGTIME_Format(char* const buf, const size_t size, const struct timespec* const p_ts)
+{
+	struct LOGTIME_CACHE_S* p_cache = &LOGTIME_cache;
+	char text[LOGTIME_STR_LEN + 1];
+	struct tm broken_time;
+	unsigned ms;
+	size_t len = 0;
+
+	if (p_ts->tv_sec != p_cache->sec) {
+		if ((NULL == localtime_r(&p_ts->tv_sec, &broken_time))
+				|| (LOGTIME_SEC_STR_LEN != strftime(p_cache->text, sizeof(p_cache->text), "%Y-%m-%d %H:%M:%S", &broken_time))) {
+			memset(p_cache->text, '?', LOGTIME_SEC_STR_LEN);
+			p_cache->text[LOGTIME_SEC_STR_LEN] = '\0';
+		}
+		p_cache->sec = p_ts->tv_sec;
+	}
+
+	ms = (unsigned)(p_ts->tv_nsec / 1000000) % 1000;
+	memcpy(text, p_cache->text, LOGTIME_SEC_STR_LEN);
+	text[LOGTIME_SEC_STR_LEN]     = '.';
+	text[LOGTIME_SEC_STR_LEN + 1] = '0' + ms / 100;
+	text[LOGTIME_SEC_STR_LEN + 2] = '0' + (ms / 10) % 10;
+	text[LOGTIME_SEC_STR_LEN + 3] = '0' + ms % 10;
+
+	if (0 < size) {
+		len = (LOGTIME_STR_LEN < size - 1) ? LOGTIME_STR_LEN : size - 1;
+		memcpy(buf, text, len);
+		buf[len] = '\0';
+	}
+	return len;
+}
+
+/* ----------------------------------------------------------------------*/
+size_t LOGTIME_Parse(const char* const text, const size_t len, int64_t* const p_ms)
+{
+	struct LOGTIME_CACHE_S* p_cache = &LOGTIME_parse_cache;
+	struct tm broken_time;
+	int ms = 0;
+	size_t rv = 0;
+
+	if (LOGTIME_SEC_STR_LEN > len) {
+		/* no timestamp */
+	} else if ((0 <= p_cache->sec) && (0 == memcmp(text, p_cache->text, LOGTIME_SEC_STR_LEN))) {
+		rv = LOGTIME_SEC_STR_LEN;
+	} else if (('-' == text[4]) && ('-' == text[7]) && (' ' == text[10]) && (':' == text[13]) && (':' == text[16])) {
+		memset(&broken_time, 0, sizeof(broken_time));
+		broken_time.tm_year = LOGTIME_Digits(text, 4) - 1900;
+		broken_time.tm_mon = LOGTIME_Digits(text + 5, 2) - 1;
+		broken_time.tm_mday = LOGTIME_Digits(text + 8, 2);
+		broken_time.tm_hour = LOGTIME_Digits(text + 11, 2);
+		broken_time.tm_min = LOGTIME_Digits(text + 14, 2);
+		broken_time.tm_sec = LOGTIME_Digits(text + 17, 2);
+		broken_time.tm_isdst = -1;
+
+		if ((0 <= broken_time.tm_year) && (0 <= broken_time.tm_mon) && (0 <= broken_time.tm_mday)
+				&& (0 <= broken_time.tm_hour) && (0 <= broken_time.tm_min) && (0 <= broken_time.tm_sec)
+				&& ((time_t)-1 != (p_cache->sec = mktime(&broken_time)))) {
+			memcpy(p_cache->text, text, LOGTIME_SEC_STR_LEN);
+			rv = LOGTIME_SEC_STR_LEN;
+		} else {
+			p_cache->sec = -1;
+		}
+	}
+
+	if (0 < rv) {
+		if ((LOGTIME_STR_LEN <= len) && ('.' == text[LOGTIME_SEC_STR_LEN])
+				&& (0 <= (ms = LOGTIME_Digits(text + LOGTIME_SEC_STR_LEN + 1, 3)))) {
+			rv = LOGTIME_STR_LEN;
+		} else {
+			ms = 0;
+		}
+		*p_ms = (int64_t)p_cache->sec * 1000 + ms;
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------
+ * functions with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+static int LOGTIME_Digits(const char* const text, const int count)
+{
+	int rv = 0;
+	int i;
+
+	for (i = 0; (i < count) && (0 <= rv); i++) {
+		rv = isdigit((unsigned char)text[i]) ? rv * 10 + (text[i] - '0') : -1;
+	}
+	return rv;
+}
@@ -0,0 +1,66 @@
+#if !defined (LOGTIME_H_INCLUDE)
+#define LOGTIME_H_INCLUDE
+/**
+ * @file logtime.h
+ * @brief functional interface declarations for the log timestamps
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stddef.h>
+#include <stdint.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logtime_t.h"
+
+/* ----------------------------------------------------------------------
+ * function declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Read the log clock
+ * @param[out] p_ts the current time
+ * @pre[untested] p_ts must not be null
+ */
+void LOGTIME_Now(struct timespec* const p_ts);
+
+/**
+ * @brief Format a timestamp as "YYYY-MM-DD HH:MM:SS.mmm" (local time)
+ * @param[out] buf the text buffer
+ * @param[in] size the size of buf
+ * @param[in] p_ts the timestamp
+ * @pre[untested] buf and p_ts must not be null
+ * @return the number of characters written (excluding the null byte)
+ * @details
+ * The date and time part is cached per thread and only re-rendered when
+ * the second changes.
+ */
+size_t LOGTIME_Format(char* const buf, const size_t size, const struct timespec* const p_ts);
+
+/**
+ * @brief Read back a timestamp of LOGTIME_Format
+ * @param[in] text "YYYY-MM-DD HH:MM:SS", optionally followed by ".mmm"
+ * @param[in] len the number of characters available
+ * @param[out] p_ms the time in ms since the epoch
+ * @pre[untested] text and p_ms must not be null
+ * @return the number of characters read, 0 if text holds no timestamp
+ * @details
+ * Like for LOGTIME_Format, the date and time part is cached per thread.
+ */
+size_t LOGTIME_Parse(const char* const text, const size_t len, int64_t* const p_ms);
+
+/* ----------------------------------------------------------------------
+ * exported variables declaration section
+ * ----------------------------------------------------------------------*/
+
+#endif /* if !defined(LOGTIME_H_INCLUDE)*/
@@ -0,0 +1,46 @@
+#if !defined (LOGTIME_T_H_INCLUDE)
+#define LOGTIME_T_H_INCLUDE
+/**
+ * @file logtime_t.h
+ * @brief interface type declarations for the log timestamps
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <time.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* ----------------------------------------------------------------------
+ * macro declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief The clock source of the log timestamps
+ * @details
+ * CLOCK_REALTIME is served by the vDSO (no system call). Build with
+ * -DLOGTIME_COARSE to use CLOCK_REALTIME_COARSE instead: cheaper to read,
+ * but the milliseconds then only advance per kernel tick (1..10 ms).
+ */
+#if defined(LOGTIME_COARSE) && defined(CLOCK_REALTIME_COARSE)
+#define LOGTIME_CLOCKID CLOCK_REALTIME_COARSE
+#else
+#define LOGTIME_CLOCKID CLOCK_REALTIME
+#endif
+
+/** Length of a formatted timestamp "YYYY-MM-DD HH:MM:SS.mmm" */
+#define LOGTIME_STR_LEN (23)
+
+/* ----------------------------------------------------------------------
+ * type declaration section
+ * ----------------------------------------------------------------------*/
+
+#endif /* if !defined(LOGTIME_T_H_INCLUDE) */
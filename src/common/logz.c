@@ -0,0 +1,424 @@
+/**
+ * @file logz.c
+ * @brief implementation of the LZ log segment codec
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * An LZ77 block codec in the LZ4 sequence format: a token (literal count,
+ * match length - 4), the literals, a 16-bit match offset, with counts of
+ * 15 and more continued in 255-steps. Log lines repeat their timestamps,
+ * levels, function names and formats, which a 64 KiB window catches; the
+ * match finder follows hash chains and looks one position ahead before
+ * taking a match. Decompression is a plain copy loop.
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logz.h"
+
+/* ----------------------------------------------------------------------
+ * internal macro declaration section
+ * ----------------------------------------------------------------------*/
+
+#define LOGZ_MIN_MATCH  (4)      /**< Shortest match encoded */
+#define LOGZ_MAX_OFFSET (65535)  /**< Window size */
+#define LOGZ_MAX_CHAIN  (32)     /**< Candidates tried per position */
+#define LOGZ_NICE_MATCH (128)    /**< Match length ending the search */
+#define LOGZ_RUN_MASK   (15)     /**< Token nibble continued in 255-steps */
+
+/* ----------------------------------------------------------------------
+ * internal type declaration section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * function with internal linkage (static) declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief The hash of the 4 bytes at a position
+ * @param[in] p_src the bytes
+ * @return the index in the hash table
+ */
+static uint32_t LOGZ_Hash(const uint8_t* const p_src);
+
+/**
+ * @brief Find the longest match of a position in the window
+ * @param[in] p_z the compressor
+ * @param[in] p_src the block
+ * @param[in] pos the position
+ * @param[in] len the block length
+ * @param[out] p_offset the distance back to the match
+ * @return the match length, less than LOGZ_MIN_MATCH if none
+ */
+static size_t LOGZ_FindMatch(
+		const struct LOGZ_S* const p_z,
+		const uint8_t* const p_src,
+		const size_t pos,
+		const size_t len,
+		size_t* const p_offset);
+
+/**
+ * @brief Add a position to the hash chains
+ * @param[in, out] p_z the compressor
+ * @param[in] p_src the block
+ * @param[in] pos the position, at least LOGZ_MIN_MATCH bytes before the end
+ */
+static void LOGZ_Insert(struct LOGZ_S* const p_z, const uint8_t* const p_src, const size_t pos);
+
+/**
+ * @brief Write a count continued in 255-steps
+ * @param[out] p_dst the output
+ * @param[in] count the count beyond LOGZ_RUN_MASK
+ * @return the position after the count
+ */
+static uint8_t* LOGZ_PutCount(uint8_t* p_dst, size_t count);
+
+/**
+ * @brief Write one sequence: literals, then a match unless at the end
+ * @param[out] p_dst the output
+ * @param[in] p_lit the literals
+ * @param[in] n_lit the number of literals
+ * @param[in] offset the match distance
+ * @param[in] match the match length, 0 for the last sequence
+ * @return the position after the sequence
+ */
+static uint8_t* LOGZ_PutSequence(uint8_t* p_dst, const uint8_t* const p_lit, const size_t n_lit,
+		const size_t offset, const size_t match);
+
+/* ----------------------------------------------------------------------
+ * variable with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported variable definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported function definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+bool LOGZ_Create(struct LOGZ_S* const p_z)
+{
+	bool rv = false;
+
+	p_z->p_head = malloc(sizeof(*p_z->p_head) << LOGZ_HASH_BITS);
+	p_z->p_prev = malloc(sizeof(*p_z->p_prev) * LOGZ_BLOCK_SIZE);
+	p_z->p_raw = malloc(LOGZ_BLOCK_SIZE);
+	p_z->p_packed = malloc(LOGZ_BOUND(LOGZ_BLOCK_SIZE));
+
+	if ((NULL == p_z->p_head) || (NULL == p_z->p_prev) || (NULL == p_z->p_raw) || (NULL == p_z->p_packed)) {
+		LOGZ_Destroy(p_z);
+	} else {
+		rv = true;
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+void LOGZ_Destroy(struct LOGZ_S* const p_z)
+{
+	free(p_z->p_head);
+	free(p_z->p_prev);
+	free(p_z->p_raw);
+	free(p_z->p_packed);
+	memset(p_z, 0, sizeof(*p_z));
+}
+
+/* ----------------------------------------------------------------------*/
+size_t LOGZ_CompressBlock(struct LOGZ_S* const p_z, const uint8_t* const p_src, const size_t len, uint8_t* const p_dst)
+{
+	uint8_t* p_out = p_dst;
+	size_t anchor = 0;
+	size_t pos = 0;
+	size_t offset;
+	size_t next_offset;
+	size_t match;
+	size_t next;
+	size_t end;
+
+	memset(p_z->p_head, 0xFF, sizeof(*p_z->p_head) << LOGZ_HASH_BITS);
+
+	while (pos + LOGZ_MIN_MATCH <= len) {
+		match = LOGZ_FindMatch(p_z, p_src, pos, len, &offset);
+		LOGZ_Insert(p_z, p_src, pos);
+
+		if (LOGZ_MIN_MATCH > match) {
+			pos++;
+			continue;
+		}
+
+		/* lazy evaluation: a longer match one byte later wins */
+		if (pos + 1 + LOGZ_MIN_MATCH <= len) {
+			next = LOGZ_FindMatch(p_z, p_src, pos + 1, len, &next_offset);
+			if (next > match + 1) {
+				pos++;
+				LOGZ_Insert(p_z, p_src, pos);
+				match = next;
+				offset = next_offset;
+			}
+		}
+
+		p_out = LOGZ_PutSequence(p_out, p_src + anchor, pos - anchor, offset, match);
+
+		end = pos + match;
+		for (pos++; (pos < end) && (pos + LOGZ_MIN_MATCH <= len); pos++) {
+			LOGZ_Insert(p_z, p_src, pos);
+		}
+		pos = end;
+		anchor = end;
+	}
+	p_out = LOGZ_PutSequence(p_out, p_src + anchor, len - anchor, 0, 0);
+
+	return p_out - p_dst;
+}
+
+/* ----------------------------------------------------------------------*/
+bool LOGZ_DecompressBlock(const uint8_t* const p_src, const size_t len, uint8_t* const p_dst, const size_t raw_len)
+{
+	const uint8_t* p_in = p_src;
+	const uint8_t* const p_in_end = p_src + len;
+	uint8_t* p_out = p_dst;
+	uint8_t* const p_out_end = p_dst + raw_len;
+	const uint8_t* p_match;
+	size_t count;
+	size_t offset;
+	uint8_t token;
+	uint8_t step;
+	bool rv = true;
+
+	while (rv && (p_in < p_in_end)) {
+		token = *p_in++;
+
+		count = token >> 4;
+		if (LOGZ_RUN_MASK == count) {
+			do {
+				step = (p_in < p_in_end) ? *p_in : 0;
+				count += step;
+				p_in++;
+			} while ((255 == step) && (p_in < p_in_end));
+		}
+		if ((count > (size_t)(p_in_end - p_in)) || (count > (size_t)(p_out_end - p_out))) {
+			rv = false;
+			break;
+		}
+		memcpy(p_out, p_in, count);
+		p_in += count;
+		p_out += count;
+
+		if (p_in == p_in_end) {
+			/* the last sequence has no match */
+			break;
+		}
+
+		if (2 > p_in_end - p_in) {
+			rv = false;
+			break;
+		}
+		offset = p_in[0] | ((size_t)p_in[1] << 8);
+		p_in += 2;
+
+		count = (token & LOGZ_RUN_MASK) + LOGZ_MIN_MATCH;
+		if (LOGZ_RUN_MASK + LOGZ_MIN_MATCH == count) {
+			do {
+				step = (p_in < p_in_end) ? *p_in : 0;
+				count += step;
+				p_in++;
+			} while ((255 == step) && (p_in < p_in_end));
+		}
+		if ((0 == offset) || (offset > (size_t)(p_out - p_dst)) || (count > (size_t)(p_out_end - p_out))) {
+			rv = false;
+			break;
+		}
+		/* byte by byte: the match may overlap the bytes it produces */
+		for (p_match = p_out - offset; 0 < count; count--) {
+			*p_out++ = *p_match++;
+		}
+	}
+	return rv && (p_out == p_out_end);
+}
+
+/* ----------------------------------------------------------------------*/
+bool LOGZ_CompressFile(struct LOGZ_S* const p_z, const char* const src, const char* const dst)
+{
+	struct LOGZ_BLOCK_S block;
+	FILE* p_in = NULL;
+	FILE* p_out = NULL;
+	const uint8_t* p_data;
+	size_t got;
+	bool rv = false;
+
+	if (NULL == (p_in = fopen(src, "rb"))) {
+		printf("LOGZ_CompressFile: [ERROR] Couldn't open %s:%s\n", src, strerror(errno));
+	} else if (NULL == (p_out = fopen(dst, "wb"))) {
+		printf("LOGZ_CompressFile: [ERROR] Couldn't create %s:%s\n", dst, strerror(errno));
+	} else if (LOGZ_MAGIC_SIZE == fwrite(LOGZ_MAGIC, 1, LOGZ_MAGIC_SIZE, p_out)) {
+		rv = true;
+
+		while (rv && (0 < (got = fread(p_z->p_raw, 1, LOGZ_BLOCK_SIZE, p_in)))) {
+			block.raw_len = got;
+			block.packed_len = LOGZ_CompressBlock(p_z, p_z->p_raw, got, p_z->p_packed);
+			p_data = p_z->p_packed;
+
+			if (block.packed_len >= block.raw_len) {
+				/* incompressible: keep the bytes as they are */
+				block.packed_len = block.raw_len;
+				p_data = p_z->p_raw;
+			}
+			rv = (1 == fwrite(&block, sizeof(block), 1, p_out))
+					&& (block.packed_len == fwrite(p_data, 1, block.packed_len, p_out));
+		}
+		rv = rv && !ferror(p_in);
+	}
+
+	if (NULL != p_in) {
+		fclose(p_in);
+	}
+	if (NULL != p_out) {
+		rv = (0 == fclose(p_out)) && rv;
+		if (!rv) {
+			printf("LOGZ_CompressFile: [ERROR] Couldn't compress %s\n", src);
+			unlink(dst);
+		}
+	}
+	return rv;
+}
+
+/* ----------------------------------------------------------------------*/
+int LOGZ_DecompressStream(FILE* const in, FILE* const out)
+{
+	struct LOGZ_BLOCK_S block;
+	char magic[LOGZ_MAGIC_SIZE];
+	uint8_t* p_raw = NULL;
+	uint8_t* p_packed = NULL;
+	size_t got;
+	int rv = 0;
+
+	if ((LOGZ_MAGIC_SIZE != fread(magic, 1, LOGZ_MAGIC_SIZE, in)) || (0 != memcmp(magic, LOGZ_MAGIC, LOGZ_MAGIC_SIZE))) {
+		rv = -1;
+	} else if ((NULL == (p_raw = malloc(LOGZ_BLOCK_SIZE))) || (NULL == (p_packed = malloc(LOGZ_BOUND(LOGZ_BLOCK_SIZE))))) {
+		rv = -2;
+	} else {
+		while ((0 == rv) && (0 < (got = fread(&block, 1, sizeof(block), in)))) {
+			if ((sizeof(block) != got) || (LOGZ_BLOCK_SIZE < block.raw_len)
+					|| (block.packed_len > block.raw_len)
+					|| (block.packed_len != fread(p_packed, 1, block.packed_len, in))) {
+				rv = -2;
+			} else if (block.packed_len == block.raw_len) {
+				fwrite(p_packed, 1, block.raw_len, out);
+			} else if (!LOGZ_DecompressBlock(p_packed, block.packed_len, p_raw, block.raw_len)) {
+				rv = -2;
+			} else {
+				fwrite(p_raw, 1, block.raw_len, out);
+			}
+		}
+	}
+
+	free(p_raw);
+	free(p_packed);
+	return rv;
+}
+
+/* ----------------------------------------------------------------------
+ * functions with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------*/
+static uint32_t LOGZ_Hash(const uint8_t* const p_src)
+{
+	uint32_t word;
+
+	memcpy(&word, p_src, sizeof(word));
+	return (word * 2654435761U) >> (32 - LOGZ_HASH_BITS);
+}
+
+/* ----------------------------------------------------------------------*/
+static size_t LOGZ_FindMatch(
+		const struct LOGZ_S* const p_z,
+		const uint8_t* const p_src,
+		const size_t pos,
+		const size_t len,
+		size_t* const p_offset)
+{
+	const size_t max = len - pos;
+	int32_t cand = p_z->p_head[LOGZ_Hash(p_src + pos)];
+	uint32_t chain = LOGZ_MAX_CHAIN;
+	size_t best = 0;
+	size_t n;
+
+	while ((0 <= cand) && (pos - cand <= LOGZ_MAX_OFFSET) && (0 < chain--)) {
+		/* the byte beyond the best match so far decides quickly */
+		if ((best < max) && (p_src[cand + best] == p_src[pos + best])) {
+			for (n = 0; (n < max) && (p_src[cand + n] == p_src[pos + n]); n++) {
+				;
+			}
+			if (n > best) {
+				best = n;
+				*p_offset = pos - cand;
+				if (LOGZ_NICE_MATCH <= best) {
+					break;
+				}
+			}
+		}
+		cand = p_z->p_prev[cand];
+	}
+	return best;
+}
+
+/* ----------------------------------------------------------------------*/
+static void LOGZ_Insert(struct LOGZ_S* const p_z, const uint8_t* const p_src, const size_t pos)
+{
+	uint32_t hash = LOGZ_Hash(p_src + pos);
+
+	p_z->p_prev[pos] = p_z->p_head[hash];
+	p_z->p_head[hash] = pos;
+}
+
+/* ----------------------------------------------------------------------*/
+static uint8_t* LOGZ_PutCount(uint8_t* p_dst, size_t count)
+{
+	for (; 255 <= count; count -= 255) {
+		*p_dst++ = 255;
+	}
+	*p_dst++ = count;
+	return p_dst;
+}
+
+/* ----------------------------------------------------------------------*/
+static uint8_t* LOGZ_PutSequence(uint8_t* p_dst, const uint8_t* const p_lit, const size_t n_lit,
+		const size_t offset, const size_t match)
+{
+	uint8_t* p_token = p_dst++;
+	size_t match_code = (0 == match) ? 0 : match - LOGZ_MIN_MATCH;
+
+	*p_token = ((LOGZ_RUN_MASK <= n_lit) ? LOGZ_RUN_MASK : n_lit) << 4;
+	if (LOGZ_RUN_MASK <= n_lit) {
+		p_dst = LOGZ_PutCount(p_dst, n_lit - LOGZ_RUN_MASK);
+	}
+	memcpy(p_dst, p_lit, n_lit);
+	p_dst += n_lit;
+
+	if (0 != match) {
+		*p_dst++ = offset & 0xFF;
+		*p_dst++ = offset >> 8;
+		*p_token |= (LOGZ_RUN_MASK <= match_code) ? LOGZ_RUN_MASK : match_code;
+		if (LOGZ_RUN_MASK <= match_code) {
+			p_dst = LOGZ_PutCount(p_dst, match_code - LOGZ_RUN_MASK);
+		}
+	}
+	return p_dst;
+}
@@ -0,0 +1,81 @@
+#if !defined (LOGZ_H_INCLUDE)
+#define LOGZ_H_INCLUDE
+/**
+ * @file logz.h
+ * @brief functional interface declarations for the LZ log segment codec
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stdbool.h>
+#include <stdio.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* component include */
+#include "logz_t.h"
+
+/* ----------------------------------------------------------------------
+ * function declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Allocate the working memory of the compressor
+ * @param[out] p_z the compressor
+ * @return true on success, false otherwise
+ */
+bool LOGZ_Create(struct LOGZ_S* const p_z);
+
+/**
+ * @brief Release the working memory of the compressor
+ * @param[in, out] p_z the compressor
+ */
+void LOGZ_Destroy(struct LOGZ_S* const p_z);
+
+/**
+ * @brief Compress one block
+ * @param[in, out] p_z the compressor
+ * @param[in] p_src the bytes
+ * @param[in] len the number of bytes, at most LOGZ_BLOCK_SIZE
+ * @param[out] p_dst the compressed bytes, LOGZ_BOUND(len) available
+ * @return the number of compressed bytes
+ */
+size_t LOGZ_CompressBlock(struct LOGZ_S* const p_z, const uint8_t* const p_src, const size_t len, uint8_t* const p_dst);
+
+/**
+ * @brief Decompress one block
+ * @param[in] p_src the compressed bytes
+ * @param[in] len the number of compressed bytes
+ * @param[out] p_dst the bytes
+ * @param[in] raw_len the number of bytes the block holds
+ * @return true on success, false if the block is corrupt
+ */
+bool LOGZ_DecompressBlock(const uint8_t* const p_src, const size_t len, uint8_t* const p_dst, const size_t raw_len);
+
+/**
+ * @brief Compress a file block by block
+ * @param[in, out] p_z the compressor
+ * @param[in] src the file to compress
+ * @param[in] dst the compressed file, replaced
+ * @return true on success, false otherwise (dst is removed)
+ */
+bool LOGZ_CompressFile(struct LOGZ_S* const p_z, const char* const src, const char* const dst);
+
+/**
+ * @brief Decompress a compressed stream
+ * @param[in] in the compressed stream
+ * @param[in] out the bytes
+ * @return 0 on success, -1 if the stream is not compressed, -2 if corrupt
+ * or truncated
+ */
+int LOGZ_DecompressStream(FILE* const in, FILE* const out);
+
+#endif /* if !defined(LOGZ_H_INCLUDE) */
@@ -0,0 +1,60 @@
+#if !defined (LOGZ_T_H_INCLUDE)
+#define LOGZ_T_H_INCLUDE
+/**
+ * @file logz_t.h
+ * @brief interface type declarations for the LZ log segment codec
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* ----------------------------------------------------------------------
+ * include section
+ * ----------------------------------------------------------------------*/
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <stddef.h>
+#include <stdint.h>
+
+/* project specific includes - if possible alphabetically ordered */
+
+/* module specific includes (log) - if possible alphabetically ordered */
+
+/* ----------------------------------------------------------------------
+ * macro declaration section
+ * ----------------------------------------------------------------------*/
+
+#define LOGZ_MAGIC      "LOGZ"        /**< First bytes of a compressed file */
+#define LOGZ_MAGIC_SIZE (4)           /**< strlen(LOGZ_MAGIC) */
+#define LOGZ_BLOCK_SIZE (256 * 1024)  /**< Max uncompressed bytes per block */
+#define LOGZ_HASH_BITS  (15)          /**< log2 of the match finder hash table size */
+
+/** Max compressed size of len bytes (incompressible input) */
+#define LOGZ_BOUND(len) ((len) + (len) / 255 + 16)
+
+/* ----------------------------------------------------------------------
+ * type declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief The header of a compressed block, in host byte order
+ * @details
+ * A compressed file is LOGZ_MAGIC followed by blocks. A block whose
+ * packed_len equals raw_len holds the bytes as they are.
+ */
+struct LOGZ_BLOCK_S {
+	uint32_t raw_len;     /**< Uncompressed bytes, at most LOGZ_BLOCK_SIZE */
+	uint32_t packed_len;  /**< Bytes following the header */
+};
+
+/**
+ * @brief The working memory of the compressor
+ */
+struct LOGZ_S {
+	int32_t* p_head;    /**< Per hash: the last position, -1 if none */
+	int32_t* p_prev;    /**< Per position: the previous one of the same hash */
+	uint8_t* p_raw;     /**< One uncompressed block */
+	uint8_t* p_packed;  /**< One compressed block */
+};
+
+#endif /* if !defined(LOGZ_T_H_INCLUDE) */
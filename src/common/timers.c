@@ -5,6 +5,19 @@
  * format: 1TBS
  * rules:
  * @endcode
+ * @details
+ * The timers are entries of a table, addressed by index and generation
+ * (refer to TIMER_TABLE_S), and live in hierarchical timing wheels, one
+ * per clock (refer to TIMER_WHEEL_S): creating, arming, disarming and
+ * disposing a timer are a table lookup and a slot list (un)link. A
+ * timerfd per wheel wakes the dispatcher thread, through epoll, at the next
+ * deadline; the thread advances the wheels, cascades the coarser levels,
+ * re-links the periodic timers and calls the elapsed timers back as
+ * ordinary function calls without holding the wheel lock, so a call-back
+ * may log, re-arm or dispose timers. The realtime timerfd is canceled when
+ * the clock is set, so the realtime wheel is re-evaluated at once.
+ * TIMER_SetBackend swaps the wheel slots for a 4-ary min-heap of exact
+ * deadlines per clock (refer to TIMER_HEAP_S).
  */
 
 /* ----------------------------------------------------------------------
@@ -12,9 +25,14 @@
  * ----------------------------------------------------------------------*/
 /* general includes (unix a.o.) - if possible alphabetically ordered */
 #include <errno.h>
-#include <signal.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <time.h>
+#include <unistd.h>
 
 /* project specific includes - if possible alphabetically ordered */
 #include "log.h"
@@ -28,66 +46,445 @@
  * internal macro declaration section
  * ----------------------------------------------------------------------*/
 
+#define TIMER_CLOCKID CLOCK_MONOTONIC /**< The clock of the timers of TIMER_CreateTimer */
+#define TIMER_NS      (1000000000LL)  /**< Nanoseconds per second */
+
+/** Longer times saturate there, some 73 years: a deadline plus an interval
+ * plus a slack still fit in 64 bits */
+#define TIMER_SEC_MAX (INT64_MAX / TIMER_NS / 4)
+
+#define TIMER_REALTIME     (0)        /**< The realtime wheel in TIMER_wheels */
+#define TIMER_MONOTONIC    (1)        /**< The monotonic wheel in TIMER_wheels */
+
+#define TIMER_SLOT_NONE    (0xFFFF)   /**< TIMER_S.slot of a disarmed timer */
+#define TIMER_SLOT_EXPIRED (0xFFFE)   /**< TIMER_S.slot of an elapsed timer */
+#define TIMER_SLOT_HEAP    (0xFFFD)   /**< TIMER_S.slot of a timer in a heap */
+
+#define TIMER_HEAP_PAD     (TIMER_HEAP_ARITY - 1)  /**< Nodes of TIMER_HEAP_S.p_block before the root */
+#define TIMER_HEAP_MIN     (64)       /**< Heap capacity allocated first */
+
+/** The overrun count saturates there, like DELAYTIMER_MAX */
+#define TIMER_OVERRUN_MAX ((uint32_t) INT32_MAX)
+
+/** The generations that fit in a timer_t above the index */
+#define TIMER_GENERATION_MASK ((uint32_t) (UINTPTR_MAX >> TIMER_HANDLE_INDEX_BITS))
+
 /* ----------------------------------------------------------------------
  * internal type declaration section
  * ----------------------------------------------------------------------*/
 
-#define TIMER_CLOCKID CLOCK_REALTIME /**< The clock source used by the timers */
-#define TIMER_MIN SIGRTMIN		/**< The minimum signal number to use */
-#define TIMER_MAX 30 			/**< Max number of timers that can be created */
+/* ----------------------------------------------------------------------
+ * function with internal linkage (static) declaration section
+ * ----------------------------------------------------------------------*/
+
+/**
+ * @brief Add a descriptor to the epoll set of the dispatcher thread
+ * @param[in] fd the descriptor to wait for
+ * @return true on success, false on failure
+ */
+static bool TIMER_Watch(const int fd);
+
+/**
+ * @brief Close the descriptors of the dispatcher thread
+ */
+static void TIMER_Close(void);
+
+/**
+ * @brief Initialize a list head or an unlinked timer link
+ * @param[out] p_link the link
+ */
+static void TIMER_ListInit(struct TIMER_LINK_S* const p_link);
+
+/**
+ * @brief Append a link to a list
+ * @param[in, out] p_head the list head
+ * @param[in, out] p_link the unlinked link
+ */
+static void TIMER_ListAppend(struct TIMER_LINK_S* const p_head, struct TIMER_LINK_S* const p_link);
+
+/**
+ * @brief Unlink a link from its list
+ * @param[in, out] p_link the link, left pointing at itself
+ */
+static void TIMER_ListRemove(struct TIMER_LINK_S* const p_link);
+
+/**
+ * @brief Take a timer from the free list, allocating a chunk if it is empty
+ * @return the timer, NULL if the table is full or out of memory
+ */
+static struct TIMER_S* TIMER_Allocate(void);
+
+/**
+ * @brief The handle of a timer
+ * @param[in] p_timer the timer
+ * @return the handle
+ */
+static timer_t TIMER_Handle(const struct TIMER_S* const p_timer);
+
+/**
+ * @brief The timer of a handle
+ * @param[in] timer_id the handle
+ * @return the timer, NULL if the handle is stale or invalid
+ */
+static struct TIMER_S* TIMER_Lookup(const timer_t timer_id);
+
+/**
+ * @brief The wheel of a clock
+ * @param[in] clock_id the clock
+ * @return the index in TIMER_wheels, TIMER_CLOCK_COUNT if the clock has none
+ */
+static unsigned TIMER_ClockIndex(const clockid_t clock_id);
+
+/**
+ * @brief The nanoseconds of a time span
+ * @param[in] p_time the time span, not negative
+ * @return the nanoseconds, saturated at TIMER_SEC_MAX seconds
+ */
+static uint64_t TIMER_SpanNs(const struct timespec* const p_time);
+
+/**
+ * @brief The nanoseconds a time is past the epoch of a wheel
+ * @param[in] p_wheel the wheel
+ * @param[in] p_time a time of the clock of the wheel
+ * @return the nanoseconds, 0 for times before the epoch, saturated at
+ * TIMER_SEC_MAX seconds
+ */
+static uint64_t TIMER_SinceEpoch(const struct TIMER_WHEEL_S* const p_wheel, const struct timespec* const p_time);
+
+/**
+ * @brief The nanoseconds elapsed since the epoch of a wheel
+ * @param[in] p_wheel the wheel
+ * @return the nanoseconds
+ */
+static uint64_t TIMER_NowNs(const struct TIMER_WHEEL_S* const p_wheel);
+
+/**
+ * @brief The first tick at which a wheel has work: a timer that elapses
+ * on level 0 or a cascade of a non-empty slot of another level
+ * @param[in] p_wheel the wheel
+ * @param[in] first_level 0, or 1 for the cascades only
+ * @return the tick, UINT64_MAX if no timer is armed
+ */
+static uint64_t TIMER_NextTick(const struct TIMER_WHEEL_S* const p_wheel, const unsigned first_level);
+
+/**
+ * @brief The latest time a timer may elapse at: its deadline plus its slack
+ * @param[in] p_timer the timer
+ * @return the nanoseconds since the epoch of its wheel
+ */
+static uint64_t TIMER_Latest(const struct TIMER_S* const p_timer);
+
+/**
+ * @brief The time to arm the timerfd of a wheel for: the earliest latest
+ * time of the level 0 timers, or the start of the next cascade if sooner
+ * @details
+ * Waking up then elapses every timer whose deadline is past, so the
+ * timers with overlapping slack windows share the wakeup.
+ * @param[in] p_wheel the wheel
+ * @return the nanoseconds since the epoch, UINT64_MAX if no timer is armed
+ */
+static uint64_t TIMER_NextDeadline(const struct TIMER_WHEEL_S* const p_wheel);
+
+/**
+ * @brief Link a timer in the slot for its deadline
+ * @param[in, out] p_wheel the wheel of the timer
+ * @param[in, out] p_timer the unlinked timer, deadline set
+ */
+static void TIMER_Insert(struct TIMER_WHEEL_S* const p_wheel, struct TIMER_S* const p_timer);
+
+/**
+ * @brief Unlink a timer from its slot or heap, if any
+ * @param[in, out] p_timer the timer
+ */
+static void TIMER_Unlink(struct TIMER_S* const p_timer);
+
+/**
+ * @brief Link a timer in the scheduler of the backend
+ * @param[in, out] p_wheel the wheel of the timer
+ * @param[in, out] p_timer the unlinked timer, deadline set
+ */
+static void TIMER_Schedule(struct TIMER_WHEEL_S* const p_wheel, struct TIMER_S* const p_timer);
+
+/**
+ * @brief Make room for one more timer of a clock in the heaps it may be
+ * armed on, heap backend
+ * @details
+ * A realtime timer armed with a relative time runs on the monotonic heap.
+ * @param[in] clock the wheel of the clock of the timer
+ * @return true on success or with the wheel backend, false on failure
+ */
+static bool TIMER_Reserve(const unsigned clock);
+
+/**
+ * @brief Give back the room of a timer of a clock, heap backend
+ * @param[in] clock the wheel of the clock of the timer
+ */
+static void TIMER_Release(const unsigned clock);
+
+/**
+ * @brief Make room in a heap for one more timer of its clock
+ * @param[in, out] p_heap the heap
+ * @return true on success, false if out of memory
+ */
+static bool TIMER_HeapReserve(struct TIMER_HEAP_S* const p_heap);
+
+/**
+ * @brief Move a node up the heap to its place
+ * @param[in, out] p_heap the heap
+ * @param[in] position the free node to start from
+ * @param[in] node the node to place
+ */
+static void TIMER_HeapUp(struct TIMER_HEAP_S* const p_heap, uint32_t position, const struct TIMER_HEAP_NODE_S node);
+
+/**
+ * @brief Move a node down the heap to its place
+ * @param[in, out] p_heap the heap
+ * @param[in] position the free node to start from
+ * @param[in] node the node to place
+ */
+static void TIMER_HeapDown(struct TIMER_HEAP_S* const p_heap, uint32_t position, const struct TIMER_HEAP_NODE_S node);
+
+/**
+ * @brief Add a timer to a heap
+ * @param[in, out] p_heap the heap, room reserved
+ * @param[in, out] p_timer the unlinked timer, deadline set
+ */
+static void TIMER_HeapInsert(struct TIMER_HEAP_S* const p_heap, struct TIMER_S* const p_timer);
+
+/**
+ * @brief Take a timer out of a heap
+ * @param[in, out] p_heap the heap
+ * @param[in] position the node of the timer
+ */
+static void TIMER_HeapRemove(struct TIMER_HEAP_S* const p_heap, const uint32_t position);
+
+/**
+ * @brief The heap counterpart of TIMER_NextDeadline: the earliest latest
+ * time of the timers
+ * @details
+ * Visits the nodes whose deadlines are before the best latest time found
+ * so far: without slack, the root only.
+ * @param[in] p_heap the heap
+ * @return the nanoseconds since the epoch, UINT64_MAX if no timer is armed
+ */
+static uint64_t TIMER_HeapNextDeadline(const struct TIMER_HEAP_S* const p_heap);
+
+/**
+ * @brief The heap counterpart of TIMER_Advance: moves the elapsed timers
+ * to the expired list
+ * @param[in, out] p_wheel the wheel of the heap
+ * @param[in] now the nanoseconds since the epoch of the wheel
+ */
+static void TIMER_HeapAdvance(struct TIMER_WHEEL_S* const p_wheel, const uint64_t now);
+
+/**
+ * @brief Arm a timer and move the timerfd ahead if it elapses first
+ * @details
+ * Like in the kernel, a relative realtime timer is armed on the monotonic
+ * wheel: setting the clock doesn't move its deadline.
+ * @param[in, out] p_timer the unlinked timer
+ * @param[in] flags 0 or TIMER_ABSTIME
+ * @param[in] p_value the expiration and the period, it_value not zero
+ */
+static void TIMER_Start(struct TIMER_S* const p_timer, const int flags, const struct itimerspec* const p_value);
+
+/**
+ * @brief Relink the timers of a slot on the lower levels
+ * @param[in, out] p_wheel the wheel
+ * @param[in] level the level of the slot, > 0
+ * @param[in] index the slot
+ */
+static void TIMER_Cascade(struct TIMER_WHEEL_S* const p_wheel, const unsigned level, const unsigned index);
+
+/**
+ * @brief Process the ticks up to now, moving the elapsed timers to the
+ * expired list
+ * @details
+ * The current tick remains the next tick to process: a timer due later
+ * within it is linked to its slot, not to the one of the next tick, which
+ * would only be scanned once the tick is over.
+ * @param[in, out] p_wheel the wheel
+ * @param[in] now the nanoseconds since the epoch of the wheel
+ */
+static void TIMER_Advance(struct TIMER_WHEEL_S* const p_wheel, const uint64_t now);
+
+/**
+ * @brief Relink all timers of a wheel from a new now on, once its clock
+ * was set back
+ * @details
+ * The deadlines are kept: the realtime wheel only holds absolute timers,
+ * which still elapse at their time of the clock, whichever way the clock
+ * was set.
+ * @param[in, out] p_wheel the wheel
+ * @param[in] now the nanoseconds since the epoch of the wheel, before clk
+ */
+static void TIMER_Rebase(struct TIMER_WHEEL_S* const p_wheel, const uint64_t now);
+
+/**
+ * @brief Relink an elapsed periodic timer for its next period
+ * @param[in, out] p_wheel the wheel of the timer
+ * @param[in, out] p_timer the unlinked timer
+ * @param[in] now the nanoseconds since the epoch of the wheel
+ */
+static void TIMER_Reload(struct TIMER_WHEEL_S* const p_wheel, struct TIMER_S* const p_timer, const uint64_t now);
+
 /**
- * @brief State variable representing the total number of timers that are
- * created
+ * @brief Arm the timerfd of a wheel
+ * @param[in, out] p_wheel the wheel
+ * @param[in] ns the nanoseconds since the epoch to arm it for, UINT64_MAX to disarm it
  */
-static int TIMER_Counter = 0; 	/**< The total number of timers created */
+static void TIMER_Arm(struct TIMER_WHEEL_S* const p_wheel, const uint64_t ns);
+
+/**
+ * @brief Advance a wheel and run the call-backs of its elapsed timers
+ * @details
+ * Called and returns with TIMER_mutex locked, unlocks it during the
+ * call-backs.
+ * @param[in, out] p_wheel the wheel
+ */
+static void TIMER_Dispatch(struct TIMER_WHEEL_S* const p_wheel);
+
+/**
+ * @brief The dispatcher thread: waits for the timerfds and runs the
+ * call-backs of the elapsed timers
+ * @param[in] p_arg not used
+ * @return NULL
+ */
+static void* TIMER_Thread(void* p_arg);
+
+/* ----------------------------------------------------------------------
+ * variable with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
 /**
  * @brief State variable representing the initialized state of the component
  */
 static bool TIMER_is_init;
 
 /**
- * @brief struct array to store key <timer_id> value <signum> pairs
+ * @brief The clocks that have a wheel, in the order of TIMER_wheels
  */
-struct TIMER_s {
-	timer_t timer_id;
-	int signum;
+static const clockid_t TIMER_clocks[TIMER_CLOCK_COUNT] = {
+	CLOCK_REALTIME,
+	CLOCK_MONOTONIC,
+	CLOCK_BOOTTIME,
 };
-struct TIMER_s TIMER_Instances[TIMER_MAX];
+
 /**
- * @brief return the index of the array for a timer id.
- * @return 0 on success, else on failure
+ * @brief The timing wheels, guarded by TIMER_mutex
  */
-static int TIMER_GetIndex(const timer_t* p_timer_id, int* p_index);
+static struct TIMER_WHEEL_S TIMER_wheels[TIMER_CLOCK_COUNT];
+
 /**
- * @brief function to determine if a timer already exists
- * @return true when it exists, false if not
+ * @brief The timer table, guarded by TIMER_mutex
  */
-static bool TIMER_Exists(timer_t* p_timer_id);
+static struct TIMER_TABLE_S TIMER_table;
+
 /**
- * @brief Function to return a pointer to a free timer object
- * @return pointer to timer object
+ * @brief The scheduler of the armed timers, set before TIMER_Init
  */
-static struct TIMER_s* TIMER_GetFreeTimerObject();
+static enum TIMER_BACKEND_E TIMER_backend = TIMER_BACKEND_WHEEL;
+
 /**
- * @brief Remove the timer object from the array
- * @return 0 on success, other on failure
+ * @brief Guards TIMER_wheels and every timer in them
  */
-static int TIMER_RemoveTimerObject(const timer_t* p_timer_id);
+static pthread_mutex_t TIMER_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief The dispatcher thread
+ */
+static pthread_t TIMER_thread;
+
+/**
+ * @brief Keeps the dispatcher thread running, cleared by TIMER_Breakdown
+ */
+static volatile bool TIMER_running;
+
+/**
+ * @brief The epoll set the dispatcher thread waits on
+ */
+static int TIMER_epoll_fd = -1;
+
+/**
+ * @brief The eventfd that wakes the dispatcher thread for breakdown
+ */
+static int TIMER_wakeup_fd = -1;
+
+/* ----------------------------------------------------------------------
+ * exported variable definition section
+ * ----------------------------------------------------------------------*/
+
+/* ----------------------------------------------------------------------
+ * exported function definition section
+ * ----------------------------------------------------------------------*/
 
+/* ------------------------------------------------------------------------- */
+bool TIMER_SetBackend(const enum TIMER_BACKEND_E backend)
+{
+	static const char* fn = "TIMER_SetBackend";
+	bool rv = false;
+
+	if (TIMER_is_init) {
+		APPLOG_Log(fn, LOGLV_ERROR, "Backend can't change while the TIMER component is initialized");
+	} else if (TIMER_BACKEND_SENTINEL <= backend) {
+		APPLOG_Log(fn, LOGLV_ERROR, "Illegal timer backend: %d", backend);
+	} else {
+		TIMER_backend = backend;
+		rv = true;
+	}
+	return rv;
+}
 /* ------------------------------------------------------------------------- */
 bool TIMER_Init(void)
 {
 	bool rv = false;
+	bool fds_ok = true;
+	struct TIMER_WHEEL_S* p_wheel;
+	unsigned clock;
+	unsigned level;
+	unsigned index;
+
 	if (TIMER_is_init) {
 		APPLOG_Log(__FUNCTION__, LOGLV_WARNING, "TIMER component already initialized");
 	} else {
-		int i;
-		for (i = 0; i < TIMER_MAX; i++) {
-			TIMER_Instances[i].timer_id = NULL;
-			TIMER_Instances[i].signum = TIMER_MIN+i;
+		TIMER_running = true;
+		TIMER_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		TIMER_wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		fds_ok = (0 <= TIMER_epoll_fd) && (0 <= TIMER_wakeup_fd);
+
+		for (clock = 0; clock < TIMER_CLOCK_COUNT; clock++) {
+			p_wheel = &TIMER_wheels[clock];
+			for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+				for (index = 0; index < TIMER_WHEEL_SLOTS; index++) {
+					TIMER_ListInit(&p_wheel->slots[level][index]);
+				}
+				p_wheel->occupied[level] = 0;
+			}
+			TIMER_ListInit(&p_wheel->expired);
+			memset(&p_wheel->heap, 0, sizeof(p_wheel->heap));
+			p_wheel->clk = 0;
+			p_wheel->armed = UINT64_MAX;
+			p_wheel->clock_id = TIMER_clocks[clock];
+			clock_gettime(p_wheel->clock_id, &p_wheel->epoch);
+			p_wheel->timer_fd = timerfd_create(p_wheel->clock_id, TFD_CLOEXEC | TFD_NONBLOCK);
+			fds_ok = fds_ok && (0 <= p_wheel->timer_fd) && TIMER_Watch(p_wheel->timer_fd);
+		}
+		TIMER_ListInit(&TIMER_table.free);
+
+		if (!fds_ok) {
+			APPLOG_Log(__FUNCTION__, LOGLV_ERROR, "Couldn't create the timer descriptors: %s", strerror(errno));
+		} else if (!TIMER_Watch(TIMER_wakeup_fd)) {
+			APPLOG_Log(__FUNCTION__, LOGLV_ERROR, "Couldn't watch the timer descriptors: %s", strerror(errno));
+		} else if (0 != pthread_create(&TIMER_thread, NULL, TIMER_Thread, NULL)) {
+			APPLOG_Log(__FUNCTION__, LOGLV_ERROR, "Couldn't start the timer dispatcher thread");
+		} else {
+			pthread_setname_np(TIMER_thread, "timers");
+			TIMER_is_init = true;
+			rv = true;
+		}
+		if (!rv) {
+			TIMER_Close();
 		}
-		TIMER_is_init = true;
-		rv = true;
 	}
 	return rv;
 }
@@ -95,160 +492,239 @@ bool TIMER_Init(void)
 bool TIMER_Breakdown(void)
 {
 	bool rv = false;
+	uint32_t chunk;
+	unsigned clock;
+
 	if (!TIMER_is_init) {
 		APPLOG_Log(__FUNCTION__, LOGLV_ERROR, "TIMER component not initialized");
 	} else {
-		int i;
-		for (i = 0; i < TIMER_MAX; i++) {
-			if (TIMER_Instances[i].timer_id !=NULL) {
-				TIMER_DisposeTimer(TIMER_Instances[i].timer_id);
-				TIMER_Instances[i].timer_id = NULL;
-			}
+		TIMER_running = false;
+		if (0 > eventfd_write(TIMER_wakeup_fd, 1)) {
+			APPLOG_Log(__FUNCTION__, LOGLV_ERROR, "Couldn't wake the timer dispatcher thread: %s", strerror(errno));
+		}
+		pthread_join(TIMER_thread, NULL);
+		TIMER_Close();
+
+		/* all timers go with the table, their handles turn invalid */
+		pthread_mutex_lock(&TIMER_mutex);
+		for (chunk = 0; chunk < TIMER_TABLE_CHUNKS; chunk++) {
+			free(TIMER_table.p_chunks[chunk]);
+		}
+		memset(&TIMER_table, 0, sizeof(TIMER_table));
+		for (clock = 0; clock < TIMER_CLOCK_COUNT; clock++) {
+			free(TIMER_wheels[clock].heap.p_block);
+			memset(&TIMER_wheels[clock].heap, 0, sizeof(TIMER_wheels[clock].heap));
 		}
 		TIMER_is_init = false;
+		pthread_mutex_unlock(&TIMER_mutex);
+
 		APPLOG_Log(__FUNCTION__, LOGLV_INFO, "Successfully destroyed the Timer component");
 		rv = true;
 	}
 	return rv;
 }
 /* ------------------------------------------------------------------------- */
-static int TIMER_GetIndex(const timer_t* p_timer_id, int* p_index)
+int TIMER_CreateTimer(
+		timer_t* const p_timer_id,
+		const uint32_t seconds,
+		const void* const p_params,
+		TIMERS_CallBack_FP call_back)
 {
-	int rv = -1, i;
-	for (i = 0; i < TIMER_MAX; i++) {
-		if (*p_timer_id == TIMER_Instances[i].timer_id) {
-			*p_index = i;
-			rv = 0;
-		}
+	int rv = TIMER_CreateClockTimer(p_timer_id, TIMER_CLOCKID, p_params, call_back);
+
+	if ((0 == rv) && (0 != seconds)) {
+		rv = TIMER_SetTime(*p_timer_id, seconds);
 	}
 	return rv;
 }
 /* ------------------------------------------------------------------------- */
-static bool TIMER_Exists(timer_t* p_timer_id)
+int TIMER_CreateClockTimer(
+		timer_t* const p_timer_id,
+		const clockid_t clock_id,
+		const void* const p_params,
+		TIMERS_CallBack_FP call_back)
 {
-	int index;
-	if (TIMER_GetIndex(p_timer_id, &index)) {
-		return false;
+	static const char* fn = "TIMER_CreateClockTimer";
+	int rv = -1;
+	const unsigned clock = TIMER_ClockIndex(clock_id);
+	struct TIMER_S* p_timer;
+
+	if (NULL == p_timer_id){
+		APPLOG_Log(fn, LOGLV_CRITICAL, "Null pointer to timer id");
+		rv = -1;
+	} else if (NULL == call_back){
+		APPLOG_Log(fn, LOGLV_CRITICAL, "Null call-back pointer");
+		rv = -1;
+	} else if (!TIMER_is_init) {
+		APPLOG_Log(fn, LOGLV_ERROR, "TIMER component not initialized");
+		rv = -1;
+	} else if (TIMER_CLOCK_COUNT <= clock) {
+		APPLOG_Log(fn, LOGLV_ERROR, "Clock %d not supported", (int) clock_id);
+		rv = -1;
 	} else {
-		return true;
+		pthread_mutex_lock(&TIMER_mutex);
+		if (!TIMER_Reserve(clock)) {
+			APPLOG_Log(fn, LOGLV_CRITICAL, "Couldn't create timer: %s", strerror(errno));
+		} else if (NULL == (p_timer = TIMER_Allocate())) {
+			APPLOG_Log(fn, LOGLV_CRITICAL, "Couldn't create timer: %u timers in use", TIMER_table.count);
+			TIMER_Release(clock);
+		} else {
+			p_timer->deadline = 0;
+			p_timer->interval = 0;
+			p_timer->slack = 0;
+			p_timer->overruns = 0;
+			p_timer->slot = TIMER_SLOT_NONE;
+			p_timer->clock = clock;
+			p_timer->wheel = clock;
+			p_timer->call_back = call_back;
+			p_timer->p_params = p_params;
+			TIMER_table.count++;
+			*p_timer_id = TIMER_Handle(p_timer);
+			rv = 0;
+		}
+		pthread_mutex_unlock(&TIMER_mutex);
+		if (0 == rv) {
+			APPLOG_Log(fn, LOGLV_DEBUG, "timer %p successfully created", *p_timer_id);
+		}
 	}
+	return rv;
 }
 /* ------------------------------------------------------------------------- */
-static struct TIMER_s* TIMER_GetFreeTimerObject()
+int TIMER_SetTime(const timer_t timer_id, uint32_t seconds)
 {
-	struct TIMER_s* TimerObject;
-	int i;
-	for (i = 0; i <= TIMER_MAX; i++) {
-		if (TIMER_Instances[i].timer_id == NULL) { 
-			TimerObject = &TIMER_Instances[i];
-			break;
+	struct itimerspec value;
+
+	memset(&value, 0, sizeof(value));
+	value.it_value.tv_sec = seconds;
+	return TIMER_SetTimeSpec(timer_id, 0, &value);
+}
+/* ------------------------------------------------------------------------- */
+int TIMER_SetPeriodicTime(const timer_t timer_id, uint32_t seconds, uint32_t period)
+{
+	struct itimerspec value;
+
+	memset(&value, 0, sizeof(value));
+	value.it_value.tv_sec = seconds;
+	value.it_interval.tv_sec = period;
+	return TIMER_SetTimeSpec(timer_id, 0, &value);
+}
+/* ------------------------------------------------------------------------- */
+int TIMER_SetTimeSpec(const timer_t timer_id, const int flags, const struct itimerspec* const p_value)
+{
+	static const char* fn = "TIMER_SetTimeSpec";
+	int rv = -1;
+	struct TIMER_S* p_timer;
+
+	if (!TIMER_is_init) {
+		APPLOG_Log(fn, LOGLV_ERROR, "TIMER component not initialized");
+	} else if (NULL == p_value) {
+		APPLOG_Log(fn, LOGLV_CRITICAL, "Null timer value");
+	} else if ((0 > p_value->it_value.tv_sec) || (0 > p_value->it_value.tv_nsec) || (TIMER_NS <= p_value->it_value.tv_nsec)
+			|| (0 > p_value->it_interval.tv_sec) || (0 > p_value->it_interval.tv_nsec) || (TIMER_NS <= p_value->it_interval.tv_nsec)) {
+		APPLOG_Log(fn, LOGLV_ERROR, "Invalid timer value");
+	} else {
+		pthread_mutex_lock(&TIMER_mutex);
+		if (NULL == (p_timer = TIMER_Lookup(timer_id))) {
+			APPLOG_Log(fn, LOGLV_ERROR, "Invalid or stale timer id %p", timer_id);
+		} else {
+			TIMER_Unlink(p_timer);
+			if ((0 != p_value->it_value.tv_sec) || (0 != p_value->it_value.tv_nsec)) {
+				TIMER_Start(p_timer, flags, p_value);
+			}
+			rv = 0;
 		}
+		pthread_mutex_unlock(&TIMER_mutex);
 	}
-	return TimerObject;
+	return rv;
 }
 /* ------------------------------------------------------------------------- */
-static int TIMER_RemoveTimerObject(const timer_t* p_timer_id)
+int TIMER_GetTimeSpec(const timer_t timer_id, struct itimerspec* const p_value)
 {
-	int index, rv;
-	if (TIMER_GetIndex(p_timer_id, &index)) {
-		APPLOG_Log(__FUNCTION__, LOGLV_ERROR, "timer %d does not exist", *p_timer_id);
-		rv = -1;
+	static const char* fn = "TIMER_GetTimeSpec";
+	int rv = -1;
+	struct TIMER_S* p_timer;
+	uint64_t now;
+	uint64_t left = 0;
+
+	if (!TIMER_is_init) {
+		APPLOG_Log(fn, LOGLV_ERROR, "TIMER component not initialized");
+	} else if (NULL == p_value) {
+		APPLOG_Log(fn, LOGLV_CRITICAL, "Null timer value");
 	} else {
-		TIMER_Instances[index].timer_id = NULL;
-		TIMER_Counter--;
-		rv = 0;
+		pthread_mutex_lock(&TIMER_mutex);
+		if (NULL == (p_timer = TIMER_Lookup(timer_id))) {
+			APPLOG_Log(fn, LOGLV_ERROR, "Invalid or stale timer id %p", timer_id);
+		} else {
+			if (TIMER_SLOT_NONE != p_timer->slot) {
+				/* 1 ns for an elapsed timer: all zero means disarmed */
+				now = TIMER_NowNs(&TIMER_wheels[p_timer->wheel]);
+				left = (p_timer->deadline > now) ? p_timer->deadline - now : 1;
+			}
+			p_value->it_value.tv_sec = left / TIMER_NS;
+			p_value->it_value.tv_nsec = left % TIMER_NS;
+			p_value->it_interval.tv_sec = p_timer->interval / TIMER_NS;
+			p_value->it_interval.tv_nsec = p_timer->interval % TIMER_NS;
+			rv = 0;
+		}
+		pthread_mutex_unlock(&TIMER_mutex);
 	}
 	return rv;
 }
 /* ------------------------------------------------------------------------- */
-int TIMER_CreateTimer(
-		timer_t* const p_timer_id,
-		const uint32_t seconds,
-		const void* const p_params,
-		TIMERS_CallBack_FP call_back)
+int TIMER_SetSlack(const timer_t timer_id, const struct timespec* const p_slack)
 {
-	static const char* fn = "TIMER_CreateTimer";
+	static const char* fn = "TIMER_SetSlack";
 	int rv = -1;
-	struct sigevent  sig_event;
-	struct sigaction sig_action;
-	sigset_t sig_mask;
-	struct TIMER_s* p_timer_s;
+	struct TIMER_S* p_timer;
+	struct TIMER_WHEEL_S* p_wheel;
+	uint64_t next;
 
-	if (NULL == p_timer_id){
-		APPLOG_Log(fn, LOGLV_CRITICAL, "Null pointer to timer id");
-		rv = -1;
-	} else if (NULL == call_back){
-		APPLOG_Log(fn, LOGLV_CRITICAL, "Null call-back pointer");
-		rv = -1;
-	} else if (!TIMER_is_init) {
+	if (!TIMER_is_init) {
 		APPLOG_Log(fn, LOGLV_ERROR, "TIMER component not initialized");
-		rv = -1;
-	} else if (TIMER_Exists(p_timer_id)) {
-		APPLOG_Log(fn, LOGLV_WARNING, "timer_id %d already in use", *p_timer_id);
-		rv = -1;
-	} else if (TIMER_Counter > TIMER_MAX) {
-		APPLOG_Log(fn, LOGLV_CRITICAL, "Cannot create timer %d, all signals in use", *p_timer_id);
-		rv = -1;
+	} else if ((NULL == p_slack) || (0 > p_slack->tv_sec) || (0 > p_slack->tv_nsec) || (TIMER_NS <= p_slack->tv_nsec)) {
+		APPLOG_Log(fn, LOGLV_CRITICAL, "Null or invalid slack");
 	} else {
-		sig_action.sa_flags = SA_SIGINFO;
-		sig_action.sa_sigaction = call_back;
-		sigemptyset(&sig_action.sa_mask);
-
-		p_timer_s = TIMER_GetFreeTimerObject();
-
-		if (0 > sigaction(p_timer_s->signum, &sig_action, NULL)){
-			APPLOG_Log(fn, LOGLV_ERROR, "Couldn't create timer: %s", strerror(errno));
+		pthread_mutex_lock(&TIMER_mutex);
+		if (NULL == (p_timer = TIMER_Lookup(timer_id))) {
+			APPLOG_Log(fn, LOGLV_ERROR, "Invalid or stale timer id %p", timer_id);
 		} else {
-			/* Block timer signal temporarily */
-			sigemptyset(&sig_mask);
-			sigaddset(&sig_mask, p_timer_s->signum);
-
-			if (0 > sigprocmask(SIG_SETMASK, &sig_mask, NULL)){
-				APPLOG_Log(fn, LOGLV_ERROR, "Couldn't block timer: %s", strerror(errno));
-			} else {
-				/* Create timer */
-				sig_event.sigev_notify          = SIGEV_SIGNAL;
-				sig_event.sigev_signo           = p_timer_s->signum;
-				sig_event.sigev_value.sival_ptr = (void*) p_params;
-
-				if (0 > timer_create(TIMER_CLOCKID, &sig_event, p_timer_id)){
-					APPLOG_Log(fn, LOGLV_ERROR, "Couldn't create timer: %s", strerror(errno));
-				} else if (0 != TIMER_SetTime(*p_timer_id, seconds)){
-					APPLOG_Log(fn, LOGLV_ERROR, "Couldn't set time: %s", strerror(errno));
-				} else if (0 > sigprocmask(SIG_UNBLOCK, &sig_mask, NULL)){
-					APPLOG_Log(fn, LOGLV_ERROR, "Couldn't unblock signal: %s", strerror(errno));
+			p_timer->slack = TIMER_SpanNs(p_slack);
+			if ((TIMER_SLOT_NONE != p_timer->slot) && (TIMER_SLOT_EXPIRED != p_timer->slot)) {
+				/* an armed timer moves the wakeup of its wheel either way; an
+				 * elapsed one is re-armed by the dispatcher */
+				p_wheel = &TIMER_wheels[p_timer->wheel];
+				if (TIMER_SLOT_HEAP == p_timer->slot) {
+					next = TIMER_HeapNextDeadline(&p_wheel->heap);
 				} else {
-					p_timer_s->timer_id = *p_timer_id;
-					TIMER_Counter++;
-					APPLOG_Log(fn, LOGLV_INFO, "timer %d successfully created with signum %d", p_timer_s->timer_id, p_timer_s->signum);
-					rv = 0;
+					next = TIMER_NextDeadline(p_wheel);
+				}
+				if (next != p_wheel->armed) {
+					TIMER_Arm(p_wheel, next);
 				}
 			}
+			rv = 0;
 		}
+		pthread_mutex_unlock(&TIMER_mutex);
 	}
 	return rv;
 }
 /* ------------------------------------------------------------------------- */
-int TIMER_SetTime(const timer_t timer_id, uint32_t seconds)
+int TIMER_GetOverrun(const timer_t timer_id)
 {
-	static const char* fn = "TIMER_SetTime";
+	static const char* fn = "TIMER_GetOverrun";
 	int rv = -1;
+	struct TIMER_S* p_timer;
 
 	if (!TIMER_is_init) {
 		APPLOG_Log(fn, LOGLV_ERROR, "TIMER component not initialized");
 	} else {
-		struct itimerspec interval;
-		interval.it_interval.tv_sec  = 0;
-		interval.it_interval.tv_nsec = 0;
-		interval.it_value.tv_sec     = seconds;
-		interval.it_value.tv_nsec    = 0;
-
-		if (0 > timer_settime(timer_id, 0, &interval, NULL)){
-			APPLOG_Log(fn, LOGLV_CRITICAL, "Couldn't set timer interval");
-			TIMER_DisposeTimer(timer_id);
+		pthread_mutex_lock(&TIMER_mutex);
+		if (NULL == (p_timer = TIMER_Lookup(timer_id))) {
+			APPLOG_Log(fn, LOGLV_ERROR, "Invalid or stale timer id %p", timer_id);
 		} else {
-			rv = 0;
+			rv = (int) p_timer->overruns;
 		}
+		pthread_mutex_unlock(&TIMER_mutex);
 	}
 	return rv;
 }
@@ -257,17 +733,706 @@ int TIMER_DisposeTimer(const timer_t timer_id)
 {
 	static const char* fn = "TIMER_DisposeTimer";
 	int rv = -1;
+	struct TIMER_S* p_timer;
 
 	if (!TIMER_is_init) {
 		APPLOG_Log(fn, LOGLV_ERROR, "TIMER component not initialized");
 	} else {
-		if (0 > timer_delete(timer_id)){
-			APPLOG_Log(fn, LOGLV_WARNING, "Couldn't delete timer: %s", strerror(errno));
+		pthread_mutex_lock(&TIMER_mutex);
+		if (NULL == (p_timer = TIMER_Lookup(timer_id))) {
+			APPLOG_Log(fn, LOGLV_WARNING, "Couldn't delete timer: invalid or stale timer id %p", timer_id);
 		} else {
-			TIMER_RemoveTimerObject(&timer_id);
-			APPLOG_Log(fn, LOGLV_INFO, "timer %d successfully disposed", timer_id);
+			TIMER_Unlink(p_timer);
+			p_timer->generation = (p_timer->generation + 1) & TIMER_GENERATION_MASK;
+			if (0 == p_timer->generation) {
+				/* a handle is never NULL */
+				p_timer->generation = 1;
+			}
+			/* reused last, a stale handle matches again only after the
+			 * generation wraps on every free timer before it */
+			TIMER_ListAppend(&TIMER_table.free, &p_timer->link);
+			TIMER_table.count--;
+			TIMER_Release(p_timer->clock);
 			rv = 0;
 		}
+		pthread_mutex_unlock(&TIMER_mutex);
+		if (0 == rv) {
+			APPLOG_Log(fn, LOGLV_DEBUG, "timer %p successfully disposed", timer_id);
+		}
 	}
 	return rv;
-}
\ No newline at end of file
+}
+
+/* ----------------------------------------------------------------------
+ * function with internal linkage (static) definition section
+ * ----------------------------------------------------------------------*/
+
+/* ------------------------------------------------------------------------- */
+static bool TIMER_Watch(const int fd)
+{
+	struct epoll_event event;
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = fd;
+	return (0 == epoll_ctl(TIMER_epoll_fd, EPOLL_CTL_ADD, fd, &event));
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Close(void)
+{
+	unsigned clock;
+
+	if (0 <= TIMER_wakeup_fd) {
+		close(TIMER_wakeup_fd);
+	}
+	for (clock = 0; clock < TIMER_CLOCK_COUNT; clock++) {
+		if (0 <= TIMER_wheels[clock].timer_fd) {
+			close(TIMER_wheels[clock].timer_fd);
+		}
+		TIMER_wheels[clock].timer_fd = -1;
+	}
+	if (0 <= TIMER_epoll_fd) {
+		close(TIMER_epoll_fd);
+	}
+	TIMER_wakeup_fd = -1;
+	TIMER_epoll_fd = -1;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_ListInit(struct TIMER_LINK_S* const p_link)
+{
+	p_link->p_next = p_link;
+	p_link->p_prev = p_link;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_ListAppend(struct TIMER_LINK_S* const p_head, struct TIMER_LINK_S* const p_link)
+{
+	p_link->p_next = p_head;
+	p_link->p_prev = p_head->p_prev;
+	p_head->p_prev->p_next = p_link;
+	p_head->p_prev = p_link;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_ListRemove(struct TIMER_LINK_S* const p_link)
+{
+	p_link->p_prev->p_next = p_link->p_next;
+	p_link->p_next->p_prev = p_link->p_prev;
+	TIMER_ListInit(p_link);
+}
+/* ------------------------------------------------------------------------- */
+static struct TIMER_S* TIMER_Allocate(void)
+{
+	struct TIMER_S* p_timer = NULL;
+	struct TIMER_S* p_chunk;
+	uint32_t i;
+
+	if ((&TIMER_table.free == TIMER_table.free.p_next) && (TIMER_TABLE_MAX > TIMER_table.allocated)
+			&& (NULL != (p_chunk = malloc(TIMER_CHUNK_SIZE * sizeof(*p_chunk))))) {
+		TIMER_table.p_chunks[TIMER_table.allocated >> TIMER_CHUNK_BITS] = p_chunk;
+		for (i = 0; i < TIMER_CHUNK_SIZE; i++) {
+			p_chunk[i].index = TIMER_table.allocated + i;
+			p_chunk[i].generation = 1;
+			TIMER_ListAppend(&TIMER_table.free, &p_chunk[i].link);
+		}
+		TIMER_table.allocated += TIMER_CHUNK_SIZE;
+	}
+	if (&TIMER_table.free != TIMER_table.free.p_next) {
+		/* the oldest free timer first */
+		p_timer = (struct TIMER_S*) TIMER_table.free.p_next;
+		TIMER_ListRemove(&p_timer->link);
+	}
+	return p_timer;
+}
+/* ------------------------------------------------------------------------- */
+static timer_t TIMER_Handle(const struct TIMER_S* const p_timer)
+{
+	return (timer_t) (((uintptr_t) p_timer->generation << TIMER_HANDLE_INDEX_BITS) | p_timer->index);
+}
+/* ------------------------------------------------------------------------- */
+static struct TIMER_S* TIMER_Lookup(const timer_t timer_id)
+{
+	const uintptr_t handle = (uintptr_t) timer_id;
+	const uintptr_t index = handle & (TIMER_TABLE_MAX - 1);
+	struct TIMER_S* p_timer = NULL;
+
+	if (index < TIMER_table.allocated) {
+		p_timer = &TIMER_table.p_chunks[index >> TIMER_CHUNK_BITS][index & (TIMER_CHUNK_SIZE - 1)];
+		if ((handle >> TIMER_HANDLE_INDEX_BITS) != p_timer->generation) {
+			p_timer = NULL;
+		}
+	}
+	return p_timer;
+}
+/* ------------------------------------------------------------------------- */
+static unsigned TIMER_ClockIndex(const clockid_t clock_id)
+{
+	unsigned clock;
+
+	for (clock = 0; clock < TIMER_CLOCK_COUNT; clock++) {
+		if (TIMER_clocks[clock] == clock_id) {
+			break;
+		}
+	}
+	return clock;
+}
+/* ------------------------------------------------------------------------- */
+static uint64_t TIMER_SpanNs(const struct timespec* const p_time)
+{
+	return (TIMER_SEC_MAX < p_time->tv_sec) ? TIMER_SEC_MAX * TIMER_NS : p_time->tv_sec * TIMER_NS + p_time->tv_nsec;
+}
+/* ------------------------------------------------------------------------- */
+static uint64_t TIMER_SinceEpoch(const struct TIMER_WHEEL_S* const p_wheel, const struct timespec* const p_time)
+{
+	const int64_t sec = (int64_t) p_time->tv_sec - p_wheel->epoch.tv_sec;
+	const int64_t ns = ((TIMER_SEC_MAX < sec) ? TIMER_SEC_MAX : sec) * TIMER_NS + (p_time->tv_nsec - p_wheel->epoch.tv_nsec);
+
+	return (ns < 0) ? 0 : (uint64_t) ns;
+}
+/* ------------------------------------------------------------------------- */
+static uint64_t TIMER_NowNs(const struct TIMER_WHEEL_S* const p_wheel)
+{
+	struct timespec now;
+
+	clock_gettime(p_wheel->clock_id, &now);
+	return TIMER_SinceEpoch(p_wheel, &now);
+}
+/* ------------------------------------------------------------------------- */
+static uint64_t TIMER_NextTick(const struct TIMER_WHEEL_S* const p_wheel, const unsigned first_level)
+{
+	uint64_t next = UINT64_MAX;
+	uint64_t base;
+	uint64_t bits;
+	uint64_t tick;
+	unsigned shift;
+	unsigned level;
+	unsigned from;
+
+	for (level = first_level; level < TIMER_WHEEL_LEVELS; level++) {
+		if (0 == p_wheel->occupied[level]) {
+			continue;
+		}
+		shift = level * TIMER_WHEEL_BITS;
+		base = p_wheel->clk >> shift;
+
+		/* the current slot of a level above 0 is only still due when its
+		 * cascade, at the clk with all lower bits clear, is pending */
+		from = base & (TIMER_WHEEL_SLOTS - 1);
+		if ((0 != level) && (0 != (p_wheel->clk & ((1ULL << shift) - 1)))) {
+			from = (from + 1) & (TIMER_WHEEL_SLOTS - 1);
+			base++;
+		}
+		bits = p_wheel->occupied[level];
+		if (0 != from) {
+			bits = (bits >> from) | (bits << (TIMER_WHEEL_SLOTS - from));
+		}
+		tick = (base + __builtin_ctzll(bits)) << shift;
+		if (tick < next) {
+			next = tick;
+		}
+	}
+	return next;
+}
+/* ------------------------------------------------------------------------- */
+static uint64_t TIMER_Latest(const struct TIMER_S* const p_timer)
+{
+	return (p_timer->slack < UINT64_MAX - p_timer->deadline) ? p_timer->deadline + p_timer->slack : UINT64_MAX - 1;
+}
+/* ------------------------------------------------------------------------- */
+static uint64_t TIMER_NextDeadline(const struct TIMER_WHEEL_S* const p_wheel)
+{
+	const uint64_t cascade = TIMER_NextTick(p_wheel, 1);
+	const unsigned from = p_wheel->clk & (TIMER_WHEEL_SLOTS - 1);
+	const struct TIMER_LINK_S* p_head;
+	const struct TIMER_LINK_S* p_link;
+	uint64_t next = (UINT64_MAX == cascade) ? UINT64_MAX : cascade * TIMER_TICK_NS;
+	uint64_t bits = p_wheel->occupied[0];
+	uint64_t latest;
+	unsigned offset;
+
+	/* cascades first, which may bring earlier deadlines; up to there the
+	 * level 0 slots hold the ticks clk .. clk + TIMER_WHEEL_SLOTS - 1 */
+	if (0 != from) {
+		bits = (bits >> from) | (bits << (TIMER_WHEEL_SLOTS - from));
+	}
+	for (; 0 != bits; bits &= bits - 1) {
+		offset = __builtin_ctzll(bits);
+		if ((p_wheel->clk + offset) * TIMER_TICK_NS >= next) {
+			/* the deadlines of this tick on are all later */
+			break;
+		}
+		p_head = &p_wheel->slots[0][(from + offset) & (TIMER_WHEEL_SLOTS - 1)];
+		for (p_link = p_head->p_next; p_link != p_head; p_link = p_link->p_next) {
+			latest = TIMER_Latest((const struct TIMER_S*) p_link);
+			if (latest < next) {
+				next = latest;
+			}
+		}
+	}
+	return next;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Insert(struct TIMER_WHEEL_S* const p_wheel, struct TIMER_S* const p_timer)
+{
+	uint64_t expires = p_timer->deadline / TIMER_TICK_NS;
+	uint64_t delta;
+	unsigned level = 0;
+	unsigned index;
+
+	if (expires < p_wheel->clk) {
+		expires = p_wheel->clk;
+	}
+	delta = expires - p_wheel->clk;
+	if (delta >= TIMER_WHEEL_RANGE) {
+		/* parked on the last level, cascaded again until in range */
+		delta = TIMER_WHEEL_RANGE - 1;
+		expires = p_wheel->clk + delta;
+	}
+	if (delta >= TIMER_WHEEL_SLOTS) {
+		level = (63 - __builtin_clzll(delta)) / TIMER_WHEEL_BITS;
+	}
+	index = (expires >> (level * TIMER_WHEEL_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+
+	TIMER_ListAppend(&p_wheel->slots[level][index], &p_timer->link);
+	p_wheel->occupied[level] |= 1ULL << index;
+	p_timer->slot = level * TIMER_WHEEL_SLOTS + index;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Unlink(struct TIMER_S* const p_timer)
+{
+	struct TIMER_WHEEL_S* const p_wheel = &TIMER_wheels[p_timer->wheel];
+	unsigned level;
+	unsigned index;
+
+	if (TIMER_SLOT_HEAP == p_timer->slot) {
+		TIMER_HeapRemove(&p_wheel->heap, p_timer->position);
+		p_timer->slot = TIMER_SLOT_NONE;
+	} else if (TIMER_SLOT_NONE != p_timer->slot) {
+		TIMER_ListRemove(&p_timer->link);
+		if (TIMER_SLOT_EXPIRED != p_timer->slot) {
+			level = p_timer->slot / TIMER_WHEEL_SLOTS;
+			index = p_timer->slot % TIMER_WHEEL_SLOTS;
+			if (p_wheel->slots[level][index].p_next == &p_wheel->slots[level][index]) {
+				p_wheel->occupied[level] &= ~(1ULL << index);
+			}
+		}
+		p_timer->slot = TIMER_SLOT_NONE;
+	}
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Start(struct TIMER_S* const p_timer, const int flags, const struct itimerspec* const p_value)
+{
+	struct TIMER_WHEEL_S* p_wheel;
+
+	p_timer->wheel = p_timer->clock;
+	if ((TIMER_REALTIME == p_timer->clock) && (0 == (flags & TIMER_ABSTIME))) {
+		p_timer->wheel = TIMER_MONOTONIC;
+	}
+	p_wheel = &TIMER_wheels[p_timer->wheel];
+
+	if (0 != (flags & TIMER_ABSTIME)) {
+		p_timer->deadline = TIMER_SinceEpoch(p_wheel, &p_value->it_value);
+	} else {
+		p_timer->deadline = TIMER_NowNs(p_wheel) + TIMER_SpanNs(&p_value->it_value);
+	}
+	p_timer->interval = TIMER_SpanNs(&p_value->it_interval);
+	p_timer->overruns = 0;
+
+	TIMER_Schedule(p_wheel, p_timer);
+	if (TIMER_Latest(p_timer) < p_wheel->armed) {
+		TIMER_Arm(p_wheel, TIMER_Latest(p_timer));
+	}
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Schedule(struct TIMER_WHEEL_S* const p_wheel, struct TIMER_S* const p_timer)
+{
+	if (TIMER_BACKEND_HEAP == TIMER_backend) {
+		TIMER_HeapInsert(&p_wheel->heap, p_timer);
+	} else {
+		TIMER_Insert(p_wheel, p_timer);
+	}
+}
+/* ------------------------------------------------------------------------- */
+static bool TIMER_Reserve(const unsigned clock)
+{
+	bool rv = true;
+
+	if (TIMER_BACKEND_HEAP != TIMER_backend) {
+		/* the wheel slots are lists */
+	} else if (!TIMER_HeapReserve(&TIMER_wheels[clock].heap)) {
+		rv = false;
+	} else if ((TIMER_REALTIME == clock) && !TIMER_HeapReserve(&TIMER_wheels[TIMER_MONOTONIC].heap)) {
+		TIMER_wheels[clock].heap.reserved--;
+		rv = false;
+	}
+	return rv;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Release(const unsigned clock)
+{
+	if (TIMER_BACKEND_HEAP == TIMER_backend) {
+		TIMER_wheels[clock].heap.reserved--;
+		if (TIMER_REALTIME == clock) {
+			TIMER_wheels[TIMER_MONOTONIC].heap.reserved--;
+		}
+	}
+}
+/* ------------------------------------------------------------------------- */
+static bool TIMER_HeapReserve(struct TIMER_HEAP_S* const p_heap)
+{
+	bool rv = true;
+	struct TIMER_HEAP_NODE_S* p_block;
+	uint32_t capacity;
+
+	if (p_heap->reserved == p_heap->capacity) {
+		capacity = (0 == p_heap->capacity) ? TIMER_HEAP_MIN : 2 * p_heap->capacity;
+		if (0 != posix_memalign((void**) &p_block, TIMER_HEAP_ALIGN,
+				(capacity + TIMER_HEAP_PAD) * sizeof(*p_block))) {
+			errno = ENOMEM;
+			rv = false;
+		} else {
+			if (NULL != p_heap->p_block) {
+				memcpy(p_block, p_heap->p_block, (p_heap->count + TIMER_HEAP_PAD) * sizeof(*p_block));
+				free(p_heap->p_block);
+			}
+			p_heap->p_block = p_block;
+			p_heap->capacity = capacity;
+		}
+	}
+	if (rv) {
+		p_heap->reserved++;
+	}
+	return rv;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_HeapUp(struct TIMER_HEAP_S* const p_heap, uint32_t position, const struct TIMER_HEAP_NODE_S node)
+{
+	struct TIMER_HEAP_NODE_S* const p_nodes = p_heap->p_block + TIMER_HEAP_PAD;
+	uint32_t parent;
+
+	while (0 != position) {
+		parent = (position - 1) / TIMER_HEAP_ARITY;
+		if (p_nodes[parent].deadline <= node.deadline) {
+			break;
+		}
+		p_nodes[position] = p_nodes[parent];
+		p_nodes[position].p_timer->position = position;
+		position = parent;
+	}
+	p_nodes[position] = node;
+	node.p_timer->position = position;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_HeapDown(struct TIMER_HEAP_S* const p_heap, uint32_t position, const struct TIMER_HEAP_NODE_S node)
+{
+	struct TIMER_HEAP_NODE_S* const p_nodes = p_heap->p_block + TIMER_HEAP_PAD;
+	uint32_t child;
+	uint32_t first;
+	uint32_t last;
+	uint32_t i;
+
+	for (;;) {
+		first = TIMER_HEAP_ARITY * position + 1;
+		if (first >= p_heap->count) {
+			break;
+		}
+		last = (p_heap->count - first > TIMER_HEAP_ARITY) ? first + TIMER_HEAP_ARITY : p_heap->count;
+		child = first;
+		for (i = first + 1; i < last; i++) {
+			if (p_nodes[i].deadline < p_nodes[child].deadline) {
+				child = i;
+			}
+		}
+		if (p_nodes[child].deadline >= node.deadline) {
+			break;
+		}
+		p_nodes[position] = p_nodes[child];
+		p_nodes[position].p_timer->position = position;
+		position = child;
+	}
+	p_nodes[position] = node;
+	node.p_timer->position = position;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_HeapInsert(struct TIMER_HEAP_S* const p_heap, struct TIMER_S* const p_timer)
+{
+	const struct TIMER_HEAP_NODE_S node = { p_timer->deadline, p_timer };
+
+	p_timer->slot = TIMER_SLOT_HEAP;
+	TIMER_HeapUp(p_heap, p_heap->count++, node);
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_HeapRemove(struct TIMER_HEAP_S* const p_heap, const uint32_t position)
+{
+	const struct TIMER_HEAP_NODE_S* const p_nodes = p_heap->p_block + TIMER_HEAP_PAD;
+	const struct TIMER_HEAP_NODE_S last = p_nodes[--p_heap->count];
+
+	/* the last node fills the hole, from where it belongs up or down */
+	if (position == p_heap->count) {
+		/* it was the last node */
+	} else if ((0 != position) && (last.deadline < p_nodes[(position - 1) / TIMER_HEAP_ARITY].deadline)) {
+		TIMER_HeapUp(p_heap, position, last);
+	} else {
+		TIMER_HeapDown(p_heap, position, last);
+	}
+}
+/* ------------------------------------------------------------------------- */
+static uint64_t TIMER_HeapNextDeadline(const struct TIMER_HEAP_S* const p_heap)
+{
+	const struct TIMER_HEAP_NODE_S* const p_nodes = p_heap->p_block + TIMER_HEAP_PAD;
+	/* a visited node stacks up to TIMER_HEAP_ARITY children, 32 levels deep at most */
+	uint32_t stack[32 * TIMER_HEAP_ARITY];
+	uint32_t depth = 0;
+	uint32_t position;
+	uint32_t child;
+	uint64_t next = UINT64_MAX;
+	uint64_t latest;
+
+	if (0 != p_heap->count) {
+		stack[depth++] = 0;
+	}
+	while (0 != depth) {
+		position = stack[--depth];
+		/* the deadlines below are later still */
+		if (p_nodes[position].deadline >= next) {
+			continue;
+		}
+		latest = TIMER_Latest(p_nodes[position].p_timer);
+		if (latest < next) {
+			next = latest;
+		}
+		for (child = TIMER_HEAP_ARITY * position + 1;
+				(child < p_heap->count) && (child <= TIMER_HEAP_ARITY * (position + 1)); child++) {
+			if (p_nodes[child].deadline < next) {
+				stack[depth++] = child;
+			}
+		}
+	}
+	return next;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_HeapAdvance(struct TIMER_WHEEL_S* const p_wheel, const uint64_t now)
+{
+	struct TIMER_HEAP_S* const p_heap = &p_wheel->heap;
+	const struct TIMER_HEAP_NODE_S* const p_nodes = p_heap->p_block + TIMER_HEAP_PAD;
+	struct TIMER_S* p_timer;
+
+	while ((0 != p_heap->count) && (p_nodes[0].deadline <= now)) {
+		p_timer = p_nodes[0].p_timer;
+		TIMER_HeapRemove(p_heap, 0);
+		TIMER_ListAppend(&p_wheel->expired, &p_timer->link);
+		p_timer->slot = TIMER_SLOT_EXPIRED;
+	}
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Cascade(struct TIMER_WHEEL_S* const p_wheel, const unsigned level, const unsigned index)
+{
+	struct TIMER_LINK_S* const p_head = &p_wheel->slots[level][index];
+	struct TIMER_S* p_timer;
+
+	p_wheel->occupied[level] &= ~(1ULL << index);
+	while (p_head->p_next != p_head) {
+		p_timer = (struct TIMER_S*) p_head->p_next;
+		TIMER_ListRemove(&p_timer->link);
+		TIMER_Insert(p_wheel, p_timer);
+	}
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Advance(struct TIMER_WHEEL_S* const p_wheel, const uint64_t now)
+{
+	const uint64_t now_tick = now / TIMER_TICK_NS;
+	struct TIMER_LINK_S* p_head;
+	struct TIMER_LINK_S* p_link;
+	struct TIMER_S* p_timer;
+	uint64_t next;
+	unsigned level;
+	unsigned index;
+
+	while (p_wheel->clk <= now_tick) {
+		/* skip the ticks without work; clk stops at the current tick, whose
+		 * slot takes the deadlines still to come within it */
+		next = TIMER_NextTick(p_wheel, 0);
+		if (next > now_tick) {
+			p_wheel->clk = now_tick;
+			break;
+		}
+		p_wheel->clk = next;
+
+		for (level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+			if (0 != (p_wheel->clk & ((1ULL << (level * TIMER_WHEEL_BITS)) - 1))) {
+				break;
+			}
+			index = (p_wheel->clk >> (level * TIMER_WHEEL_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+			if (0 != (p_wheel->occupied[level] & (1ULL << index))) {
+				TIMER_Cascade(p_wheel, level, index);
+			}
+		}
+
+		index = p_wheel->clk & (TIMER_WHEEL_SLOTS - 1);
+		p_head = &p_wheel->slots[0][index];
+		for (p_link = p_head->p_next; p_link != p_head; ) {
+			p_timer = (struct TIMER_S*) p_link;
+			p_link = p_link->p_next;
+			if (p_timer->deadline <= now) {
+				TIMER_ListRemove(&p_timer->link);
+				TIMER_ListAppend(&p_wheel->expired, &p_timer->link);
+				p_timer->slot = TIMER_SLOT_EXPIRED;
+			}
+		}
+		if (p_head->p_next != p_head) {
+			/* the rest of the tick is still to come */
+			break;
+		}
+		p_wheel->occupied[0] &= ~(1ULL << index);
+		if (p_wheel->clk == now_tick) {
+			break;
+		}
+		p_wheel->clk++;
+	}
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Rebase(struct TIMER_WHEEL_S* const p_wheel, const uint64_t now)
+{
+	struct TIMER_LINK_S timers;
+	struct TIMER_S* p_timer;
+	unsigned level;
+	unsigned index;
+
+	TIMER_ListInit(&timers);
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (index = 0; index < TIMER_WHEEL_SLOTS; index++) {
+			while (p_wheel->slots[level][index].p_next != &p_wheel->slots[level][index]) {
+				p_timer = (struct TIMER_S*) p_wheel->slots[level][index].p_next;
+				TIMER_ListRemove(&p_timer->link);
+				TIMER_ListAppend(&timers, &p_timer->link);
+			}
+		}
+		p_wheel->occupied[level] = 0;
+	}
+
+	p_wheel->clk = now / TIMER_TICK_NS;
+	while (timers.p_next != &timers) {
+		p_timer = (struct TIMER_S*) timers.p_next;
+		TIMER_ListRemove(&p_timer->link);
+		TIMER_Insert(p_wheel, p_timer);
+	}
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Reload(struct TIMER_WHEEL_S* const p_wheel, struct TIMER_S* const p_timer, const uint64_t now)
+{
+	uint64_t skipped = 0;
+
+	p_timer->deadline += p_timer->interval;
+	if (p_timer->deadline <= now) {
+		/* late: skip the periods that are past already, and count them */
+		skipped = (now - p_timer->deadline) / p_timer->interval + 1;
+		p_timer->deadline += skipped * p_timer->interval;
+	}
+	p_timer->overruns = (TIMER_OVERRUN_MAX < skipped) ? TIMER_OVERRUN_MAX : (uint32_t) skipped;
+	TIMER_Schedule(p_wheel, p_timer);
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Arm(struct TIMER_WHEEL_S* const p_wheel, const uint64_t ns)
+{
+	struct itimerspec value;
+	uint64_t at;
+	int flags = TFD_TIMER_ABSTIME;
+
+	memset(&value, 0, sizeof(value));
+	if (UINT64_MAX != ns) {
+		/* an all zero it_value disarms, the epoch itself is a time > 0 */
+		at = p_wheel->epoch.tv_nsec + ns;
+		value.it_value.tv_sec = p_wheel->epoch.tv_sec + at / TIMER_NS;
+		value.it_value.tv_nsec = at % TIMER_NS;
+	}
+	/* setting the realtime clock wakes the dispatcher thread up with ECANCELED */
+	if (CLOCK_REALTIME == p_wheel->clock_id) {
+		flags |= TFD_TIMER_CANCEL_ON_SET;
+	}
+	if (0 > timerfd_settime(p_wheel->timer_fd, flags, &value, NULL)) {
+		APPLOG_Log(__FUNCTION__, LOGLV_CRITICAL, "Couldn't set timer interval: %s", strerror(errno));
+	}
+	p_wheel->armed = ns;
+}
+/* ------------------------------------------------------------------------- */
+static void TIMER_Dispatch(struct TIMER_WHEEL_S* const p_wheel)
+{
+	struct TIMER_EVENT_S event;
+	struct TIMER_S* p_timer;
+	TIMERS_CallBack_FP call_back;
+	const uint64_t now = TIMER_NowNs(p_wheel);
+	const bool set_back = (now / TIMER_TICK_NS + 1 < p_wheel->clk);
+	uint64_t next;
+
+	if (set_back) {
+		/* the ticks up to clk were processed, for a later time */
+		TIMER_Rebase(p_wheel, now);
+	}
+	if (p_wheel->armed <= now) {
+		p_wheel->armed = UINT64_MAX;
+	}
+	if (TIMER_BACKEND_HEAP == TIMER_backend) {
+		TIMER_HeapAdvance(p_wheel, now);
+	} else {
+		TIMER_Advance(p_wheel, now);
+	}
+
+	while (p_wheel->expired.p_next != &p_wheel->expired) {
+		p_timer = (struct TIMER_S*) p_wheel->expired.p_next;
+		TIMER_ListRemove(&p_timer->link);
+		p_timer->slot = TIMER_SLOT_NONE;
+		p_timer->overruns = 0;
+		if (0 != p_timer->interval) {
+			TIMER_Reload(p_wheel, p_timer, now);
+		}
+
+		event.timer_id = TIMER_Handle(p_timer);
+		event.p_params = p_timer->p_params;
+		event.overruns = p_timer->overruns;
+		call_back = p_timer->call_back;
+
+		/* the timer may be re-armed or disposed from here on */
+		pthread_mutex_unlock(&TIMER_mutex);
+		call_back(&event);
+		pthread_mutex_lock(&TIMER_mutex);
+	}
+
+	if (TIMER_BACKEND_HEAP == TIMER_backend) {
+		next = TIMER_HeapNextDeadline(&p_wheel->heap);
+	} else {
+		next = TIMER_NextDeadline(p_wheel);
+	}
+	if (set_back || (next != p_wheel->armed)) {
+		TIMER_Arm(p_wheel, next);
+	}
+}
+/* ------------------------------------------------------------------------- */
+static void* TIMER_Thread(void* p_arg)
+{
+	static const char* fn = "TIMER_Thread";
+	struct epoll_event events[TIMER_CLOCK_COUNT + 1];
+	uint64_t expirations;
+	unsigned clock;
+	int n_events;
+	int i;
+
+	pthread_mutex_lock(&TIMER_mutex);
+	while (TIMER_running) {
+		for (clock = 0; clock < TIMER_CLOCK_COUNT; clock++) {
+			TIMER_Dispatch(&TIMER_wheels[clock]);
+		}
+		pthread_mutex_unlock(&TIMER_mutex);
+
+		n_events = epoll_wait(TIMER_epoll_fd, events, sizeof(events) / sizeof(events[0]), -1);
+		if ((0 > n_events) && (EINTR != errno)) {
+			APPLOG_Log(fn, LOGLV_CRITICAL, "Couldn't wait for the timers: %s", strerror(errno));
+		}
+		for (i = 0; i < n_events; i++) {
+			/* drain the counter, the wheels themselves tell which timers elapsed */
+			if ((0 > read(events[i].data.fd, &expirations, sizeof(expirations))) && (ECANCELED == errno)) {
+				APPLOG_Log(fn, LOGLV_INFO, "The realtime clock was set, re-evaluating its timers");
+			}
+		}
+		pthread_mutex_lock(&TIMER_mutex);
+	}
+	pthread_mutex_unlock(&TIMER_mutex);
+	return NULL;
+}
@@ -25,21 +25,40 @@
  * function declaration section
  * ----------------------------------------------------------------------*/
 /**
- * @brief Initializes the timer object array
+ * @brief Initializes the timing wheel and starts its thread
+ * @details
+ * All timers share one timerfd, armed for the next tick that has work.
+ * The dispatcher thread waits for it with epoll and runs the call-backs
+ * as ordinary function calls, outside of any signal context. There is no
+ * limit on the number of timers.
  * @return true on success, false on failure
  */
 bool TIMER_Init(void);
-/** 
- * @brief Destroy the TIMER component.
+/**
+ * @brief Select the scheduler of the armed timers, before TIMER_Init
+ * @details
+ * The wheel (default) arms, disarms and elapses timers in O(1) with the
+ * deadlines bucketed in 1 ms ticks; the heap does it in O(log n) with
+ * exact deadlines and memory in proportion to the timers. Measure both
+ * with the timersched bench.
+ * @param[in] backend TIMER_BACKEND_WHEEL or TIMER_BACKEND_HEAP
+ * @return true on success, false if the component is initialized or the backend is illegal
+ */
+bool TIMER_SetBackend(const enum TIMER_BACKEND_E backend);
+/**
+ * @brief Destroy the TIMER component, disposing all timers.
  * @return true if the breakdown was successful, false otherwise.
  */
 bool TIMER_Breakdown(void);
 /**
- * @brief Create Timer
+ * @brief Create a one-shot timer on CLOCK_MONOTONIC
+ * @details
+ * Setting the system time neither delays nor advances it.
  * @param[out] p_timer_id the address where to return the ID of the created timer
- * @param[in] seconds the interval in seconds
- * @param[in] p_fsm_params the caller FSM base params
- * @param[in] call_back the call-back function pointer that is called once the timer elapses
+ * @param[in] seconds the interval in seconds, 0 to create the timer disarmed
+ * @param[in] p_params the caller params
+ * @param[in] call_back the call-back function pointer that is called once the timer elapses,
+ * on the dispatcher thread, with p_event->p_params set to p_params
  * @pre[tested] p_fsm_params must not be null
  * @pre[tested] p_timer_id must not be null
  * @pre[tested] call_back must not be null
@@ -54,15 +73,112 @@ int TIMER_CreateTimer(
 		TIMERS_CallBack_FP call_back);
 
 /**
- * @brief Disarm and delete the timer
- * @param[in] timer_id the identifier of the timer to stop and delete
- * @param[in] seconds the interval (in seconds) to load the timer with
+ * @brief (Re)arm the timer, O(1)
+ * @param[in] timer_id the identifier of the timer to load
+ * @param[in] seconds the interval (in seconds) to load the timer with, 0 to disarm it
  * @return Error code that confirms that the timer loading was successful or not.
  */
 int TIMER_SetTime(const timer_t timer_id, uint32_t seconds);
 
 /**
- * @brief Disarm and delete the timer
+ * @brief (Re)arm the timer as a periodic one, O(1)
+ * @details
+ * The timer elapses every period seconds after the first expiration,
+ * without drift and without the call-back re-arming it. Periods missed
+ * while the dispatcher thread was late are reported in p_event->overruns.
+ * @param[in] timer_id the identifier of the timer to load
+ * @param[in] seconds the first expiration in seconds, 0 to disarm the timer
+ * @param[in] period the period in seconds, 0 for a one-shot timer
+ * @return 0 on success, -1 on failure
+ */
+int TIMER_SetPeriodicTime(const timer_t timer_id, uint32_t seconds, uint32_t period);
+
+/**
+ * @brief Create a disarmed timer on a given clock, O(1)
+ * @details
+ * The identifier is a handle into the timer table, not an address; up to
+ * TIMER_TABLE_MAX timers exist at a time.
+ * CLOCK_MONOTONIC suits timeouts, CLOCK_BOOTTIME too and it also counts
+ * the time suspended. CLOCK_REALTIME suits calendar timers, armed with
+ * TIMER_ABSTIME: when the clock is set they are re-evaluated and elapse
+ * at their time of the new clock, which may be at once. Like in the
+ * kernel, a CLOCK_REALTIME timer armed with a relative time runs on
+ * CLOCK_MONOTONIC: it elapses after that time whichever way the clock is
+ * set.
+ * @param[out] p_timer_id the address where to return the ID of the created timer
+ * @param[in] clock_id CLOCK_REALTIME, CLOCK_MONOTONIC or CLOCK_BOOTTIME
+ * @param[in] p_params the caller params
+ * @param[in] call_back the call-back function pointer that is called once the timer elapses,
+ * on the dispatcher thread, with p_event->p_params set to p_params
+ * @pre[tested] p_timer_id must not be null
+ * @pre[tested] call_back must not be null
+ * @return 0 on success, -1 on failure
+ */
+int TIMER_CreateClockTimer(
+		timer_t* const p_timer_id,
+		const clockid_t clock_id,
+		const void* const p_params,
+		TIMERS_CallBack_FP call_back);
+
+/**
+ * @brief (Re)arm the timer with nanosecond resolution, O(1)
+ * @details
+ * Like timer_settime(2): it_value is the first expiration, relative or
+ * with TIMER_ABSTIME a time of the clock of the timer; all zero disarms
+ * the timer. A non-zero it_interval makes the timer periodic: the next
+ * deadline is the previous one plus the interval, so ticks don't drift,
+ * and ticks that are already past when the timer is serviced are skipped
+ * and counted in p_event->overruns.
+ * The timer elapses at its deadline or up to the latency of the
+ * dispatcher thread later, never earlier. Times of more than some 73
+ * years saturate there, so such a timer never elapses in practice.
+ * @param[in] timer_id the identifier of the timer to load
+ * @param[in] flags 0 or TIMER_ABSTIME
+ * @param[in] p_value the expiration and the period
+ * @pre[tested] p_value must not be null
+ * @return 0 on success, -1 on failure
+ */
+int TIMER_SetTimeSpec(const timer_t timer_id, const int flags, const struct itimerspec* const p_value);
+
+/**
+ * @brief The time left until the timer elapses, and its period
+ * @param[in] timer_id the identifier of the timer
+ * @param[out] p_value it_value all zero when disarmed
+ * @pre[tested] p_value must not be null
+ * @return 0 on success, -1 on failure
+ */
+int TIMER_GetTimeSpec(const timer_t timer_id, struct itimerspec* const p_value);
+
+/**
+ * @brief Let the timer elapse up to slack after its deadline
+ * @details
+ * The dispatcher thread wakes up at the earliest deadline plus slack of
+ * the armed timers and then calls back every timer whose deadline is past,
+ * so timers whose windows overlap share one wakeup. 0, the default, elapses
+ * the timer as soon as possible. Applies to an armed timer at once: the
+ * wakeup of its clock is looked up again, like when a timer elapses.
+ * A slack of more than some 73 years saturates there.
+ * @param[in] timer_id the identifier of the timer
+ * @param[in] p_slack the slack
+ * @pre[tested] p_slack must not be null, nor negative
+ * @return 0 on success, -1 on failure
+ */
+int TIMER_SetSlack(const timer_t timer_id, const struct timespec* const p_slack);
+
+/**
+ * @brief The periods a periodic timer skipped at its last expiration
+ * @details
+ * Like timer_getoverrun(2), the same count as p_event->overruns.
+ * @param[in] timer_id the identifier of the timer
+ * @return the overrun count, 0 for a timer that was on time, -1 on failure
+ */
+int TIMER_GetOverrun(const timer_t timer_id);
+
+/**
+ * @brief Disarm and delete the timer, O(1)
+ * @details
+ * The identifier turns stale: passing it to the TIMER functions later
+ * fails with -1, even once its table entry is reused by a new timer.
  * @param[in, out] timer_id the identifier of the timer to stop and delete
  * @return Error code that confirms that the timer deletion was successful or not.
  */
@@ -13,7 +13,9 @@
  * include section
  * ----------------------------------------------------------------------*/
 /* general includes (unix a.o.) - if possible alphabetically ordered */
-#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 
 /* project specific includes - if possible alphabetically ordered */
 
@@ -23,17 +25,156 @@
  * macro declaration section
  * ----------------------------------------------------------------------*/
 
+#define TIMER_TICK_NS      (1000000L)  /**< Resolution of the timing wheel */
+#define TIMER_WHEEL_BITS   (6)         /**< log2 of the slots per wheel level */
+#define TIMER_WHEEL_SLOTS  (1 << TIMER_WHEEL_BITS)  /**< Slots per wheel level */
+#define TIMER_WHEEL_LEVELS (6)         /**< Levels, each TIMER_WHEEL_SLOTS times coarser */
+
+/** Ticks covered by the wheel, later deadlines are parked on the last level */
+#define TIMER_WHEEL_RANGE  (1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+#define TIMER_CLOCK_COUNT  (3)         /**< Clocks with a wheel: realtime, monotonic, boottime */
+
+#if (UINTPTR_MAX > UINT32_MAX)
+#define TIMER_HANDLE_INDEX_BITS (21)   /**< Bits of a timer_t holding the table index */
+#else
+#define TIMER_HANDLE_INDEX_BITS (16)   /**< Fewer timers, to keep 16 generation bits */
+#endif
+#define TIMER_TABLE_MAX    (1UL << TIMER_HANDLE_INDEX_BITS)  /**< Max number of timers */
+#define TIMER_CHUNK_BITS   (10)        /**< log2 of the timers per table chunk */
+#define TIMER_CHUNK_SIZE   (1UL << TIMER_CHUNK_BITS)  /**< Timers per table chunk */
+#define TIMER_TABLE_CHUNKS (TIMER_TABLE_MAX / TIMER_CHUNK_SIZE)  /**< Max number of chunks */
+
+#define TIMER_HEAP_ARITY   (4)         /**< Children per heap node, a cache line of siblings */
+#define TIMER_HEAP_ALIGN   (64)        /**< Alignment of the heap nodes */
+
 /* ----------------------------------------------------------------------
  * type declaration section
  * ----------------------------------------------------------------------*/
 
+/**
+ * @brief The schedulers that can keep the armed timers of a clock
+ */
+enum TIMER_BACKEND_E {
+	TIMER_BACKEND_WHEEL = 0,  /**< hierarchical timing wheel, O(1), deadlines bucketed in ms ticks (default) */
+	TIMER_BACKEND_HEAP,       /**< 4-ary min-heap of deadlines, O(log n), exact at any range */
+	TIMER_BACKEND_SENTINEL    /**< DO NOT USE */
+};
+
+/**
+ * @brief What a timer call-back is told about the elapsed timer
+ */
+struct TIMER_EVENT_S {
+	timer_t timer_id;        /**< The timer that elapsed */
+	const void* p_params;    /**< The params the timer was created with */
+	uint32_t overruns;       /**< Periods skipped since the previous call, like timer_getoverrun(2) */
+};
+
 /**
  * @brief The IG Timers call-back function pointer type
- * @param[in] sig the signal that triggered the callback
- * @param[in] si the signal information structure
- * @param[in] uc the context (usually not used)
+ * @details
+ * Called on the timer dispatcher thread, as an ordinary function: it may
+ * log, lock, and re-arm or dispose timers. A handler of the former
+ * signal-based signature migrates by reading p_event->p_params where it
+ * read si->si_value.sival_ptr.
+ * @param[in] p_event the elapsed timer, valid during the call
  */
-typedef void (*TIMERS_CallBack_FP) (int sig, siginfo_t *si, void *uc);
+typedef void (*TIMERS_CallBack_FP) (const struct TIMER_EVENT_S* const p_event);
 
-#endif /* if !defined(TIMERS_T_H_INCLUDE) */
+/**
+ * @brief A link of the circular, doubly linked timer lists
+ * @details
+ * A list head points at itself when empty, an unlinked timer likewise.
+ */
+struct TIMER_LINK_S {
+	struct TIMER_LINK_S* p_next;
+	struct TIMER_LINK_S* p_prev;
+};
+
+/**
+ * @brief A timer, an entry of the timer table
+ */
+struct TIMER_S {
+	struct TIMER_LINK_S link;      /**< Links the timer into its slot, or the free list, first member */
+	uint64_t deadline;             /**< When it elapses, in ns since the epoch of its wheel */
+	uint64_t interval;             /**< The period in ns, 0 for a one-shot timer */
+	uint64_t slack;                /**< How much later than the deadline it may elapse, in ns */
+	uint16_t slot;                 /**< The slot it is linked in, TIMER_SLOT_xxx if none */
+	uint8_t clock;                 /**< The wheel of its clock */
+	uint8_t wheel;                 /**< The wheel it is armed on: that of its clock, the monotonic one when relative on the realtime clock */
+	uint32_t index;                /**< Its index in the timer table */
+	uint32_t generation;           /**< Incremented on dispose, part of the timer_t handle */
+	uint32_t overruns;             /**< Periods skipped at the last expiration */
+	uint32_t position;             /**< Its node in the heap of its clock, heap backend */
+	TIMERS_CallBack_FP call_back;  /**< Called once the timer elapses */
+	const void* p_params;          /**< Passed as p_event->p_params */
+};
+
+/**
+ * @brief A node of the timer heap, the deadline kept inline for the compares
+ */
+struct TIMER_HEAP_NODE_S {
+	uint64_t deadline;             /**< The deadline of the timer */
+	struct TIMER_S* p_timer;       /**< The timer, its position is this node */
+};
+
+/**
+ * @brief The 4-ary min-heap of the armed timers of a clock
+ * @details
+ * Node i has its children at TIMER_HEAP_ARITY * i + 1 and up. The nodes
+ * start TIMER_HEAP_ARITY - 1 places into an aligned block, so the siblings
+ * share a cache line. Room for every timer of the clock is reserved when
+ * it is created, so arming a timer never allocates.
+ */
+struct TIMER_HEAP_S {
+	struct TIMER_HEAP_NODE_S* p_block;  /**< The aligned block holding the nodes */
+	uint32_t count;                /**< Armed timers in the heap */
+	uint32_t capacity;             /**< Room for nodes in p_block */
+	uint32_t reserved;             /**< Timers of the clock */
+};
 
+/**
+ * @brief The hierarchical timing wheel
+ * @details
+ * Level l holds the timers due in less than TIMER_WHEEL_SLOTS^(l+1) ticks,
+ * in the slot of bits l*TIMER_WHEEL_BITS and up of their deadline tick.
+ * When the ticks of a level wrap, the next slot of the level above is
+ * cascaded down. The occupied bit masks find the ticks that have work, so
+ * the timerfd is only armed for the next cascade, or for the earliest
+ * deadline plus slack of the timers within reach: ticks bucket the timers,
+ * the deadlines keep nanoseconds.
+ * There is a wheel per clock. With the heap backend the heap replaces the
+ * slots, the rest of the wheel is the same.
+ */
+struct TIMER_WHEEL_S {
+	struct TIMER_LINK_S slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];  /**< The timer lists */
+	uint64_t occupied[TIMER_WHEEL_LEVELS];  /**< Per level, a bit per non-empty slot */
+	struct TIMER_LINK_S expired;   /**< Elapsed timers waiting for their call-back */
+	uint64_t clk;                  /**< The next tick to process */
+	uint64_t armed;                /**< The ns the timerfd is armed for, UINT64_MAX if none */
+	struct timespec epoch;         /**< The time of tick 0 */
+	clockid_t clock_id;            /**< The clock of the wheel */
+	int timer_fd;                  /**< The single timerfd driving the wheel */
+	struct TIMER_HEAP_S heap;      /**< Holds the armed timers instead of the slots, heap backend */
+};
+
+/**
+ * @brief The timer table
+ * @details
+ * A timer_t handle holds the index of its timer in the table in the low
+ * TIMER_HANDLE_INDEX_BITS bits and the generation of the timer above them.
+ * Disposing a timer increments its generation, so stale handles no longer
+ * match. The timers are allocated a chunk at a time and never move; free
+ * ones are kept on a FIFO list, so a disposed timer is reused last.
+ * The generation wraps after 2^(pointer bits - TIMER_HANDLE_INDEX_BITS) - 1
+ * reuses of an entry, 65535 on 32-bit targets: a handle kept that long past
+ * its dispose can match a newer timer again.
+ */
+struct TIMER_TABLE_S {
+	struct TIMER_S* p_chunks[TIMER_TABLE_CHUNKS];  /**< The allocated chunks */
+	struct TIMER_LINK_S free;      /**< The free timers, oldest first */
+	uint32_t allocated;            /**< Timers in the allocated chunks */
+	uint32_t count;                /**< Timers created */
+};
+
+#endif /* if !defined(TIMERS_T_H_INCLUDE) */
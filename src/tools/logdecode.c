@@ -0,0 +1,161 @@
+/**
+ * @file logdecode.c
+ * @brief turns binary log streams (deferred log mode) and compressed log
+ * file segments back into text
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ */
+
+/* -------------------------------------------------------------------------
+ * include section
+ * -------------------------------------------------------------------------*/
+
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* project specific includes - if possible alphabetically ordered */
+#include "../common/argparse.h"
+#include "../common/log.h"
+#include "../common/logfmt.h"
+#include "../common/logz.h"
+
+/* module specific includes - if possible alphabetically ordered */
+
+/**
+ * @brief Size of the rendered line buffer
+ */
+#define LOGDECODE_LINE_SIZE (4096)
+
+static const char* const usages[] = {
+	"logdecode [options] file...",
+	NULL
+};
+
+/**
+ * @brief Decode one binary stream
+ * @param[in] filename the binary stream
+ * @param[in] out the text output
+ * @return 0 on success, other on failure
+ */
+static int LOGDECODE_File(const char* const filename, FILE* const out);
+
+/**
+ * @brief Decompress one compressed log file segment
+ * @param[in] filename the compressed segment (.lz)
+ * @param[in] out the text output
+ * @return 0 on success, other on failure
+ */
+static int LOGDECODE_Unpack(const char* const filename, FILE* const out);
+
+/**
+ * @brief The main function
+ * @param[in] argc the number of command-line arguments
+ * @param[in] argv the pointer to the arguments string collection
+ * @return 0 if all files are decoded, other values if failure
+ */
+int main(int argc, const char **argv)
+{
+	const char* output = NULL;
+	FILE* out = stdout;
+	int unpack = 0;
+	int rv = 0;
+	int i;
+
+	struct argparse_option options[] = {
+		OPT_HELP(),
+		OPT_GROUP("Optional arguments"),
+		OPT_STRING('o', "output", &output, "write the text to this file instead of stdout", NULL, 0, 0),
+		OPT_BOOLEAN('z', "decompress", &unpack, "decompress log file segments (.lz) instead", NULL, 0, 0),
+		OPT_END(),
+	};
+	struct argparse argparse;
+	argparse_init(&argparse, options, usages, 0);
+	argparse_describe(&argparse, "\nDecode binary log streams written in deferred log mode,"
+		"\nor decompress rotated log file segments (-z).",
+		"\nThe text is identical to the console output of the logger.");
+	argc = argparse_parse(&argparse, argc, argv);
+
+	if (0 == argc) {
+		argparse_usage(&argparse);
+		rv = -1;
+	} else if ((NULL != output) && (NULL == (out = fopen(output, "w")))) {
+		fprintf(stderr, "Couldn't open %s: %s\n", output, strerror(errno));
+		rv = -1;
+	} else {
+		for (i = 0; i < argc; i++) {
+			if (0 != (unpack ? LOGDECODE_Unpack(argv[i], out) : LOGDECODE_File(argv[i], out))) {
+				rv = -1;
+			}
+		}
+		if (stdout != out) {
+			fclose(out);
+		}
+	}
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static int LOGDECODE_File(const char* const filename, FILE* const out)
+{
+	struct LOGFMT_READER_S reader;
+	struct LOGFMT_RECORD_S* p_rec;
+	char line[LOGDECODE_LINE_SIZE];
+	FILE* fp;
+	size_t len;
+	int read_res = -1;
+	int rv = -1;
+
+	if (NULL == (fp = fopen(filename, "rb"))) {
+		fprintf(stderr, "Couldn't open %s: %s\n", filename, strerror(errno));
+	} else if (NULL == (p_rec = malloc(sizeof(*p_rec) + UINT16_MAX))) {
+		fprintf(stderr, "Out of memory\n");
+		fclose(fp);
+	} else {
+		if (!LOGFMT_OpenReader(&reader, fp)) {
+			fprintf(stderr, "%s: not a binary log stream of this platform\n", filename);
+		} else {
+			while (1 == (read_res = LOGFMT_ReadRecord(&reader, p_rec))) {
+				len = APPLOG_RenderRecord(line, sizeof(line), p_rec);
+				fwrite(line, 1, len, out);
+			}
+			if (0 > read_res) {
+				fprintf(stderr, "%s: corrupt or truncated stream\n", filename);
+			} else {
+				rv = 0;
+			}
+			LOGFMT_CloseReader(&reader);
+		}
+		free(p_rec);
+		fclose(fp);
+	}
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static int LOGDECODE_Unpack(const char* const filename, FILE* const out)
+{
+	FILE* fp;
+	int unpack_res;
+	int rv = -1;
+
+	if (NULL == (fp = fopen(filename, "rb"))) {
+		fprintf(stderr, "Couldn't open %s: %s\n", filename, strerror(errno));
+	} else {
+		unpack_res = LOGZ_DecompressStream(fp, out);
+
+		if (-1 == unpack_res) {
+			fprintf(stderr, "%s: not a compressed log file segment\n", filename);
+		} else if (0 > unpack_res) {
+			fprintf(stderr, "%s: corrupt or truncated segment\n", filename);
+		} else {
+			rv = 0;
+		}
+		fclose(fp);
+	}
+	return rv;
+}
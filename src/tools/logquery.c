@@ -0,0 +1,541 @@
+/**
+ * @file logquery.c
+ * @brief extracts the lines of a time range and levels from log file
+ * segments, using their indexes
+ * @code{.ebp}
+ * format: 1TBS
+ * rules:
+ * @endcode
+ * @details
+ * A segment and its index (LOG_FILE_INDEX_LINES) are mapped; two binary
+ * searches over the marks (max_ms for the start, floor_ms for the end)
+ * bound the spans that may hold the range, only those are read. A
+ * compressed segment (.lz) is decompressed block by block, only the blocks
+ * of the spans. A segment without an index is read completely.
+ */
+
+/* -------------------------------------------------------------------------
+ * include section
+ * -------------------------------------------------------------------------*/
+
+/* general includes (unix a.o.) - if possible alphabetically ordered */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* project specific includes - if possible alphabetically ordered */
+#include "../common/argparse.h"
+#include "../common/log.h"
+#include "../common/logfile.h"
+#include "../common/logtime.h"
+#include "../common/logz.h"
+
+/* module specific includes - if possible alphabetically ordered */
+
+/**
+ * @brief Size of a file name: a segment name and the index suffix
+ */
+#define LOGQUERY_NAME_SIZE (LOGFILE_PATH_SIZE + 32)
+
+/**
+ * @brief Every level
+ */
+#define LOGQUERY_ALL_LEVELS (LOGLV_SENTINEL - 1)
+
+/**
+ * @brief A mapped segment and its index
+ */
+struct LOGQUERY_SEGMENT_S {
+	const char* name;                     /**< The segment file */
+	const uint8_t* p_map;                 /**< Its mapping */
+	size_t size;                          /**< Its size (bytes) */
+	const struct LOGFILE_INDEX_S* p_index;/**< The mapping of its index, NULL if none */
+	size_t index_size;                    /**< Size of the index mapping (bytes) */
+	const struct LOGFILE_MARK_S* p_marks; /**< The marks of the index */
+	uint32_t count;                       /**< Number of marks */
+	int64_t* p_floors;                    /**< Open index: the floors, NULL if sealed */
+	bool packed;                          /**< Compressed (.lz) */
+	uint8_t* p_buf;                       /**< Compressed: the decompressed blocks */
+	size_t buf_size;                      /**< Size of p_buf (bytes) */
+};
+
+/**
+ * @brief The query
+ */
+struct LOGQUERY_QUERY_S {
+	int64_t from_ms;   /**< Earliest timestamp (ms since the epoch) */
+	int64_t to_ms;     /**< Latest timestamp (ms since the epoch) */
+	uint64_t levels;   /**< LOGLV_xxx bits of the lines */
+	FILE* out;         /**< The text output */
+	uint64_t lines;    /**< Lines written */
+	uint64_t scanned;  /**< Bytes read */
+	uint64_t marks;    /**< Marks searched */
+};
+
+/**
+ * @brief The level names of the lines, in LOGLV_xxx bit order
+ */
+static const char* const LOGQUERY_level_names[] = {
+	"INFO", "DEBUG", "WARNING", "ERROR", "CRITICAL", "TEST"
+};
+
+static const char* const usages[] = {
+	"logquery [options] segment...",
+	NULL
+};
+
+/**
+ * @brief Read a time option
+ * @param[in] text "YYYY-MM-DD HH:MM:SS[.mmm]", NULL for none
+ * @param[in] end true for the end of the range: a time without ms takes
+ * the whole second
+ * @param[in, out] p_ms the time in ms since the epoch, unchanged for none
+ * @return true on success, false if text isn't a time
+ */
+static bool LOGQUERY_Time(const char* const text, const bool end, int64_t* const p_ms);
+
+/**
+ * @brief Map a segment and its index
+ * @param[out] p_seg the segment
+ * @param[in] name the segment file
+ * @return true on success, false otherwise
+ */
+static bool LOGQUERY_Open(struct LOGQUERY_SEGMENT_S* const p_seg, const char* const name);
+
+/**
+ * @brief Unmap a segment and its index
+ * @param[in, out] p_seg the segment
+ */
+static void LOGQUERY_Close(struct LOGQUERY_SEGMENT_S* const p_seg);
+
+/**
+ * @brief Write the lines of the query held by a segment
+ * @param[in, out] p_seg the segment
+ * @param[in, out] p_query the query
+ * @return 0 on success, other on failure
+ */
+static int LOGQUERY_Segment(struct LOGQUERY_SEGMENT_S* const p_seg, struct LOGQUERY_QUERY_S* const p_query);
+
+/**
+ * @brief Get the bytes of a part of a segment
+ * @param[in, out] p_seg the segment
+ * @param[in] start the offset of the part
+ * @param[in] end the offset past the part, SIZE_MAX for the end of the
+ * segment
+ * @param[out] p_len the number of bytes
+ * @return the bytes, NULL if the segment is corrupt
+ */
+static const char* LOGQUERY_Bytes(struct LOGQUERY_SEGMENT_S* const p_seg, const size_t start, const size_t end, size_t* const p_len);
+
+/**
+ * @brief Write the lines of the query held by a part of a segment
+ * @param[in] text the part, whole lines
+ * @param[in] len the number of bytes
+ * @param[in, out] p_query the query
+ */
+static void LOGQUERY_Scan(const char* const text, const size_t len, struct LOGQUERY_QUERY_S* const p_query);
+
+/**
+ * @brief Read the level of a line
+ * @param[in] line the line, after its timestamp
+ * @param[in] len the number of characters
+ * @return the LOGLV_xxx level, LOGQUERY_ALL_LEVELS if unknown
+ */
+static uint64_t LOGQUERY_LineLevel(const char* const line, const size_t len);
+
+/**
+ * @brief The main function
+ * @param[in] argc the number of command-line arguments
+ * @param[in] argv the pointer to the arguments string collection
+ * @return 0 if all segments are read, other values if failure
+ */
+int main(int argc, const char **argv)
+{
+	struct LOGQUERY_QUERY_S query;
+	struct LOGQUERY_SEGMENT_S seg;
+	struct timespec start;
+	struct timespec end;
+	const char* from = NULL;
+	const char* to = NULL;
+	const char* output = NULL;
+	int levels = LOGQUERY_ALL_LEVELS;
+	int stats = 0;
+	int rv = 0;
+	int i;
+
+	struct argparse_option options[] = {
+		OPT_HELP(),
+		OPT_GROUP("Optional arguments"),
+		OPT_STRING('f', "from", &from, "earliest time, \"YYYY-MM-DD HH:MM:SS[.mmm]\"", NULL, 0, 0),
+		OPT_STRING('t', "to", &to, "latest time, \"YYYY-MM-DD HH:MM:SS[.mmm]\"", NULL, 0, 0),
+		OPT_INTEGER('l', "levels", &levels, "LOGLV_xxx bits of the lines (decimal)", NULL, 0, 0),
+		OPT_STRING('o', "output", &output, "write the lines to this file instead of stdout", NULL, 0, 0),
+		OPT_BOOLEAN('s', "stats", &stats, "report the marks searched, bytes read and time taken to stderr", NULL, 0, 0),
+		OPT_END(),
+	};
+	struct argparse argparse;
+	argparse_init(&argparse, options, usages, 0);
+	argparse_describe(&argparse, "\nWrite the lines of a time range and levels held by log file segments"
+		"\n(path.N, path.N.lz, path), oldest segment first.",
+		"\nThe segment indexes (path.N.idx, LOG_FILE_INDEX_LINES) limit the bytes read.");
+	argc = argparse_parse(&argparse, argc, argv);
+
+	memset(&query, 0, sizeof(query));
+	query.from_ms = INT64_MIN;
+	query.to_ms = INT64_MAX;
+	query.levels = (uint64_t)levels;
+	query.out = stdout;
+
+	if ((0 == argc) || (0 >= levels)) {
+		argparse_usage(&argparse);
+		rv = -1;
+	} else if (!LOGQUERY_Time(from, false, &query.from_ms) || !LOGQUERY_Time(to, true, &query.to_ms)) {
+		fprintf(stderr, "Times are \"YYYY-MM-DD HH:MM:SS[.mmm]\" (local time)\n");
+		rv = -1;
+	} else if ((NULL != output) && (NULL == (query.out = fopen(output, "w")))) {
+		fprintf(stderr, "Couldn't open %s: %s\n", output, strerror(errno));
+		rv = -1;
+	} else {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		for (i = 0; i < argc; i++) {
+			if (!LOGQUERY_Open(&seg, argv[i])) {
+				rv = -1;
+			} else {
+				if (0 != LOGQUERY_Segment(&seg, &query)) {
+					rv = -1;
+				}
+				LOGQUERY_Close(&seg);
+			}
+		}
+		fflush(query.out);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		if (stats) {
+			fprintf(stderr, "%llu lines, %llu marks searched, %llu bytes read, %.3f ms\n",
+					(unsigned long long)query.lines, (unsigned long long)query.marks, (unsigned long long)query.scanned,
+					((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec)) / 1e6);
+		}
+		if (stdout != query.out) {
+			fclose(query.out);
+		}
+	}
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static bool LOGQUERY_Time(const char* const text, const bool end, int64_t* const p_ms)
+{
+	size_t len;
+	size_t parsed;
+	bool rv = true;
+
+	if (NULL != text) {
+		len = strlen(text);
+		parsed = LOGTIME_Parse(text, len, p_ms);
+
+		if ((0 == parsed) || (len != parsed)) {
+			rv = false;
+		} else if (end && (LOGTIME_STR_LEN != parsed)) {
+			*p_ms += 999;
+		}
+	}
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static bool LOGQUERY_Open(struct LOGQUERY_SEGMENT_S* const p_seg, const char* const name)
+{
+	const struct LOGFILE_INDEX_S* p_index;
+	char index_name[LOGQUERY_NAME_SIZE];
+	struct stat st;
+	void* p_map;
+	size_t len = strlen(name);
+	int64_t floor_ms = INT64_MAX;
+	uint32_t i;
+	int fd;
+	bool rv = false;
+
+	memset(p_seg, 0, sizeof(*p_seg));
+	p_seg->name = name;
+	p_seg->packed = (3 <= len) && (0 == strcmp(name + len - 3, ".lz"));
+
+	if (0 > (fd = open(name, O_RDONLY | O_CLOEXEC))) {
+		fprintf(stderr, "Couldn't open %s: %s\n", name, strerror(errno));
+	} else {
+		if (0 > fstat(fd, &st)) {
+			fprintf(stderr, "Couldn't stat %s: %s\n", name, strerror(errno));
+		} else if (0 == st.st_size) {
+			rv = true;
+		} else if (MAP_FAILED == (p_map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0))) {
+			fprintf(stderr, "Couldn't map %s: %s\n", name, strerror(errno));
+		} else {
+			p_seg->p_map = p_map;
+			p_seg->size = st.st_size;
+			rv = true;
+		}
+		close(fd);
+	}
+
+	if (rv && (NULL != p_seg->p_map)) {
+		if (p_seg->packed && ((LOGZ_MAGIC_SIZE > p_seg->size) || (0 != memcmp(p_seg->p_map, LOGZ_MAGIC, LOGZ_MAGIC_SIZE)))) {
+			fprintf(stderr, "%s: not a compressed log file segment\n", name);
+			rv = false;
+		}
+		snprintf(index_name, sizeof(index_name), "%s%s", name, LOGFILE_INDEX_SUFFIX);
+
+		/* no index: the segment is read completely */
+		if (rv && (0 <= (fd = open(index_name, O_RDONLY | O_CLOEXEC)))) {
+			if ((0 == fstat(fd, &st)) && ((size_t)st.st_size >= sizeof(*p_index))
+					&& (MAP_FAILED != (p_map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)))) {
+				p_index = p_map;
+				p_seg->index_size = st.st_size;
+
+				if ((0 != memcmp(p_index->magic, LOGFILE_INDEX_MAGIC, sizeof(p_index->magic)))
+						|| ((size_t)st.st_size < sizeof(*p_index) + (size_t)p_index->count * sizeof(struct LOGFILE_MARK_S))) {
+					fprintf(stderr, "%s: corrupt index, reading the segment completely\n", index_name);
+					munmap(p_map, st.st_size);
+				} else {
+					p_seg->p_index = p_index;
+					p_seg->p_marks = (const struct LOGFILE_MARK_S*)(p_index + 1);
+					p_seg->count = p_index->count;
+				}
+			}
+			close(fd);
+		}
+
+		/* the index of the active segment isn't sealed yet: compute the floors */
+		if (rv && (NULL != p_seg->p_index) && !p_seg->p_index->sealed && (0 < p_seg->count)) {
+			if (NULL == (p_seg->p_floors = malloc(p_seg->count * sizeof(*p_seg->p_floors)))) {
+				fprintf(stderr, "Out of memory\n");
+				rv = false;
+			} else {
+				for (i = p_seg->count; i > 0; i--) {
+					if (p_seg->p_marks[i - 1].min_ms < floor_ms) {
+						floor_ms = p_seg->p_marks[i - 1].min_ms;
+					}
+					p_seg->p_floors[i - 1] = floor_ms;
+				}
+			}
+		}
+	}
+
+	if (!rv) {
+		LOGQUERY_Close(p_seg);
+	}
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static void LOGQUERY_Close(struct LOGQUERY_SEGMENT_S* const p_seg)
+{
+	if (NULL != p_seg->p_map) {
+		munmap((void*)p_seg->p_map, p_seg->size);
+	}
+	if (NULL != p_seg->p_index) {
+		munmap((void*)p_seg->p_index, p_seg->index_size);
+	}
+	free(p_seg->p_floors);
+	free(p_seg->p_buf);
+	memset(p_seg, 0, sizeof(*p_seg));
+}
+
+/* ------------------------------------------------------------------------- */
+static int LOGQUERY_Segment(struct LOGQUERY_SEGMENT_S* const p_seg, struct LOGQUERY_QUERY_S* const p_query)
+{
+	const struct LOGFILE_MARK_S* p_marks = p_seg->p_marks;
+	const char* text;
+	size_t start;
+	size_t end;
+	size_t len;
+	uint32_t low;
+	uint32_t high;
+	uint32_t mid;
+	uint32_t first;
+	uint32_t last;
+	uint32_t i;
+	int rv = 0;
+
+	if (NULL == p_seg->p_map) {
+		/* empty */
+	} else if (NULL == p_seg->p_index) {
+		if (NULL == (text = LOGQUERY_Bytes(p_seg, 0, SIZE_MAX, &len))) {
+			rv = -1;
+		} else {
+			LOGQUERY_Scan(text, len, p_query);
+		}
+	} else {
+		/* the first mark with a line at or after from_ms: max_ms ascends */
+		for (low = 0, high = p_seg->count; low < high; p_query->marks++) {
+			mid = low + (high - low) / 2;
+			if (p_marks[mid].max_ms < p_query->from_ms) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		first = low;
+
+		/* the first mark without a line at or before to_ms: floor_ms ascends */
+		for (high = p_seg->count; low < high; p_query->marks++) {
+			mid = low + (high - low) / 2;
+			if (((NULL != p_seg->p_floors) ? p_seg->p_floors[mid] : p_marks[mid].floor_ms) <= p_query->to_ms) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		last = low;
+
+		/* read the spans of the levels, adjacent ones at once */
+		for (i = first; (i < last) && (0 == rv); i++) {
+			if ((0 == (p_marks[i].levels & p_query->levels)) || (p_marks[i].min_ms > p_query->to_ms)) {
+				continue;
+			}
+			start = p_marks[i].offset;
+			while ((i + 1 < last) && (0 != (p_marks[i + 1].levels & p_query->levels)) && (p_marks[i + 1].min_ms <= p_query->to_ms)) {
+				i++;
+			}
+			end = (i + 1 < p_seg->count) ? p_marks[i + 1].offset : SIZE_MAX;
+
+			if (NULL == (text = LOGQUERY_Bytes(p_seg, start, end, &len))) {
+				rv = -1;
+			} else {
+				LOGQUERY_Scan(text, len, p_query);
+			}
+		}
+	}
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static const char* LOGQUERY_Bytes(struct LOGQUERY_SEGMENT_S* const p_seg, const size_t start, const size_t end, size_t* const p_len)
+{
+	struct LOGZ_BLOCK_S block;
+	const char* rv = NULL;
+	uint8_t* p_buf;
+	size_t pos = LOGZ_MAGIC_SIZE;
+	size_t raw = 0;
+	size_t first = start;
+	size_t used = 0;
+	bool ok = true;
+
+	if (!p_seg->packed) {
+		if (start <= p_seg->size) {
+			rv = (const char*)p_seg->p_map + start;
+			*p_len = ((end < p_seg->size) ? end : p_seg->size) - start;
+		}
+	} else {
+		/* walk the block headers, decompress the blocks holding [start, end) */
+		while (ok && (raw < end) && (pos < p_seg->size)) {
+			ok = (sizeof(block) <= p_seg->size - pos);
+			if (ok) {
+				memcpy(&block, p_seg->p_map + pos, sizeof(block));
+				pos += sizeof(block);
+				ok = (LOGZ_BLOCK_SIZE >= block.raw_len) && (block.packed_len <= block.raw_len)
+						&& (block.packed_len <= p_seg->size - pos);
+			}
+			if (ok && (raw + block.raw_len > start)) {
+				if (0 == used) {
+					first = raw;
+				}
+				if (p_seg->buf_size < used + block.raw_len) {
+					if (NULL == (p_buf = realloc(p_seg->p_buf, used + LOGZ_BLOCK_SIZE))) {
+						fprintf(stderr, "Out of memory\n");
+						ok = false;
+					} else {
+						p_seg->p_buf = p_buf;
+						p_seg->buf_size = used + LOGZ_BLOCK_SIZE;
+					}
+				}
+				if (!ok) {
+					/* reported */
+				} else if (block.packed_len == block.raw_len) {
+					memcpy(p_seg->p_buf + used, p_seg->p_map + pos, block.raw_len);
+				} else {
+					ok = LOGZ_DecompressBlock(p_seg->p_map + pos, block.packed_len, p_seg->p_buf + used, block.raw_len);
+				}
+				used += block.raw_len;
+			}
+			if (ok) {
+				pos += block.packed_len;
+				raw += block.raw_len;
+			}
+		}
+
+		if (!ok) {
+			fprintf(stderr, "%s: corrupt or truncated segment\n", p_seg->name);
+		} else if (start >= first + used) {
+			rv = "";
+			*p_len = 0;
+		} else {
+			rv = (const char*)p_seg->p_buf + (start - first);
+			*p_len = ((end < first + used) ? end : first + used) - start;
+		}
+	}
+	return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+static void LOGQUERY_Scan(const char* const text, const size_t len, struct LOGQUERY_QUERY_S* const p_query)
+{
+	const char* line = text;
+	const char* text_end = text + len;
+	const char* line_end;
+	size_t parsed;
+	int64_t ms;
+
+	p_query->scanned += len;
+
+	/* the active segment is zero past its end */
+	while ((line < text_end) && ('\0' != *line)) {
+		line_end = memchr(line, '\n', text_end - line);
+		line_end = (NULL == line_end) ? text_end : line_end + 1;
+		parsed = LOGTIME_Parse(line, line_end - line, &ms);
+
+		if ((0 < parsed) && (ms >= p_query->from_ms) && (ms <= p_query->to_ms)
+				&& ((LOGQUERY_ALL_LEVELS == (p_query->levels & LOGQUERY_ALL_LEVELS))
+					|| (0 != (LOGQUERY_LineLevel(line + parsed, line_end - line - parsed) & p_query->levels)))) {
+			fwrite(line, 1, line_end - line, p_query->out);
+			p_query->lines++;
+		}
+		line = line_end;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+static uint64_t LOGQUERY_LineLevel(const char* const line, const size_t len)
+{
+	const char* p = line;
+	const char* end = line + len;
+	size_t name_len;
+	uint64_t rv = LOGQUERY_ALL_LEVELS;
+	size_t i;
+
+	/* ") [" + optional color + name + ... */
+	if ((3 <= len) && (0 == memcmp(p, ") [", 3))) {
+		p += 3;
+		if ((p < end) && ('\033' == *p)) {
+			while ((p < end) && ('m' != *p)) {
+				p++;
+			}
+			p += (p < end) ? 1 : 0;
+		}
+		for (i = 0; i < sizeof(LOGQUERY_level_names) / sizeof(LOGQUERY_level_names[0]); i++) {
+			name_len = strlen(LOGQUERY_level_names[i]);
+			if ((name_len < (size_t)(end - p)) && (0 == memcmp(p, LOGQUERY_level_names[i], name_len))
+					&& (('\033' == p[name_len]) || (']' == p[name_len]))) {
+				rv = 1ULL << i;
+				break;
+			}
+		}
+	}
+	return rv;
+}